@@ -163,6 +163,7 @@ DEFINE_SAFE_EQUALITY(EventUsage)
 DEFINE_SAFE_EQUALITY(PathEntry)
 DEFINE_SAFE_EQUALITY(PixelModification)
 DEFINE_SAFE_EQUALITY(ResourceDescription)
+DEFINE_SAFE_EQUALITY(ResourceEventUsage)
 DEFINE_SAFE_EQUALITY(ResourceId)
 DEFINE_SAFE_EQUALITY(LineColumnInfo)
 DEFINE_SAFE_EQUALITY(ShaderCompileFlag)
@@ -905,6 +905,7 @@ void CaptureDialog::SetSettings(CaptureSettings settings)
   ui->APIValidation->setChecked(settings.options.apiValidation);
   ui->RefAllResources->setChecked(settings.options.refAllResources);
   ui->CaptureAllCmdLists->setChecked(settings.options.captureAllCmdLists);
+  ui->CombineMultiFrameCaptures->setChecked(settings.options.combineMultiFrameCaptures);
   ui->DelayForDebugger->setValue(settings.options.delayForDebugger);
   ui->VerifyBufferAccess->setChecked(settings.options.verifyBufferAccess);
   ui->AutoStart->setChecked(settings.autoStart);
@@ -953,6 +954,7 @@ CaptureSettings CaptureDialog::Settings()
   ret.options.apiValidation = ui->APIValidation->isChecked();
   ret.options.refAllResources = ui->RefAllResources->isChecked();
   ret.options.captureAllCmdLists = ui->CaptureAllCmdLists->isChecked();
+  ret.options.combineMultiFrameCaptures = ui->CombineMultiFrameCaptures->isChecked();
   ret.options.delayForDebugger = (uint32_t)ui->DelayForDebugger->value();
   ret.options.verifyBufferAccess = ui->VerifyBufferAccess->isChecked();
 
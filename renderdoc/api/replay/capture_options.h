@@ -199,6 +199,21 @@ Default - enabled
 ``False`` - API debugging is displayed as normal.
 )");
   bool debugOutputMute;
+
+  DOCUMENT(R"(When several consecutive frames are captured, e.g. by triggering a multi-frame
+capture or queueing a range of frames, record them all into a single capture instead of one capture
+per frame.
+
+Initial contents are then only prepared and stored once, and later frames are recorded as a
+continuation of the first. Each frame boundary is marked in the capture where the API allows it.
+
+Default - disabled
+
+``True`` - Consecutive frames are captured together into one capture.
+
+``False`` - Each frame is captured separately.
+)");
+  bool combineMultiFrameCaptures;
 };
 
 DECLARE_REFLECTION_STRUCT(CaptureOptions);
@@ -1143,6 +1143,46 @@ struct EventUsage
 
 DECLARE_REFLECTION_STRUCT(EventUsage);
 
+DOCUMENT(R"(Describes a particular use of a resource at a specific
+:data:`eventId <APIEvent.eventId>`, along with which resource was used.
+)");
+struct ResourceEventUsage
+{
+  DOCUMENT("");
+  ResourceEventUsage() : eventId(0), usage(ResourceUsage::Unused) {}
+  ResourceEventUsage(const ResourceEventUsage &) = default;
+  ResourceEventUsage(ResourceId r, const EventUsage &u)
+      : resourceId(r), eventId(u.eventId), usage(u.usage), view(u.view)
+  {
+  }
+  bool operator<(const ResourceEventUsage &o) const
+  {
+    if(!(eventId == o.eventId))
+      return eventId < o.eventId;
+    if(!(resourceId == o.resourceId))
+      return resourceId < o.resourceId;
+    return usage < o.usage;
+  }
+
+  bool operator==(const ResourceEventUsage &o) const
+  {
+    return resourceId == o.resourceId && eventId == o.eventId && usage == o.usage;
+  }
+  DOCUMENT("The :class:`ResourceId` of the resource that was used.");
+  ResourceId resourceId;
+
+  DOCUMENT("The :data:`eventId <APIEvent.eventId>` where this usage happened.");
+  uint32_t eventId;
+
+  DOCUMENT("The :class:`ResourceUsage` in question.");
+  ResourceUsage usage;
+
+  DOCUMENT("An optional :class:`ResourceId` identifying the view through which the use happened.");
+  ResourceId view;
+};
+
+DECLARE_REFLECTION_STRUCT(ResourceEventUsage);
+
 DOCUMENT("Describes the properties of a drawcall, dispatch, debug marker, or similar event.");
 struct DrawcallDescription
 {
@@ -1267,6 +1267,24 @@ only ever have one result (only one entry point per shader).
 )");
   virtual rdcarray<EventUsage> GetUsage(ResourceId id) = 0;
 
+  DOCUMENT(R"(Retrieve the usage of several resources at once.
+
+:param list ids: The list of :class:`ResourceId` of the texture or buffer resources to be queried.
+:return: The usages of all of the resources, grouped by resource in the order given and sorted by
+  event within each resource.
+:rtype: ``list`` of :class:`ResourceEventUsage`
+)");
+  virtual rdcarray<ResourceEventUsage> GetUsages(const rdcarray<ResourceId> &ids) = 0;
+
+  DOCUMENT(R"(Retrieve every use of any resource within a range of events.
+
+:param int startEventId: The first :data:`eventId <APIEvent.eventId>` to include.
+:param int endEventId: The last :data:`eventId <APIEvent.eventId>` to include.
+:return: The list of usages within the range, sorted by event.
+:rtype: ``list`` of :class:`ResourceEventUsage`
+)");
+  virtual rdcarray<ResourceEventUsage> GetEventUsage(uint32_t startEventId, uint32_t endEventId) = 0;
+
   DOCUMENT(R"(Retrieve the contents of a constant block by reading from memory or their source
 otherwise.
 
@@ -83,6 +83,13 @@ version of RenderDoc that addes a new section type. They should be considered eq
   lossless.
 
   The name for this section will be "renderdoc/internal/exthumb".
+
+.. data:: CallstackTable
+
+  This section contains the deduplicated table of callstacks referenced by chunks in the frame
+  capture, when callstacks were captured.
+
+  The name for this section will be "renderdoc/internal/callstacks".
 )");
 enum class SectionType : uint32_t
 {
@@ -95,6 +102,7 @@ enum class SectionType : uint32_t
   ResourceRenames,
   AMDRGPProfile,
   ExtendedThumbnail,
+  CallstackTable,
   Count,
 };
 
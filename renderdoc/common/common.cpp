@@ -31,6 +31,11 @@
 #include "os/os_specific.h"
 #include "strings/string_utils.h"
 
+#if ENABLED(RDOC_POSIX)
+#include <pthread.h>
+#include <signal.h>
+#endif
+
 //	for(int i=0; i < 256; i++)
 //	{
 //		uint8_t comp = i&0xff;
@@ -222,6 +227,58 @@ bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &
   return diffStart < bufSize;
 }
 
+static bool IsZeroRange(const byte *data, uint64_t size)
+{
+  uint64_t accum = 0;
+  uint64_t i = 0;
+
+  // OR together four words at a time, which the compiler turns into vector ORs. We only check the
+  // result once per call since almost all ranges are entirely zero or non-zero near the start.
+  for(; i + 32 <= size; i += 32)
+  {
+    uint64_t words[4];
+    memcpy(words, data + i, sizeof(words));
+    accum |= words[0] | words[1] | words[2] | words[3];
+  }
+
+  for(; i < size; i++)
+    accum |= data[i];
+
+  return accum == 0;
+}
+
+void FindNonZeroRanges(const byte *data, uint64_t size, uint64_t pageSize,
+                       std::vector<uint64_t> &ranges)
+{
+  ranges.clear();
+
+  uint64_t rangeStart = 0;
+  bool inRange = false;
+
+  for(uint64_t offs = 0; offs < size; offs += pageSize)
+  {
+    bool zero = IsZeroRange(data + offs, RDCMIN(pageSize, size - offs));
+
+    if(!zero && !inRange)
+    {
+      rangeStart = offs;
+      inRange = true;
+    }
+    else if(zero && inRange)
+    {
+      ranges.push_back(rangeStart);
+      ranges.push_back(offs - rangeStart);
+      inRange = false;
+    }
+  }
+
+  if(inRange)
+  {
+    ranges.push_back(rangeStart);
+    ranges.push_back(size - rangeStart);
+  }
+}
+
 uint32_t CalcNumMips(int w, int h, int d)
 {
   int mipLevels = 1;
@@ -295,6 +352,260 @@ uint64_t Log2Floor(uint64_t value)
 static std::string logfile;
 static bool logfileOpened = false;
 
+static bool log_output_enabled = false;
+
+// Log messages are pushed into a fixed-size multi-producer queue by whichever thread logs them, and
+// written out in order by a background thread. This keeps threads that log heavily from
+// serialising on each other and on the file I/O. The queue is a bounded ring where each cell
+// carries a sequence number that says whether it's ready to be written or read for a given
+// position, so producers only need to atomically claim a position.
+//
+// The sequence numbers are stored relative to the cell index so that the zero-initialised queue is
+// valid, since logging can happen before any static constructors have run.
+struct LogQueueCell
+{
+  volatile int32_t seq;
+  LogType type;
+  // fullMsg and msg packed one after the other, allocated by the producer and freed after writing
+  char *data;
+  size_t msgOffset;
+};
+
+static const int32_t logQueueSize = 4096;
+static LogQueueCell logQueue[logQueueSize];
+static volatile int32_t logQueueWritePos = 0;
+static volatile int32_t logQueueReadPos = 0;
+
+static volatile int32_t logFlushThreadShutdown = 0;
+static volatile int32_t logFlushThreadRunning = 0;
+static Threading::ThreadHandle logFlushThread = 0;
+
+// the flush thread sleeps on this when the queue is empty. Producers only wake it while it's
+// advertised that it's waiting, so logging doesn't pay for a wake on every message.
+static Threading::Semaphore *logFlushWake = NULL;
+static volatile int32_t logFlushThreadWaiting = 0;
+
+// the consumer side is only ever accessed with this lock held, either by the background thread or
+// by a thread that needs the log flushed immediately.
+static Threading::CriticalSection &LogWriteLock()
+{
+  static Threading::CriticalSection lock;
+  return lock;
+}
+
+// full barrier load, Atomic has no plain load and volatile doesn't order the surrounding accesses
+static int32_t LogQueueLoad(volatile int32_t *val)
+{
+  return Atomic::CmpExch32(val, 0, 0);
+}
+
+static void rdclog_write(LogType type, const char *fullMsg, const char *msg)
+{
+#if ENABLED(OUTPUT_LOG_TO_DEBUG_OUT)
+  OSUtility::WriteOutput(OSUtility::Output_DebugMon, fullMsg);
+#endif
+#if ENABLED(OUTPUT_LOG_TO_STDOUT)
+  // don't output debug messages to stdout/stderr
+  if(type != LogType::Debug && log_output_enabled)
+    OSUtility::WriteOutput(OSUtility::Output_StdOut, msg);
+#endif
+#if ENABLED(OUTPUT_LOG_TO_STDERR)
+  // don't output debug messages to stdout/stderr
+  if(type != LogType::Debug && log_output_enabled)
+    OSUtility::WriteOutput(OSUtility::Output_StdErr, msg);
+#endif
+#if ENABLED(OUTPUT_LOG_TO_DISK)
+  if(logfileOpened)
+  {
+    // strlen used as byte length - str is UTF-8 so this is NOT number of characters
+    FileIO::logfile_append(fullMsg, strlen(fullMsg));
+  }
+#endif
+}
+
+// must be called with LogWriteLock() held. Writes everything that's been fully pushed, stopping at
+// the first cell a producer is still filling in so that ordering is preserved.
+static void rdclog_drain()
+{
+  for(;;)
+  {
+    int32_t pos = logQueueReadPos;
+    int32_t idx = pos & (logQueueSize - 1);
+    LogQueueCell &cell = logQueue[idx];
+
+    if(LogQueueLoad(&cell.seq) != pos + 1 - idx)
+      return;
+
+    rdclog_write(cell.type, cell.data, cell.data + cell.msgOffset);
+
+    delete[] cell.data;
+    cell.data = NULL;
+
+    logQueueReadPos = pos + 1;
+
+    // release the cell for the producer one lap around the ring
+    Atomic::CmpExch32(&cell.seq, pos + 1 - idx, pos + logQueueSize - idx);
+  }
+}
+
+// whether the next cell to be written has been pushed. Only a hint when called without the lock.
+static bool rdclog_pending()
+{
+  int32_t pos = logQueueReadPos;
+  int32_t idx = pos & (logQueueSize - 1);
+  return LogQueueLoad(&logQueue[idx].seq) == pos + 1 - idx;
+}
+
+static void rdclog_flushthread()
+{
+  Atomic::Inc32(&logFlushThreadRunning);
+
+  while(LogQueueLoad(&logFlushThreadShutdown) == 0)
+  {
+    {
+      SCOPED_LOCK(LogWriteLock());
+      rdclog_drain();
+    }
+
+    Atomic::CmpExch32(&logFlushThreadWaiting, 0, 1);
+
+    // check again once we've advertised that we're waiting, since a producer that pushed before it
+    // could see the flag won't have woken us. The timeout is only a backstop.
+    if(!rdclog_pending() && LogQueueLoad(&logFlushThreadShutdown) == 0)
+      logFlushWake->WaitForWake(100);
+
+    Atomic::CmpExch32(&logFlushThreadWaiting, 1, 0);
+  }
+
+  Atomic::Dec32(&logFlushThreadRunning);
+}
+
+#if ENABLED(RDOC_POSIX)
+
+// a child forked without exec inherits our state but not the flush thread, so fall back to
+// writing synchronously there. The write lock is held across the fork so that it can't be
+// inherited mid-drain.
+static void rdclog_prefork()
+{
+  LogWriteLock().Lock();
+}
+
+static void rdclog_postfork_parent()
+{
+  LogWriteLock().Unlock();
+}
+
+static void rdclog_postfork_child()
+{
+  logFlushThread = 0;
+  logFlushThreadRunning = 0;
+  logFlushThreadShutdown = 0;
+  logFlushThreadWaiting = 0;
+  // the semaphore may have been mid-use by a thread that doesn't exist here, leak it and make a
+  // fresh one if the thread is ever started again
+  logFlushWake = NULL;
+
+  LogWriteLock().Unlock();
+}
+
+// posix has no crash handler that could flush the log for us, so catch fatal signals, write out
+// anything still queued, then pass the signal on to whatever handled it before.
+static const int logCrashSignals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+static struct sigaction logCrashPrevActions[ARRAY_COUNT(logCrashSignals)];
+static volatile int32_t logCrashDrained = 0;
+
+static void rdclog_crashsignal(int signum, siginfo_t *info, void *context)
+{
+  // only try once, and never wait on the lock - another thread may hold it and never return
+  if(Atomic::CmpExch32(&logCrashDrained, 0, 1) == 0 && LogWriteLock().Trylock())
+  {
+    rdclog_drain();
+    LogWriteLock().Unlock();
+  }
+
+  for(size_t i = 0; i < ARRAY_COUNT(logCrashSignals); i++)
+  {
+    if(logCrashSignals[i] != signum)
+      continue;
+
+    struct sigaction &prev = logCrashPrevActions[i];
+
+    if(prev.sa_flags & SA_SIGINFO)
+    {
+      prev.sa_sigaction(signum, info, context);
+    }
+    else if(prev.sa_handler != SIG_DFL && prev.sa_handler != SIG_IGN)
+    {
+      prev.sa_handler(signum);
+    }
+    else
+    {
+      // restore the default and re-raise, it's delivered as soon as this handler returns
+      sigaction(signum, &prev, NULL);
+      raise(signum);
+    }
+    return;
+  }
+}
+
+static void rdclog_installprocesshooks()
+{
+  static bool installed = false;
+  if(installed)
+    return;
+  installed = true;
+
+  pthread_atfork(&rdclog_prefork, &rdclog_postfork_parent, &rdclog_postfork_child);
+
+  struct sigaction action = {};
+  action.sa_sigaction = &rdclog_crashsignal;
+  action.sa_flags = SA_SIGINFO;
+  sigemptyset(&action.sa_mask);
+
+  for(size_t i = 0; i < ARRAY_COUNT(logCrashSignals); i++)
+    sigaction(logCrashSignals[i], &action, &logCrashPrevActions[i]);
+}
+
+#else
+
+// on windows the crash handler flushes the log before writing a dump
+static void rdclog_installprocesshooks()
+{
+}
+
+#endif
+
+static void rdclog_startflushthread()
+{
+  if(logFlushThread)
+    return;
+
+  rdclog_installprocesshooks();
+
+  if(logFlushWake == NULL)
+    logFlushWake = Threading::Semaphore::Create();
+
+  logFlushThreadShutdown = 0;
+  logFlushThread = Threading::CreateThread(&rdclog_flushthread);
+}
+
+static void rdclog_stopflushthread()
+{
+  if(!logFlushThread)
+    return;
+
+  Atomic::Inc32(&logFlushThreadShutdown);
+  logFlushWake->Wake();
+
+  // as with the target control thread, we can't join here as we might be in the middle of module
+  // unloading. Give it a little while to notice the shutdown, it never blocks for long.
+  for(int i = 0; i < 50 && LogQueueLoad(&logFlushThreadRunning) != 0; i++)
+    Threading::Sleep(1);
+
+  Threading::CloseThread(logFlushThread);
+  logFlushThread = 0;
+}
+
 const char *rdclog_getfilename()
 {
   return logfile.c_str();
@@ -302,6 +613,11 @@ const char *rdclog_getfilename()
 
 void rdclog_filename(const char *filename)
 {
+  SCOPED_LOCK(LogWriteLock());
+
+  // anything already logged belongs at the end of the previous file
+  rdclog_drain();
+
   std::string previous = logfile;
 
   logfile = "";
@@ -327,9 +643,10 @@ void rdclog_filename(const char *filename)
       FileIO::Delete(previous.c_str());
     }
   }
-}
 
-static bool log_output_enabled = false;
+  if(logfileOpened)
+    rdclog_startflushthread();
+}
 
 void rdclog_enableoutput()
 {
@@ -338,44 +655,78 @@ void rdclog_enableoutput()
 
 void rdclog_closelog(const char *filename)
 {
+  rdclog_stopflushthread();
+
+  SCOPED_LOCK(LogWriteLock());
+
+  rdclog_drain();
+
   log_output_enabled = false;
   FileIO::logfile_close(filename);
 }
 
 void rdclog_flush()
 {
+  SCOPED_LOCK(LogWriteLock());
+  rdclog_drain();
 }
 
 void rdclogprint_int(LogType type, const char *fullMsg, const char *msg)
 {
-  static Threading::CriticalSection lock;
+  size_t fullLen = strlen(fullMsg);
+  size_t msgLen = strlen(msg);
 
-  SCOPED_LOCK(lock);
+  char *data = new char[fullLen + msgLen + 2];
+  memcpy(data, fullMsg, fullLen + 1);
+  memcpy(data + fullLen + 1, msg, msgLen + 1);
 
-#if ENABLED(OUTPUT_LOG_TO_DEBUG_OUT)
-  OSUtility::WriteOutput(OSUtility::Output_DebugMon, fullMsg);
-#endif
-#if ENABLED(OUTPUT_LOG_TO_STDOUT)
-  // don't output debug messages to stdout/stderr
-  if(type != LogType::Debug && log_output_enabled)
-    OSUtility::WriteOutput(OSUtility::Output_StdOut, msg);
-#endif
-#if ENABLED(OUTPUT_LOG_TO_STDERR)
-  // don't output debug messages to stdout/stderr
-  if(type != LogType::Debug && log_output_enabled)
-    OSUtility::WriteOutput(OSUtility::Output_StdErr, msg);
-#endif
-#if ENABLED(OUTPUT_LOG_TO_DISK)
-  if(logfileOpened)
+  // claim a position in the queue
+  int32_t pos = LogQueueLoad(&logQueueWritePos);
+  int32_t idx = 0;
+  for(;;)
   {
-    // strlen used as byte length - str is UTF-8 so this is NOT number of characters
-    FileIO::logfile_append(fullMsg, strlen(fullMsg));
+    idx = pos & (logQueueSize - 1);
+
+    int32_t diff = LogQueueLoad(&logQueue[idx].seq) - (pos - idx);
+
+    if(diff == 0)
+    {
+      int32_t prev = Atomic::CmpExch32(&logQueueWritePos, pos, pos + 1);
+      if(prev == pos)
+        break;
+      pos = prev;
+    }
+    else if(diff < 0)
+    {
+      // the queue is full, write out what we can ourselves rather than waiting on the thread
+      {
+        SCOPED_LOCK(LogWriteLock());
+        rdclog_drain();
+      }
+      pos = LogQueueLoad(&logQueueWritePos);
+    }
+    else
+    {
+      pos = LogQueueLoad(&logQueueWritePos);
+    }
   }
-#endif
+
+  LogQueueCell &cell = logQueue[idx];
+  cell.type = type;
+  cell.data = data;
+  cell.msgOffset = fullLen + 1;
+
+  // publish the cell to the consumer
+  Atomic::CmpExch32(&cell.seq, pos - idx, pos + 1 - idx);
+
+  // without the background thread, write synchronously as before
+  if(logFlushThread == 0)
+    rdclog_flush();
+  else if(LogQueueLoad(&logFlushThreadWaiting))
+    logFlushWake->Wake();
 }
 
 const int rdclog_outBufSize = 4 * 1024;
-static char rdclog_outputBuffer[rdclog_outBufSize + 3];
 
 static void write_newline(char *output)
 {
@@ -412,9 +763,9 @@ void rdclog_direct(time_t utcTime, uint32_t pid, LogType type, const char *proje
       "Debug  ", "Log    ", "Warning", "Error  ", "Fatal  ",
   };
 
-  static Threading::CriticalSection lock;
-
-  SCOPED_LOCK(lock);
+  // formatting happens on the calling thread into its own buffer, only the finished lines are
+  // handed to the log queue.
+  char rdclog_outputBuffer[rdclog_outBufSize + 3];
 
   rdclog_outputBuffer[rdclog_outBufSize] = rdclog_outputBuffer[0] = 0;
 
@@ -537,3 +888,48 @@ void rdclog_direct(time_t utcTime, uint32_t pid, LogType type, const char *proje
 
   SAFE_DELETE_ARRAY(oversizedBuffer);
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Test finding non-zero ranges", "[common]")
+{
+  std::vector<byte> data;
+  data.resize(10 * 1024 + 100);
+
+  std::vector<uint64_t> ranges;
+
+  SECTION("All zero")
+  {
+    FindNonZeroRanges(data.data(), data.size(), 1024, ranges);
+    CHECK(ranges.empty());
+  }
+
+  SECTION("Separate and adjacent pages")
+  {
+    data[1024 + 500] = 1;
+    data[3 * 1024] = 1;
+    data[4 * 1024 + 1023] = 1;
+    data[10 * 1024 + 99] = 1;
+
+    FindNonZeroRanges(data.data(), data.size(), 1024, ranges);
+
+    std::vector<uint64_t> expected = {
+        1024, 1024, 3 * 1024, 2 * 1024, 10 * 1024, 100,
+    };
+    CHECK(ranges == expected);
+  }
+
+  SECTION("Entirely non-zero")
+  {
+    memset(data.data(), 0xcc, data.size());
+
+    FindNonZeroRanges(data.data(), data.size(), 1024, ranges);
+
+    std::vector<uint64_t> expected = {0, data.size()};
+    CHECK(ranges == expected);
+  }
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -156,6 +156,10 @@ inline T AlignUpPtr(T x, A a)
   (((uint32_t)(d) << 24) | ((uint32_t)(c) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(a))
 
 bool FindDiffRange(void *a, void *b, size_t bufSize, size_t &diffStart, size_t &diffEnd);
+// finds the parts of data that aren't all zero, at a granularity of pageSize bytes. The result is
+// a list of offset and size pairs, with adjacent non-zero pages merged into one range.
+void FindNonZeroRanges(const byte *data, uint64_t size, uint64_t pageSize,
+                       std::vector<uint64_t> &ranges);
 uint32_t CalcNumMips(int Width, int Height, int Depth);
 
 byte *AllocAlignedBuffer(uint64_t size, uint64_t alignment = 64);
@@ -89,6 +89,34 @@ public:
 private:
   SpinLock *m_Spin;
 };
+
+// calls func(i) for every i in [0, count), spread across numThreads threads including the calling
+// thread. Indices are handed out in increasing order but may complete in any order, so any results
+// should be stored per-index and consumed after this returns.
+inline void ParallelFor(int32_t count, int32_t numThreads, std::function<void(int32_t)> func)
+{
+  volatile int32_t next = -1;
+
+  auto worker = [&next, count, &func]() {
+    for(int32_t i = Atomic::Inc32(&next); i < count; i = Atomic::Inc32(&next))
+      func(i);
+  };
+
+  if(numThreads > count)
+    numThreads = count;
+
+  std::vector<ThreadHandle> threads;
+  for(int32_t t = 1; t < numThreads; t++)
+    threads.push_back(CreateThread(worker));
+
+  worker();
+
+  for(ThreadHandle t : threads)
+  {
+    JoinThread(t);
+    CloseThread(t);
+  }
+}
 };
 
 #define SCOPED_LOCK(cs) Threading::ScopedLock CONCAT(scopedlock, __LINE__)(&cs);
@@ -71,4 +71,24 @@ TEST_CASE("Test spin lock", "[threading]")
   CHECK(finalValue == value);
 }
 
+TEST_CASE("Test parallel for", "[threading]")
+{
+  std::vector<int32_t> visited;
+  visited.resize(1000);
+
+  Threading::ParallelFor((int32_t)visited.size(), 4,
+                         [&visited](int32_t i) { Atomic::Inc32(&visited[i]); });
+
+  for(size_t i = 0; i < visited.size(); i++)
+    CHECK(visited[i] == 1);
+
+  // more threads than work, or no work at all
+  int32_t total = 0;
+  Threading::ParallelFor(3, 8, [&total](int32_t i) { Atomic::Inc32(&total); });
+  CHECK(total == 3);
+
+  Threading::ParallelFor(0, 8, [&total](int32_t i) { Atomic::Inc32(&total); });
+  CHECK(total == 3);
+}
+
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
\ No newline at end of file
@@ -258,6 +258,8 @@ RenderDoc::RenderDoc()
 
   m_ExHandler = NULL;
 
+  m_CallstackTable = new CallstackTable();
+
   m_Overlay = eRENDERDOC_Overlay_Default;
 
   m_VulkanCheck = NULL;
@@ -269,15 +271,31 @@ RenderDoc::RenderDoc()
 
 void RenderDoc::Initialise()
 {
-  Callstack::Init();
-
-  Network::Init();
+  PerformanceTimer initTimer;
+  PerformanceTimer stageTimer;
 
   Threading::Init();
 
+  m_FastStart = false;
+
+  // in fast start mode we only set up what's needed to hook and to be connected to, and leave the
+  // rest until a device is created or a target control client connects. This is useful for
+  // processes that are hooked as children but never do any graphics work.
+  if(!IsReplayApp())
+  {
+    const char *fastStart = Process::GetEnvVariable("RENDERDOC_FAST_START");
+
+    m_FastStart = fastStart && fastStart[0] && fastStart[0] != '0';
+  }
+
+  Network::Init();
+
   m_RemoteIdent = 0;
   m_RemoteThread = 0;
 
+  double networkTime = stageTimer.GetMilliseconds();
+  stageTimer.Restart();
+
   if(!IsReplayApp())
   {
     Process::ApplyEnvironmentModification();
@@ -313,6 +331,9 @@ void RenderDoc::Initialise()
     }
   }
 
+  double targetControlTime = stageTimer.GetMilliseconds();
+  stageTimer.Restart();
+
   // set default capture log - useful for when hooks aren't setup
   // through the UI (and a log file isn't set manually)
   {
@@ -354,12 +375,46 @@ void RenderDoc::Initialise()
   RDCLOG("Packaged for %s (%s) - %s", DISTRIBUTION_NAME, DISTRIBUTION_VERSION, DISTRIBUTION_CONTACT);
 #endif
 
-  Keyboard::Init();
-
   m_FrameTimer.InitTimers();
 
   m_ExHandler = NULL;
 
+  double loggingTime = stageTimer.GetMilliseconds();
+
+  RDCLOG("Initialised in %.2fms: network %.2fms, target control %.2fms, logging %.2fms",
+         initTimer.GetMilliseconds(), networkTime, targetControlTime, loggingTime);
+
+  if(m_FastStart)
+    RDCLOG("Fast start enabled, deferring remaining initialisation");
+  else
+    CompleteInitialise();
+
+  // begin printing to stdout/stderr after this point, earlier logging is debugging
+  // cruft that we don't want cluttering output.
+  // However we don't want to print in captured applications, since they may be outputting important
+  // information to stdout/stderr and being piped around and processed!
+  if(IsReplayApp())
+    RDCLOGOUTPUT();
+}
+
+void RenderDoc::CompleteInitialise()
+{
+  SCOPED_LOCK(m_DeferredInitLock);
+
+  if(m_DeferredInitDone)
+    return;
+
+  m_DeferredInitDone = true;
+
+  PerformanceTimer stageTimer;
+
+  Callstack::Init();
+
+  Keyboard::Init();
+
+  double callstackTime = stageTimer.GetMilliseconds();
+  stageTimer.Restart();
+
   {
     std::string curFile;
     FileIO::GetExecutableFilename(curFile);
@@ -374,12 +429,10 @@ void RenderDoc::Initialise()
     }
   }
 
-  // begin printing to stdout/stderr after this point, earlier logging is debugging
-  // cruft that we don't want cluttering output.
-  // However we don't want to print in captured applications, since they may be outputting important
-  // information to stdout/stderr and being piped around and processed!
-  if(IsReplayApp())
-    RDCLOGOUTPUT();
+  double crashHandlerTime = stageTimer.GetMilliseconds();
+
+  RDCLOG("%s initialisation: callstacks %.2fms, crash handler %.2fms",
+         m_FastStart ? "Completed deferred" : "Remaining", callstackTime, crashHandlerTime);
 }
 
 RenderDoc::~RenderDoc()
@@ -419,6 +472,8 @@ RenderDoc::~RenderDoc()
     m_RemoteThread = 0;
   }
 
+  SAFE_DELETE(m_CallstackTable);
+
   Process::Shutdown();
 
   Network::Shutdown();
@@ -769,116 +824,199 @@ bool RenderDoc::ShouldTriggerCapture(uint32_t frameNumber)
   return ret;
 }
 
-void RenderDoc::ResamplePixels(const FramePixels &in, RDCThumb &out)
+bool RenderDoc::ShouldContinueCapture(uint32_t frameNumber)
 {
-  // code below assumes pitch_requirement is a power of 2 number
-  RDCASSERT((in.pitch_requirement & (in.pitch_requirement - 1)) == 0);
+  // captures of consecutive frames are only combined if requested
+  if(!m_Options.combineMultiFrameCaptures)
+    return false;
 
-  out.width = (uint16_t)RDCMIN(in.max_width, in.width);
-  out.width &= ~(in.pitch_requirement - 1);    // align down to multiple of in.
-  out.height = uint16_t(out.width * in.height / in.width);
-  out.len = 3 * out.width * out.height;
-  out.pixels = new byte[out.len];
-  out.format = FileType::Raw;
+  // continue if there are frames left from a multi-frame trigger, or if the next frame is queued.
+  // The request is consumed here, the same as ShouldTriggerCapture would have done.
+  if(m_Cap > 0)
+  {
+    m_Cap--;
+    return true;
+  }
 
-  byte *dst = (byte *)out.pixels;
-  byte *source = (byte *)in.data;
+  auto it = m_QueuedFrameCaptures.find(frameNumber);
+  if(it != m_QueuedFrameCaptures.end())
+  {
+    m_QueuedFrameCaptures.erase(it);
+    return true;
+  }
 
-  for(uint32_t y = 0; y < out.height; y++)
+  return false;
+}
+
+// decoders for each backbuffer format the thumbnail can be generated from. Decode() returns values
+// in the space that is filtered, and Encode() converts a filtered value back to an 8-bit channel.
+struct ThumbDecodeRGBA8
+{
+  static void Decode(const byte *src, float *rgb)
   {
-    for(uint32_t x = 0; x < out.width; x++)
-    {
-      uint32_t xSource = x * in.width / out.width;
-      uint32_t ySource = y * in.height / out.height;
-      byte *src = &source[in.stride * xSource + in.pitch * ySource];
+    rgb[0] = src[0];
+    rgb[1] = src[1];
+    rgb[2] = src[2];
+  }
+  static byte Encode(float v) { return (byte)RDCCLAMP(v + 0.5f, 0.0f, 255.0f); }
+};
 
-      if(in.buf1010102)
-      {
-        uint32_t *src1010102 = (uint32_t *)src;
-        Vec4f unorm = ConvertFromR10G10B10A2(*src1010102);
-        dst[0] = (byte)(unorm.x * 255.0f);
-        dst[1] = (byte)(unorm.y * 255.0f);
-        dst[2] = (byte)(unorm.z * 255.0f);
-      }
-      else if(in.buf565)
-      {
-        uint16_t *src565 = (uint16_t *)src;
-        Vec3f unorm = ConvertFromB5G6R5(*src565);
-        dst[0] = (byte)(unorm.z * 255.0f);
-        dst[1] = (byte)(unorm.y * 255.0f);
-        dst[2] = (byte)(unorm.x * 255.0f);
-      }
-      else if(in.buf5551)
-      {
-        uint16_t *src5551 = (uint16_t *)src;
-        Vec4f unorm = ConvertFromB5G5R5A1(*src5551);
-        dst[0] = (byte)(unorm.z * 255.0f);
-        dst[1] = (byte)(unorm.y * 255.0f);
-        dst[2] = (byte)(unorm.x * 255.0f);
-      }
-      else if(in.bgra)
-      {
-        dst[0] = src[2];
-        dst[1] = src[1];
-        dst[2] = src[0];
-      }
-      else if(in.bpc == 2)    // R16G16B16A16 backbuffer
-      {
-        uint16_t *src16 = (uint16_t *)src;
+struct ThumbDecodeBGRA8 : public ThumbDecodeRGBA8
+{
+  static void Decode(const byte *src, float *rgb)
+  {
+    rgb[0] = src[2];
+    rgb[1] = src[1];
+    rgb[2] = src[0];
+  }
+};
 
-        float linearR = RDCCLAMP(ConvertFromHalf(src16[0]), 0.0f, 1.0f);
-        float linearG = RDCCLAMP(ConvertFromHalf(src16[1]), 0.0f, 1.0f);
-        float linearB = RDCCLAMP(ConvertFromHalf(src16[2]), 0.0f, 1.0f);
+struct ThumbDecode1010102 : public ThumbDecodeRGBA8
+{
+  static void Decode(const byte *src, float *rgb)
+  {
+    Vec4f unorm = ConvertFromR10G10B10A2(*(const uint32_t *)src);
+    rgb[0] = unorm.x * 255.0f;
+    rgb[1] = unorm.y * 255.0f;
+    rgb[2] = unorm.z * 255.0f;
+  }
+};
 
-        if(linearR < 0.0031308f)
-          dst[0] = byte(255.0f * (12.92f * linearR));
-        else
-          dst[0] = byte(255.0f * (1.055f * powf(linearR, 1.0f / 2.4f) - 0.055f));
+struct ThumbDecode565 : public ThumbDecodeRGBA8
+{
+  static void Decode(const byte *src, float *rgb)
+  {
+    Vec3f unorm = ConvertFromB5G6R5(*(const uint16_t *)src);
+    rgb[0] = unorm.z * 255.0f;
+    rgb[1] = unorm.y * 255.0f;
+    rgb[2] = unorm.x * 255.0f;
+  }
+};
 
-        if(linearG < 0.0031308f)
-          dst[1] = byte(255.0f * (12.92f * linearG));
-        else
-          dst[1] = byte(255.0f * (1.055f * powf(linearG, 1.0f / 2.4f) - 0.055f));
+struct ThumbDecode5551 : public ThumbDecodeRGBA8
+{
+  static void Decode(const byte *src, float *rgb)
+  {
+    Vec4f unorm = ConvertFromB5G5R5A1(*(const uint16_t *)src);
+    rgb[0] = unorm.z * 255.0f;
+    rgb[1] = unorm.y * 255.0f;
+    rgb[2] = unorm.x * 255.0f;
+  }
+};
 
-        if(linearB < 0.0031308f)
-          dst[2] = byte(255.0f * (12.92f * linearB));
-        else
-          dst[2] = byte(255.0f * (1.055f * powf(linearB, 1.0f / 2.4f) - 0.055f));
-      }
-      else
-      {
-        dst[0] = src[0];
-        dst[1] = src[1];
-        dst[2] = src[2];
-      }
-      dst += 3;
-    }
+// R16G16B16A16 backbuffer, filtered in linear space and converted to sRGB afterwards
+struct ThumbDecodeHalf
+{
+  static void Decode(const byte *src, float *rgb)
+  {
+    const uint16_t *src16 = (const uint16_t *)src;
+    rgb[0] = RDCCLAMP(ConvertFromHalf(src16[0]), 0.0f, 1.0f);
+    rgb[1] = RDCCLAMP(ConvertFromHalf(src16[1]), 0.0f, 1.0f);
+    rgb[2] = RDCCLAMP(ConvertFromHalf(src16[2]), 0.0f, 1.0f);
+  }
+  static byte Encode(float linear)
+  {
+    if(linear < 0.0031308f)
+      return byte(255.0f * (12.92f * linear));
+    return byte(255.0f * (1.055f * powf(linear, 1.0f / 2.4f) - 0.055f));
+  }
+};
+
+// the source texels and weight for one output column or row. Each output pixel is bilinearly
+// filtered at the centre of its footprint in the source image.
+struct ThumbTap
+{
+  uint32_t offs[2];
+  float weight;
+};
+
+static void CalcThumbTaps(uint32_t srcSize, uint32_t dstSize, uint32_t byteStride,
+                          std::vector<ThumbTap> &taps)
+{
+  taps.resize(dstSize);
+
+  const float scale = float(srcSize) / float(dstSize);
+
+  for(uint32_t i = 0; i < dstSize; i++)
+  {
+    float centre = RDCMAX(0.0f, (float(i) + 0.5f) * scale - 0.5f);
+    uint32_t t0 = RDCMIN((uint32_t)centre, srcSize - 1);
+    uint32_t t1 = RDCMIN(t0 + 1, srcSize - 1);
+
+    taps[i].offs[0] = t0 * byteStride;
+    taps[i].offs[1] = t1 * byteStride;
+    taps[i].weight = centre - float(t0);
   }
+}
 
-  if(!in.is_y_flipped)
+template <typename Decoder>
+static void ResampleThumbnail(const RenderDoc::FramePixels &in, RDCThumb &out)
+{
+  std::vector<ThumbTap> cols, rows;
+  CalcThumbTaps(in.width, out.width, in.stride, cols);
+  CalcThumbTaps(in.height, out.height, in.pitch, rows);
+
+  const byte *source = (const byte *)in.data;
+
+  for(uint32_t y = 0; y < out.height; y++)
   {
-    for(uint16_t y = 0; y <= out.height / 2; y++)
+    // flip while resampling rather than as a separate pass afterwards
+    uint32_t dstRow = in.is_y_flipped ? y : out.height - 1 - y;
+    byte *dst = (byte *)out.pixels + dstRow * out.width * 3;
+
+    const byte *row0 = source + rows[y].offs[0];
+    const byte *row1 = source + rows[y].offs[1];
+    const float wy = rows[y].weight;
+
+    for(uint32_t x = 0; x < out.width; x++)
     {
-      uint16_t flipY = (out.height - 1 - y);
-      for(uint16_t x = 0; x < out.width; x++)
+      const ThumbTap &col = cols[x];
+
+      float a[3], b[3], c[3], d[3];
+      Decoder::Decode(row0 + col.offs[0], a);
+      Decoder::Decode(row0 + col.offs[1], b);
+      Decoder::Decode(row1 + col.offs[0], c);
+      Decoder::Decode(row1 + col.offs[1], d);
+
+      for(int i = 0; i < 3; i++)
       {
-        byte *src = (byte *)out.pixels;
-        byte save[3];
-        save[0] = src[(y * out.width + x) * 3 + 0];
-        save[1] = src[(y * out.width + x) * 3 + 1];
-        save[2] = src[(y * out.width + x) * 3 + 2];
-
-        src[(y * out.width + x) * 3 + 0] = src[(flipY * out.width + x) * 3 + 0];
-        src[(y * out.width + x) * 3 + 1] = src[(flipY * out.width + x) * 3 + 1];
-        src[(y * out.width + x) * 3 + 2] = src[(flipY * out.width + x) * 3 + 2];
-
-        src[(flipY * out.width + x) * 3 + 0] = save[0];
-        src[(flipY * out.width + x) * 3 + 1] = save[1];
-        src[(flipY * out.width + x) * 3 + 2] = save[2];
+        float top = a[i] + (b[i] - a[i]) * col.weight;
+        float bottom = c[i] + (d[i] - c[i]) * col.weight;
+        dst[i] = Decoder::Encode(top + (bottom - top) * wy);
       }
+
+      dst += 3;
     }
   }
 }
+
+void RenderDoc::ResamplePixels(const FramePixels &in, RDCThumb &out)
+{
+  // code below assumes pitch_requirement is a power of 2 number
+  RDCASSERT((in.pitch_requirement & (in.pitch_requirement - 1)) == 0);
+
+  out.width = (uint16_t)RDCMIN(in.max_width, in.width);
+  out.width &= ~(in.pitch_requirement - 1);    // align down to multiple of in.
+  out.height = uint16_t(out.width * in.height / in.width);
+  out.len = 3 * out.width * out.height;
+  out.pixels = new byte[out.len];
+  out.format = FileType::Raw;
+
+  // select the decoder once here so the per-pixel loop has no format branches
+  if(in.buf1010102)
+    ResampleThumbnail<ThumbDecode1010102>(in, out);
+  else if(in.buf565)
+    ResampleThumbnail<ThumbDecode565>(in, out);
+  else if(in.buf5551)
+    ResampleThumbnail<ThumbDecode5551>(in, out);
+  else if(in.bgra)
+    ResampleThumbnail<ThumbDecodeBGRA8>(in, out);
+  else if(in.bpc == 2)
+    ResampleThumbnail<ThumbDecodeHalf>(in, out);
+  else
+    ResampleThumbnail<ThumbDecodeRGBA8>(in, out);
+}
+
 void RenderDoc::EncodePixelsPNG(const RDCThumb &in, RDCThumb &out)
 {
   struct WriteCallbackData
@@ -904,6 +1042,26 @@ void RenderDoc::EncodePixelsPNG(const RDCThumb &in, RDCThumb &out)
   out.format = FileType::PNG;
 }
 
+struct PendingThumbnail
+{
+  Threading::ThreadHandle thread = 0;
+  RDCThumb raw;
+  RDCThumb png;
+};
+
+// waits for the background PNG encode to finish, and frees the raw pixels it was encoded from
+static void FinishThumbnail(PendingThumbnail *thumb)
+{
+  if(thumb->thread)
+  {
+    Threading::JoinThread(thumb->thread);
+    Threading::CloseThread(thumb->thread);
+    thumb->thread = 0;
+  }
+
+  SAFE_DELETE_ARRAY(thumb->raw.pixels);
+}
+
 RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePixels &fp)
 {
   RDCFile *ret = new RDCFile;
@@ -924,17 +1082,23 @@ RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePi
     }
   }
 
-  RDCThumb outRaw, outPng;
+  PendingThumbnail *thumb = new PendingThumbnail;
+
   if(fp.data)
   {
-    // point sample info into raw buffer
-    ResamplePixels(fp, outRaw);
-    EncodePixelsPNG(outRaw, outPng);
+    // filter into raw buffer
+    ResamplePixels(fp, thumb->raw);
+
+    // the PNG is only needed for the extended thumbnail section at the end of the capture, so
+    // encode it in the background while the frame is written.
+    thumb->thread =
+        Threading::CreateThread([this, thumb]() { EncodePixelsPNG(thumb->raw, thumb->png); });
   }
 
-  RDCASSERT(outPng.pixels != NULL);
+  RDCASSERT(thumb->raw.pixels != NULL);
 
-  ret->SetData(driver, ToStr(driver).c_str(), OSUtility::GetMachineIdent(), &outPng);
+  // the header thumbnail is encoded straight from the raw pixels
+  ret->SetData(driver, ToStr(driver).c_str(), OSUtility::GetMachineIdent(), &thumb->raw);
 
   FileIO::CreateParentDirectory(m_CurrentLogFile);
 
@@ -946,8 +1110,17 @@ RDCFile *RenderDoc::CreateRDC(RDCDriver driver, uint32_t frameNum, const FramePi
     SAFE_DELETE(ret);
   }
 
-  SAFE_DELETE_ARRAY(outRaw.pixels);
-  SAFE_DELETE_ARRAY(outPng.pixels);
+  if(ret)
+  {
+    SCOPED_LOCK(m_CaptureLock);
+    m_PendingThumbnails[ret] = thumb;
+  }
+  else
+  {
+    FinishThumbnail(thumb);
+    SAFE_DELETE_ARRAY(thumb->png.pixels);
+    SAFE_DELETE(thumb);
+  }
 
   return ret;
 }
@@ -1337,10 +1510,37 @@ void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
       w->Finish();
 
       delete w;
+
+      // chunks only store an index to their callstack, so write the table too
+      props.type = SectionType::CallstackTable;
+      w = rdc->WriteSection(props);
+
+      rdc->GetCallstackTable()->Write(*w);
+
+      w->Finish();
+
+      delete w;
+    }
+
+    PendingThumbnail *pending = NULL;
+    {
+      SCOPED_LOCK(m_CaptureLock);
+      auto it = m_PendingThumbnails.find(rdc);
+      if(it != m_PendingThumbnails.end())
+      {
+        pending = it->second;
+        m_PendingThumbnails.erase(it);
+      }
     }
 
-    const RDCThumb &thumb = rdc->GetThumbnail();
-    if(thumb.format != FileType::JPG && thumb.width > 0 && thumb.height > 0)
+    if(pending)
+      FinishThumbnail(pending);
+
+    RDCThumb thumb;
+    if(pending)
+      thumb = pending->png;
+
+    if(thumb.pixels && thumb.width > 0 && thumb.height > 0)
     {
       SectionProperties props = {};
       props.type = SectionType::ExtendedThumbnail;
@@ -1363,6 +1563,12 @@ void RenderDoc::FinishCaptureWriting(RDCFile *rdc, uint32_t frameNumber)
       delete w;
     }
 
+    if(pending)
+    {
+      SAFE_DELETE_ARRAY(pending->png.pixels);
+      SAFE_DELETE(pending);
+    }
+
     RDCLOG("Written to disk: %s", m_CurrentLogFile.c_str());
 
     CaptureData cap(m_CurrentLogFile, Timing::GetUnixTimestamp(), rdc->GetDriver(), frameNumber);
@@ -1389,6 +1595,8 @@ void RenderDoc::AddDeviceFrameCapturer(void *dev, IFrameCapturer *cap)
     return;
   }
 
+  CompleteInitialise();
+
   m_DeviceFrameCapturers[dev] = cap;
 }
 
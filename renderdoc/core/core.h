@@ -39,7 +39,9 @@
 #include "os/os_specific.h"
 
 class Chunk;
+class CallstackTable;
 struct RDCThumb;
+struct PendingThumbnail;
 
 // not provided by tinyexr, just do by hand
 bool is_exr_file(FILE *f);
@@ -400,6 +402,9 @@ public:
   const char *GetCaptureFileTemplate() const { return m_CaptureFileTemplate.c_str(); }
   const char *GetCurrentTarget() const { return m_Target.c_str(); }
   void Initialise();
+  // performs any initialisation that was deferred at load by RENDERDOC_FAST_START. Called when a
+  // device is created or a target control client connects, does nothing after the first call.
+  void CompleteInitialise();
   void Shutdown();
 
   uint64_t GetMicrosecondTimestamp() { return uint64_t(m_Timer.GetMicroseconds()); }
@@ -423,6 +428,7 @@ public:
 
   void SetCaptureOptions(const CaptureOptions &opts);
   const CaptureOptions &GetCaptureOptions() const { return m_Options; }
+  CallstackTable &GetCallstackTable() { return *m_CallstackTable; }
   void RecreateCrashHandler();
   void UnloadCrashHandler();
   ICrashHandler *GetCrashHandler() const { return m_ExHandler; }
@@ -564,6 +570,7 @@ public:
   const std::vector<RENDERDOC_InputButton> &GetFocusKeys() { return m_FocusKeys; }
   const std::vector<RENDERDOC_InputButton> &GetCaptureKeys() { return m_CaptureKeys; }
   bool ShouldTriggerCapture(uint32_t frameNumber);
+  bool ShouldContinueCapture(uint32_t frameNumber);
 
   enum
   {
@@ -598,6 +605,10 @@ private:
   std::string m_CaptureFileTemplate;
   std::string m_CurrentLogFile;
   CaptureOptions m_Options;
+
+  // callstacks collected while capturing, shared by all chunks recorded in the process. Each
+  // capture file gets its own table with only the callstacks it references
+  CallstackTable *m_CallstackTable = NULL;
   uint32_t m_Overlay;
 
   std::set<uint32_t> m_QueuedFrameCaptures;
@@ -613,6 +624,8 @@ private:
 
   Threading::CriticalSection m_CaptureLock;
   std::vector<CaptureData> m_Captures;
+  // thumbnails still being encoded for captures in progress, also protected by m_CaptureLock
+  std::map<RDCFile *, PendingThumbnail *> m_PendingThumbnails;
 
   Threading::CriticalSection m_ChildLock;
   std::vector<rdcpair<uint32_t, uint32_t> > m_Children;
@@ -692,6 +705,12 @@ private:
   static void TargetControlClientThread(uint32_t version, Network::Socket *client);
 
   ICrashHandler *m_ExHandler;
+
+  // when set, only the hooks and target control are set up at load, and everything else waits for
+  // CompleteInitialise()
+  bool m_FastStart = false;
+  bool m_DeferredInitDone = false;
+  Threading::CriticalSection m_DeferredInitLock;
 };
 
 struct DriverRegistration
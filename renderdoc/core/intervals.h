@@ -24,55 +24,57 @@
 #pragma once
 
 #include <algorithm>
-#include <map>
+#include <utility>
+#include <vector>
 #include "common/common.h"
 
 template <typename T>
 struct Intervals;
 
-template <typename T, typename Map, typename Iter, typename Interval>
+template <typename T, typename Map, typename Interval>
 class IntervalsIter;
 
 // An interval in an `Intervals<T>` instance.
-template <typename T, typename Map, typename Iter>
+// Intervals are stored as a sorted array of start points, so an interval is referred to by its
+// index. Like a vector iterator, the index is only stable until the `Intervals<T>` is modified
+// through something other than this interval.
+template <typename T, typename Map>
 class ConstIntervalRef
 {
-  friend class IntervalsIter<T, Map, Iter, ConstIntervalRef>;
+  friend class IntervalsIter<T, Map, ConstIntervalRef>;
 
 protected:
-  Iter iter;
+  size_t iter;
   Map *owner;
 
-  ConstIntervalRef(Map *owner, Iter iter) : iter(iter), owner(owner) {}
+  ConstIntervalRef(Map *owner, size_t iter) : iter(iter), owner(owner) {}
 public:
   // Inclusive lower bound
-  inline uint64_t start() const { return iter->first; }
+  inline uint64_t start() const { return (*owner)[iter].first; }
   // Exclusive upper bound
   inline uint64_t finish() const
   {
-    Iter next = iter;
-    next++;
-    if(next == owner->end())
+    if(iter + 1 >= owner->size())
     {
       return UINT64_MAX;
     }
-    return next->first;
+    return (*owner)[iter + 1].first;
   }
 
   // Value associated with this interval
-  inline const T &value() const { return iter->second; }
+  inline const T &value() const { return (*owner)[iter].second; }
 };
 
 // A mutable interval in an `Intervals<T>` instance
-template <typename T, typename Map, typename Iter>
-class IntervalRef : public ConstIntervalRef<T, Map, Iter>
+template <typename T, typename Map>
+class IntervalRef : public ConstIntervalRef<T, Map>
 {
-  friend class IntervalsIter<T, Map, Iter, IntervalRef>;
+  friend class IntervalsIter<T, Map, IntervalRef>;
 
 protected:
-  IntervalRef(Map *owner, Iter iter) : ConstIntervalRef<T, Map, Iter>(owner, iter) {}
+  IntervalRef(Map *owner, size_t iter) : ConstIntervalRef<T, Map>(owner, iter) {}
 public:
-  inline void setValue(const T &val) { this->iter->second = val; }
+  inline void setValue(const T &val) { (*this->owner)[this->iter].second = val; }
   // Split this interval into two intervals:
   //   [start, x), [x, finish)
   // This iterator will point to [x, finish) after the split.
@@ -81,7 +83,11 @@ public:
   inline void split(uint64_t x)
   {
     if(this->start() < x)
-      this->iter = this->owner->insert(std::pair<uint64_t, T>(x, this->value())).first;
+    {
+      this->owner->insert(this->owner->begin() + this->iter + 1,
+                          std::pair<uint64_t, T>(x, this->value()));
+      this->iter++;
+    }
   }
 
   // Merge this interval with the interval to the left, if both intervals have
@@ -90,29 +96,23 @@ public:
   // performed; otherwise this iterator is unmodified.
   inline void mergeLeft()
   {
-    if(this->iter != this->owner->begin())
+    if(this->iter > 0 && (*this->owner)[this->iter].second == (*this->owner)[this->iter - 1].second)
     {
-      auto prev_it = this->iter;
-      prev_it--;
-      if(this->iter->second == prev_it->second)
-      {
-        this->owner->erase(this->iter);
-        this->iter = prev_it;
-      }
+      this->owner->erase(this->owner->begin() + this->iter);
+      this->iter--;
     }
   }
 };
 
 // An iterator in an `Intervals<T>` instance.
-template <typename T, typename Map, typename Iter, typename Interval>
+template <typename T, typename Map, typename Interval>
 class IntervalsIter
 {
   friend struct Intervals<T>;
 
 protected:
   Interval ref;
-  IntervalsIter(Map *owner, Iter iter) : ref(owner, iter) {}
-  Iter unwrap() { return ref.iter; }
+  IntervalsIter(Map *owner, size_t iter) : ref(owner, iter) {}
 public:
   IntervalsIter(const IntervalsIter &src) : ref(src.ref) {}
   IntervalsIter &operator++()
@@ -141,10 +141,7 @@ public:
   {
     return ref.iter == rhs.ref.iter && ref.owner == rhs.ref.owner;
   }
-  bool operator!=(const IntervalsIter &rhs) const
-  {
-    return ref.iter != rhs.ref.iter && ref.owner == rhs.ref.owner;
-  }
+  bool operator!=(const IntervalsIter &rhs) const { return !(*this == rhs); }
   IntervalsIter &operator=(const IntervalsIter &rhs)
   {
     ref.iter = rhs.ref.iter;
@@ -155,59 +152,77 @@ public:
   inline Interval *operator->() { return &ref; }
 };
 
+// A single update to apply to an `Intervals<T>` instance, covering [start, finish).
+template <typename T>
+struct IntervalUpdate
+{
+  uint64_t start;
+  uint64_t finish;
+  T value;
+};
+
 // Data structure to efficiently store values for disjoint intervals.
+// The start point of each interval is kept in a flat sorted array. Memory objects can have
+// thousands of sub-allocated ranges, and walking or rebuilding a contiguous array is much cheaper
+// than a node-based tree. Updates rebuild only the affected span and splice it back in one go.
 template <typename T>
 struct Intervals
 {
 public:
-  typedef IntervalRef<T, std::map<uint64_t, T>, typename std::map<uint64_t, T>::iterator> interval;
-  typedef IntervalsIter<T, std::map<uint64_t, T>, typename std::map<uint64_t, T>::iterator, interval> iterator;
+  typedef std::vector<std::pair<uint64_t, T> > StartPointArray;
+
+  typedef IntervalRef<T, StartPointArray> interval;
+  typedef IntervalsIter<T, StartPointArray, interval> iterator;
 
-  typedef ConstIntervalRef<T, const std::map<uint64_t, T>, typename std::map<uint64_t, T>::const_iterator>
-      const_interval;
-  typedef IntervalsIter<T, const std::map<uint64_t, T>,
-                        typename std::map<uint64_t, T>::const_iterator, const_interval>
-      const_iterator;
+  typedef ConstIntervalRef<T, const StartPointArray> const_interval;
+  typedef IntervalsIter<T, const StartPointArray, const_interval> const_iterator;
 
 private:
-  std::map<uint64_t, T> StartPoints;
+  StartPointArray StartPoints;
 
-  iterator Wrap(typename std::map<uint64_t, T>::iterator iter)
+  // a piece of a span being rebuilt, `modified` tracks whether the value was composed, since only
+  // boundaries next to a modified piece are candidates for merging.
+  struct Piece
   {
-    return iterator(&StartPoints, iter);
+    uint64_t start;
+    T value;
+    bool modified;
+  };
+
+  static void PushPiece(std::vector<Piece> &pieces, uint64_t start, const T &value, bool modified)
+  {
+    if(!pieces.empty() && (modified || pieces.back().modified) && pieces.back().value == value)
+    {
+      pieces.back().modified = true;
+      return;
+    }
+    pieces.push_back({start, value, modified});
   }
 
-  const_iterator Wrap(typename std::map<uint64_t, T>::const_iterator iter) const
+  // index of the interval containing `x`
+  size_t FindIndex(uint64_t x) const
   {
-    return const_iterator(&StartPoints, iter);
+    // Find the first interval starting after `x`; return the preceding interval.
+    auto it = std::upper_bound(
+        StartPoints.begin(), StartPoints.end(), x,
+        [](uint64_t val, const std::pair<uint64_t, T> &p) { return val < p.first; });
+    return size_t(it - StartPoints.begin()) - 1;
   }
 
+  iterator Wrap(size_t iter) { return iterator(&StartPoints, iter); }
+  const_iterator Wrap(size_t iter) const { return const_iterator(&StartPoints, iter); }
 public:
   Intervals() : StartPoints{{0, T()}} {}
-  inline iterator end() { return Wrap(StartPoints.end()); }
-  inline iterator begin() { return Wrap(StartPoints.begin()); }
-  inline const_iterator begin() const { return Wrap(StartPoints.begin()); }
-  inline const_iterator end() const { return Wrap(StartPoints.end()); }
-  typedef typename std::map<uint64_t, T>::size_type size_type;
+  inline iterator end() { return Wrap(StartPoints.size()); }
+  inline iterator begin() { return Wrap(0); }
+  inline const_iterator begin() const { return Wrap(0); }
+  inline const_iterator end() const { return Wrap(StartPoints.size()); }
+  typedef typename StartPointArray::size_type size_type;
   inline size_type size() const { return StartPoints.size(); }
   // Find the interval containing `x`.
-  iterator find(uint64_t x)
-  {
-    // Find the first interval starting after `x`; return the preceding interval.
-    auto it = StartPoints.upper_bound(x);
-    it--;
-    return Wrap(it);
-  }
-
+  iterator find(uint64_t x) { return Wrap(FindIndex(x)); }
   // Find the interval containing `x`.
-  const_iterator find(uint64_t x) const
-  {
-    // Find the first interval starting after `x`; return the preceding interval.
-    auto it = StartPoints.upper_bound(x);
-    it--;
-    return Wrap(it);
-  }
-
+  const_iterator find(uint64_t x) const { return Wrap(FindIndex(x)); }
   // Update the values of overlapping intervals to `comp(oldValue, val)`
   // (where `oldValue` is the value of the interval prior to calling `update`).
   // If start/finish do not lie on the boundaries between intervals, the intervals
@@ -215,35 +230,86 @@ public:
   template <typename Compose>
   void update(uint64_t start, uint64_t finish, T val, Compose comp)
   {
-    if(finish <= start)
+    IntervalUpdate<T> u = {start, finish, val};
+    update(&u, 1, comp);
+  }
+
+  // Apply a list of updates in a single pass, equivalent to calling `update` for each in turn.
+  // The updates must be sorted by start point and must not overlap. Empty updates are ignored.
+  template <typename Compose>
+  void update(const std::vector<IntervalUpdate<T> > &updates, Compose comp)
+  {
+    if(!updates.empty())
+      update(updates.data(), updates.size(), comp);
+  }
+
+  template <typename Compose>
+  void update(const IntervalUpdate<T> *updates, size_t count, Compose comp)
+  {
+    size_t first = 0, last = count;
+    while(first < last && updates[first].finish <= updates[first].start)
+      first++;
+    while(last > first && updates[last - 1].finish <= updates[last - 1].start)
+      last--;
+
+    if(first == last)
       return;
 
-    auto i = find(start);
+    // find the span of intervals touched by the updates, including the unmodified neighbour on
+    // either side which may be merged with a modified interval.
+    size_t lo = FindIndex(updates[first].start);
+    size_t hi = FindIndex(updates[last - 1].finish - 1) + 1;
+    if(lo > 0)
+      lo--;
+    if(hi < StartPoints.size())
+      hi++;
 
-    // Split the interval so that `i.start == start`
-    i->split(start);
+    std::vector<Piece> pieces;
+    pieces.reserve(hi - lo + (last - first) * 2);
 
-    // Loop over all the intervals in `a` that intersect the interval [start, finish)
-    for(; i != end() && i->start() < finish; i++)
+    size_t u = first;
+    for(size_t k = lo; k < hi; k++)
     {
-      if(i->finish() > finish)
+      uint64_t pos = StartPoints[k].first;
+      uint64_t end = k + 1 < StartPoints.size() ? StartPoints[k + 1].first : UINT64_MAX;
+      const T &oldValue = StartPoints[k].second;
+
+      while(pos < end)
       {
-        // In this case, interval `i` extends beyond `finish`;
-        // split `i` so that we only update the portion of `i` in [start, finish).
-        i->split(finish);
+        while(u < last && (updates[u].finish <= pos || updates[u].finish <= updates[u].start))
+          u++;
+
+        // no more updates inside this interval, the rest of it is unmodified
+        if(u == last || updates[u].start >= end)
+        {
+          PushPiece(pieces, pos, oldValue, false);
+          break;
+        }
 
-        // `split` leaves `i` pointing at the interval starting at `finish`;
-        // move back to the interval finishing at `finish`.
-        i--;
+        if(updates[u].start > pos)
+        {
+          PushPiece(pieces, pos, oldValue, false);
+          pos = updates[u].start;
+        }
+
+        PushPiece(pieces, pos, comp(oldValue, updates[u].value), true);
+        pos = std::min(end, updates[u].finish);
       }
-      i->setValue(comp(i->value(), val));
-      i->mergeLeft();
     }
 
-    // `i` now points to the interval following the last interval whose value was
-    // modified; merge `i` with that last modified interval, if the values match.
-    if(i != end())
-      i->mergeLeft();
+    // splice the rebuilt span back in place of [lo, hi)
+    size_t oldCount = hi - lo;
+    if(pieces.size() > oldCount)
+      StartPoints.insert(StartPoints.begin() + hi, pieces.size() - oldCount,
+                         std::pair<uint64_t, T>(0, T()));
+    else if(pieces.size() < oldCount)
+      StartPoints.erase(StartPoints.begin() + lo + pieces.size(), StartPoints.begin() + hi);
+
+    for(size_t i = 0; i < pieces.size(); i++)
+    {
+      StartPoints[lo + i].first = pieces[i].start;
+      StartPoints[lo + i].second = pieces[i].value;
+    }
   }
 
   // Update `this` by composing the value of each interval with the value of the
@@ -253,39 +319,34 @@ public:
   template <typename Compose>
   void merge(const Intervals &other, Compose comp)
   {
-    auto j = other.begin();
-    auto i = begin();
-
-    // Loop over the intervals in `this` (iterator `i`), while maintaining the
-    // interval `j` in `other` that contains `i`.
-    // The intervals in `this` are split as necessary, so that each `i` is
-    // contained in a single interval of `other`.
-    // Loop invariants:
-    //  * i.start() >= j.start()
-    //  * i.start() < j.end()
+    StartPointArray merged;
+    merged.reserve(StartPoints.size() + other.StartPoints.size());
+
+    // Walk both sets of intervals together, emitting one composed interval for each region between
+    // consecutive boundaries of either. Every value is modified, so adjacent equal values are
+    // always merged.
+    size_t i = 0, j = 0;
+    uint64_t pos = 0;
     while(true)
     {
-      if(i->finish() > j->finish())
-      {
-        i->split(j->finish());
-        i--;
-      }
+      uint64_t iEnd = i + 1 < StartPoints.size() ? StartPoints[i + 1].first : UINT64_MAX;
+      uint64_t jEnd =
+          j + 1 < other.StartPoints.size() ? other.StartPoints[j + 1].first : UINT64_MAX;
 
-      // Now i is contained in j, so we can update the value of all of i
-      i->setValue(comp(i->value(), j->value()));
+      T val = comp(StartPoints[i].second, other.StartPoints[j].second);
+      if(merged.empty() || !(merged.back().second == val))
+        merged.push_back(std::pair<uint64_t, T>(pos, val));
 
-      // The value of i and the interval left of i are now final;
-      // if these two intervals now have the same value, they can safely be
-      // merged into a single interval.
-      i->mergeLeft();
+      pos = std::min(iEnd, jEnd);
+      if(pos == UINT64_MAX)
+        break;
 
-      // Move to the next interval in `this`; also advance to the next interval
-      // in `other`, if necessary to maintain the invariant `i.start < j.end`.
-      i++;
-      if(i == end())
-        return;
-      if(i->start() >= j->finish())
+      if(iEnd == pos)
+        i++;
+      if(jEnd == pos)
         j++;
     }
+
+    StartPoints.swap(merged);
   }
 };
@@ -438,6 +438,84 @@ TEST_CASE("Test Intervals type", "[intervals]")
       check_intervals(test, {{0, 0, 10}, {10, 1, 50}, {50, 0, UINT64_MAX}});
     };
   };
+
+  SECTION("bulk update tests")
+  {
+    SECTION("bulk update with no updates")
+    {
+      Intervals<uint64_t> test = make_intervals({{0, 0, 5}, {5, 1, 10}, {10, 0, UINT64_MAX}});
+      test.update(std::vector<IntervalUpdate<uint64_t> >(),
+                  [](uint64_t x, uint64_t y) -> uint64_t { return x + y; });
+      check_intervals(test, {{0, 0, 5}, {5, 1, 10}, {10, 0, UINT64_MAX}});
+    };
+
+    SECTION("bulk update disjoint ranges")
+    {
+      Intervals<uint64_t> test = make_intervals({{0, 0, 5}, {5, 1, 10}, {10, 0, UINT64_MAX}});
+      test.update({{2, 3, 1}, {7, 12, 1}, {20, 30, 2}},
+                  [](uint64_t x, uint64_t y) -> uint64_t { return x + y; });
+      check_intervals(test, {{0, 0, 2},
+                             {2, 1, 3},
+                             {3, 0, 5},
+                             {5, 1, 7},
+                             {7, 2, 10},
+                             {10, 1, 12},
+                             {12, 0, 20},
+                             {20, 2, 30},
+                             {30, 0, UINT64_MAX}});
+    };
+
+    SECTION("bulk update touching ranges triggering merges")
+    {
+      Intervals<uint64_t> test = make_intervals({{0, 0, 5}, {5, 1, 10}, {10, 0, UINT64_MAX}});
+      test.update({{0, 5, 1}, {5, 10, 0}, {10, 20, 1}, {25, 25, 7}},
+                  [](uint64_t x, uint64_t y) -> uint64_t { return x + y; });
+      check_intervals(test, {{0, 1, 20}, {20, 0, UINT64_MAX}});
+    };
+
+    SECTION("bulk update matches sequential updates")
+    {
+      // simple deterministic LCG so failures are reproducible
+      uint32_t seed = 12345;
+      auto rand = [&seed](uint32_t range) -> uint32_t {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % range;
+      };
+
+      for(int iter = 0; iter < 50; iter++)
+      {
+        Intervals<uint64_t> bulk;
+        for(int i = 0; i < 20; i++)
+        {
+          uint64_t start = rand(100);
+          bulk.update(start, start + rand(10), rand(3),
+                      [](uint64_t x, uint64_t y) -> uint64_t { return y; });
+        }
+        Intervals<uint64_t> sequential = bulk;
+
+        std::vector<IntervalUpdate<uint64_t> > updates;
+        uint64_t pos = 0;
+        for(int i = 0; i < 10; i++)
+        {
+          uint64_t start = pos + rand(8);
+          uint64_t finish = start + rand(8);
+          updates.push_back({start, finish, rand(3)});
+          pos = finish;
+        }
+
+        auto comp = [](uint64_t x, uint64_t y) -> uint64_t { return (x + y) % 3; };
+
+        bulk.update(updates, comp);
+        for(size_t i = 0; i < updates.size(); i++)
+          sequential.update(updates[i].start, updates[i].finish, updates[i].value, comp);
+
+        std::vector<Interval> expected;
+        for(auto it = sequential.begin(); it != sequential.end(); it++)
+          expected.push_back({it->start(), it->value(), it->finish()});
+        check_intervals(bulk, expected);
+      }
+    };
+  };
 };
 
 #endif    // ENABLED(ENABLE_UNIT_TESTS)
\ No newline at end of file
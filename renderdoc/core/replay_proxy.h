@@ -256,7 +256,8 @@ public:
                                 maxval);
     }
 
-    return false;
+    // without a local GPU to proxy with, fetch the data and compute on the CPU
+    return CalcTextureMinMax(this, texid, sliceFace, mip, sample, typeHint, minval, maxval);
   }
 
   bool GetHistogram(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
@@ -272,7 +273,8 @@ public:
                                    maxval, channels, histogram);
     }
 
-    return false;
+    return CalcTextureHistogram(this, texid, sliceFace, mip, sample, typeHint, minval, maxval,
+                                channels, histogram);
   }
 
   bool RenderTexture(TextureDisplay cfg)
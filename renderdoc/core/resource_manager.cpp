@@ -175,3 +175,50 @@ void ResourceRecord::Delete(ResourceRecordHandler *mgr)
     mgr->DestroyResourceRecord(this);
   }
 }
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+TEST_CASE("Composed frame ref transitions match applying refs in turn", "[framerefs]")
+{
+  const int numRefs = eFrameRef_Maximum + 1;
+
+  // every sequence of up to four refs, from every starting state
+  for(int len = 1; len <= 4; len++)
+  {
+    int numSeqs = 1;
+    for(int i = 0; i < len; i++)
+      numSeqs *= numRefs;
+
+    for(int seq = 0; seq < numSeqs; seq++)
+    {
+      FrameRefType refs[4];
+      int s = seq;
+      for(int i = 0; i < len; i++, s /= numRefs)
+        refs[i] = FrameRefType(s % numRefs);
+
+      FrameRefTransition whole, first, second;
+      for(int i = 0; i < len; i++)
+      {
+        whole.Then(refs[i]);
+        if(i < len / 2)
+          first.Then(refs[i]);
+        else
+          second.Then(refs[i]);
+      }
+
+      for(int start = eFrameRef_Minimum; start <= eFrameRef_Maximum; start++)
+      {
+        FrameRefType expected = FrameRefType(start);
+        for(int i = 0; i < len; i++)
+          expected = ComposeFrameRefs(expected, refs[i]);
+
+        CHECK(whole.Apply(FrameRefType(start)) == expected);
+        CHECK(second.Apply(first.Apply(FrameRefType(start))) == expected);
+      }
+    }
+  }
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -111,6 +111,32 @@ FrameRefType ComposeFrameRefs(FrameRefType first, FrameRefType second);
 // reset for replay.
 FrameRefType ComposeFrameRefsUnordered(FrameRefType first, FrameRefType second);
 
+// The effect a sequence of ordered frame refs has on a resource, as the state that each possible
+// starting state ends up in. ComposeFrameRefs isn't associative so a sequence of refs can't be
+// reduced to a single FrameRefType, but these transitions do compose associatively. That lets a
+// sequence be composed once and cached, then applied later with the same result as applying each
+// ref in turn.
+struct FrameRefTransition
+{
+  FrameRefTransition()
+  {
+    for(int i = eFrameRef_Minimum; i <= eFrameRef_Maximum; i++)
+      to[i] = (FrameRefType)i;
+  }
+
+  // appends a ref to the end of the sequence
+  void Then(FrameRefType refType)
+  {
+    for(int i = eFrameRef_Minimum; i <= eFrameRef_Maximum; i++)
+      to[i] = ComposeFrameRefs(to[i], refType);
+  }
+
+  FrameRefType Apply(FrameRefType first) const { return to[first]; }
+  FrameRefType to[eFrameRef_Maximum + 1];
+};
+
+typedef std::map<ResourceId, FrameRefTransition> ComposedFrameRefs;
+
 bool IsDirtyFrameRef(FrameRefType refType);
 
 // Captures the possible initialization/reset requirements for resources.
@@ -378,6 +404,13 @@ struct ResourceRecord
     return MarkResourceFrameReferenced(id, refType, ComposeFrameRefs);
   }
   void AddResourceReferences(ResourceRecordHandler *mgr);
+  // compose this record's refs onto the end of a composed set, in the same order
+  // AddResourceReferences would apply them
+  void AddResourceReferences(ComposedFrameRefs &refs) const
+  {
+    for(auto it = m_FrameRefs.begin(); it != m_FrameRefs.end(); ++it)
+      refs[it->first].Then(it->second);
+  }
   void AddReferencedIDs(std::set<ResourceId> &ids)
   {
     for(auto it = m_FrameRefs.begin(); it != m_FrameRefs.end(); ++it)
@@ -481,6 +514,19 @@ public:
   // clear the list of frame-referenced resources - e.g. if you're about to recapture a frame
   void ClearReferencedResources();
 
+  // returns a counter that changes whenever any frame reference changes. If it's unchanged since
+  // just before a set of references was merged, the merge changed nothing and so the frame's
+  // references are already what merging that set again would produce.
+  uint64_t GetFrameRefGeneration()
+  {
+    SCOPED_LOCK(m_Lock);
+    return m_FrameRefGeneration;
+  }
+
+  // apply a set of refs composed ahead of time. See FrameRefTransition
+  void MarkResourceFrameReferenced(
+      const std::vector<std::pair<ResourceId, FrameRefTransition>> &composedRefs);
+
   // indicates this resource could have been modified by the GPU,
   // so it's now suspect and the data we have on it might well be out of date
   // and to be correct its contents should be serialised out at the start
@@ -564,6 +610,9 @@ protected:
   virtual uint64_t GetSize_InitialState(ResourceId id, const InitialContentData &initial) = 0;
   virtual bool Serialise_InitialState(WriteSerialiser &ser, ResourceId id, RecordType *record,
                                       const InitialContentData *initialData) = 0;
+  // return true if Serialise_InitialState() can be called for different resources on several
+  // threads at once, each with its own serialiser
+  virtual bool Serialise_InitialStateConcurrently() { return false; }
   virtual void Create_InitialState(ResourceId id, WrappedResourceType live, bool hasData) = 0;
   virtual void Apply_InitialState(WrappedResourceType live, const InitialContentData &initial) = 0;
   virtual std::vector<ResourceId> InitialContentResources();
@@ -588,6 +637,9 @@ protected:
   // used during capture - holds resources referenced in current frame (and how they're referenced)
   std::map<ResourceId, FrameRefType> m_FrameReferencedResources;
 
+  // incremented whenever a frame reference is added or changes. See GetFrameRefGeneration()
+  uint64_t m_FrameRefGeneration = 0;
+
   // used during capture - holds resources marked as dirty, needing initial contents
   std::set<ResourceId> m_DirtyResources;
 
@@ -675,7 +727,16 @@ void ResourceManager<Configuration>::MarkResourceFrameReferenced(ResourceId id,
   if(id == ResourceId())
     return;
 
-  bool newRef = MarkReferenced(m_FrameReferencedResources, id, refType, comp);
+  bool changed = false;
+  bool newRef = MarkReferenced(m_FrameReferencedResources, id, refType,
+                               [&changed, comp](FrameRefType first, FrameRefType second) {
+                                 FrameRefType ref = comp(first, second);
+                                 changed |= (ref != first);
+                                 return ref;
+                               });
+
+  if(newRef || changed)
+    m_FrameRefGeneration++;
 
   if(newRef)
   {
@@ -686,6 +747,43 @@ void ResourceManager<Configuration>::MarkResourceFrameReferenced(ResourceId id,
   }
 }
 
+template <typename Configuration>
+void ResourceManager<Configuration>::MarkResourceFrameReferenced(
+    const std::vector<std::pair<ResourceId, FrameRefTransition>> &composedRefs)
+{
+  SCOPED_LOCK(m_Lock);
+
+  bool changed = false;
+
+  for(const std::pair<ResourceId, FrameRefTransition> &ref : composedRefs)
+  {
+    if(ref.first == ResourceId())
+      continue;
+
+    auto refit = m_FrameReferencedResources.find(ref.first);
+
+    if(refit == m_FrameReferencedResources.end())
+    {
+      m_FrameReferencedResources[ref.first] = ref.second.Apply(eFrameRef_None);
+      changed = true;
+
+      RecordType *record = GetResourceRecord(ref.first);
+
+      if(record)
+        record->AddRef();
+    }
+    else
+    {
+      FrameRefType refType = ref.second.Apply(refit->second);
+      changed |= (refType != refit->second);
+      refit->second = refType;
+    }
+  }
+
+  if(changed)
+    m_FrameRefGeneration++;
+}
+
 template <typename Configuration>
 void ResourceManager<Configuration>::MarkResourceFrameReferenced(ResourceId id, FrameRefType refType)
 {
@@ -1017,16 +1115,22 @@ void ResourceManager<Configuration>::InsertInitialContentsChunks(WriteSerialiser
 
   RDCDEBUG("Checking %u resources with initial contents", (uint32_t)m_InitialContents.size());
 
-  float num = float(m_InitialContents.size());
-  float idx = 0.0f;
+  struct InitialChunk
+  {
+    ResourceId id;
+    RecordType *record;
+    const InitialContentData *data;
+    uint64_t size;
+    Chunk *prebuilt;
+    Chunk *built;
+  };
+
+  std::vector<InitialChunk> chunks;
 
   for(auto it = m_InitialContents.begin(); it != m_InitialContents.end(); ++it)
   {
     ResourceId id = it->first;
 
-    RenderDoc::Inst().SetProgress(CaptureProgress::SerialiseInitialStates, idx / num);
-    idx += 1.0f;
-
     if(m_FrameReferencedResources.find(id) == m_FrameReferencedResources.end() &&
        !RenderDoc::Inst().GetCaptureOptions().refAllResources)
     {
@@ -1068,20 +1172,105 @@ void ResourceManager<Configuration>::InsertInitialContentsChunks(WriteSerialiser
       continue;
     }
 
-    if(it->second.chunk)
+    InitialChunk c = {id, record, &it->second.data, 0, it->second.chunk, NULL};
+    if(c.prebuilt == NULL)
+      c.size = GetSize_InitialState(id, it->second.data);
+    chunks.push_back(c);
+  }
+
+  // Chunks are built in memory a batch at a time, on worker threads if the driver allows it, while
+  // the previous batch is compressed and written out on another thread. Batches are written in
+  // resource order so the capture doesn't depend on how the work was spread. Anything too large to
+  // batch is serialised straight into the capture.
+  const uint64_t batchBytes = 32 * 1024 * 1024;
+  const int32_t numWorkers = Serialise_InitialStateConcurrently() ? 4 : 1;
+
+  const uint32_t chunkFlags = ser.GetChunkMetadataRecording();
+  void *userData = ser.GetUserData();
+
+  Threading::ThreadHandle writer = 0;
+
+  auto waitForWriter = [&writer]() {
+    if(writer)
     {
-      it->second.chunk->Write(ser);
+      Threading::JoinThread(writer);
+      Threading::CloseThread(writer);
+      writer = 0;
     }
-    else
+  };
+
+  size_t idx = 0;
+  while(idx < chunks.size())
+  {
+    RenderDoc::Inst().SetProgress(CaptureProgress::SerialiseInitialStates,
+                                  float(idx) / float(chunks.size()));
+
+    if(chunks[idx].prebuilt == NULL && chunks[idx].size > batchBytes)
     {
-      uint64_t size = GetSize_InitialState(id, it->second.data);
+      InitialChunk &c = chunks[idx];
 
-      SCOPED_SERIALISE_CHUNK(SystemChunk::InitialContents, size);
+      waitForWriter();
 
-      Serialise_InitialState(ser, id, record, &it->second.data);
+      SCOPED_SERIALISE_CHUNK(SystemChunk::InitialContents, c.size);
+
+      Serialise_InitialState(ser, c.id, c.record, c.data);
+
+      idx++;
+      continue;
     }
+
+    size_t end = idx;
+    uint64_t size = 0;
+    for(; end < chunks.size(); end++)
+    {
+      if(chunks[end].prebuilt)
+        continue;
+
+      if(chunks[end].size > batchBytes || (size + chunks[end].size > batchBytes && end > idx))
+        break;
+
+      size += chunks[end].size;
+    }
+
+    Threading::ParallelFor(int32_t(end - idx), numWorkers, [&](int32_t i) {
+      InitialChunk &c = chunks[idx + i];
+
+      if(c.prebuilt)
+        return;
+
+      WriteSerialiser scratch(new StreamWriter(c.size + 1024), Ownership::Stream);
+      scratch.SetChunkMetadataRecording(chunkFlags);
+      scratch.SetUserData(userData);
+
+      ScopedChunk scope(scratch, SystemChunk::InitialContents, c.size);
+
+      Serialise_InitialState(scratch, c.id, c.record, c.data);
+
+      c.built = scope.Get();
+    });
+
+    waitForWriter();
+
+    writer = Threading::CreateThread([&ser, &chunks, idx, end]() {
+      for(size_t i = idx; i < end; i++)
+      {
+        if(chunks[i].built)
+        {
+          chunks[i].built->Write(ser);
+          SAFE_DELETE(chunks[i].built);
+        }
+        else
+        {
+          chunks[i].prebuilt->Write(ser);
+        }
+      }
+    });
+
+    idx = end;
   }
 
+  waitForWriter();
+
   RDCDEBUG("Serialised %u resources, skipped %u unreferenced", dirty, skipped);
 }
 
@@ -1124,6 +1313,7 @@ void ResourceManager<Configuration>::ClearReferencedResources()
   }
 
   m_FrameReferencedResources.clear();
+  m_FrameRefGeneration++;
 }
 
 template <typename Configuration>
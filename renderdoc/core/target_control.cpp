@@ -458,6 +458,9 @@ void RenderDoc::TargetControlServerThread(Network::Socket *sock)
     // if we've claimed client status, spawn a thread to communicate
     if(existingClient.empty() || kick)
     {
+      // a connected client may trigger captures, so finish anything deferred by fast start
+      RenderDoc::Inst().CompleteInitialise();
+
       clientThread =
           Threading::CreateThread([version, client] { TargetControlClientThread(version, client); });
       continue;
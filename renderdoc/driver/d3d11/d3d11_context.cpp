@@ -1132,6 +1132,7 @@ ReplayStatus WrappedID3D11DeviceContext::ReplayLog(CaptureState readType, uint32
   ser.SetStringDatabase(&m_StringDB);
   ser.SetUserData(GetResourceManager());
   ser.SetVersion(m_pDevice->GetLogVersion());
+  ser.SetCallstackTable(m_pDevice->GetCallstackTable());
 
   if(IsLoading(m_State) || IsStructuredExporting(m_State))
   {
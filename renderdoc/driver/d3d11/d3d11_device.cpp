@@ -1091,6 +1091,10 @@ ReplayStatus WrappedID3D11Device::ReadLogInitialisation(RDCFile *rdc, bool store
   ser.SetStringDatabase(&m_StringDB);
   ser.SetUserData(GetResourceManager());
 
+  // kept on the driver so the in-frame replay serialisers can expand indices too
+  rdc->ReadCallstackTable(m_Callstacks);
+  ser.SetCallstackTable(&m_Callstacks);
+
   ser.ConfigureStructuredExport(&GetChunkName, storeStructuredBuffers);
 
   m_StructuredFile = &ser.GetStructuredFile();
@@ -1724,6 +1728,10 @@ bool WrappedID3D11Device::EndFrameCapture(void *dev, void *wnd)
 
       ser.SetUserData(GetResourceManager());
 
+      // callstack indices are remapped into the file's own table as chunks are written
+      if(rdc)
+        ser.SetCallstackTable(rdc->GetCallstackTable());
+
       {
         // remember to update this estimated chunk length if you add more parameters
         SCOPED_SERIALISE_CHUNK(SystemChunk::DriverInit, sizeof(D3D11InitParams) + 16);
@@ -2170,12 +2178,21 @@ HRESULT WrappedID3D11Device::Present(WrappedIDXGISwapChain4 *swap, UINT SyncInte
   if(!activeWindow)
     return S_OK;
 
-  // kill any current capture that isn't application defined
+  // kill any current capture that isn't application defined, unless the next frame is to be
+  // captured too. In that case carry on into it and mark the boundary.
   if(IsActiveCapturing(m_State) && !m_AppControlledCapture)
   {
-    m_pImmediateContext->Present(SyncInterval, Flags);
+    if(RenderDoc::Inst().ShouldContinueCapture(m_FrameCounter))
+    {
+      std::wstring name = StringFormat::UTF82Wide(StringFormat::Fmt("Frame %u", m_FrameCounter));
+      m_pImmediateContext->ThreadSafe_SetMarker(0, name.c_str());
+    }
+    else
+    {
+      m_pImmediateContext->Present(SyncInterval, Flags);
 
-    RenderDoc::Inst().EndFrameCapture((ID3D11Device *)this, swapdesc.OutputWindow);
+      RenderDoc::Inst().EndFrameCapture((ID3D11Device *)this, swapdesc.OutputWindow);
+    }
   }
 
   if(IsBackgroundCapturing(m_State) && RenderDoc::Inst().ShouldTriggerCapture(m_FrameCounter))
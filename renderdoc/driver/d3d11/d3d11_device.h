@@ -339,6 +339,8 @@ private:
 
   WriteSerialiser m_ScratchSerialiser;
   std::set<std::string> m_StringDB;
+  // callstacks referenced by chunks in the loaded capture
+  CallstackTable m_Callstacks;
 
   ResourceId m_ResourceID;
   D3D11ResourceRecord *m_DeviceRecord;
@@ -398,6 +400,7 @@ public:
     m_SectionVersion = sectionVersion;
   }
   uint64_t GetLogVersion() { return m_SectionVersion; }
+  CallstackTable *GetCallstackTable() { return &m_Callstacks; }
   virtual ~WrappedID3D11Device();
 
   ////////////////////////////////////////////////////////////////
@@ -704,6 +704,7 @@ ReplayStatus WrappedID3D12CommandQueue::ReplayLog(CaptureState readType, uint32_
   ser.SetStringDatabase(&m_StringDB);
   ser.SetUserData(GetResourceManager());
   ser.SetVersion(m_pDevice->GetLogVersion());
+  ser.SetCallstackTable(m_pDevice->GetCallstackTable());
 
   if(IsLoading(m_State) || IsStructuredExporting(m_State))
   {
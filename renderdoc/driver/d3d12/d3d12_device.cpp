@@ -1409,9 +1409,24 @@ HRESULT WrappedID3D12Device::Present(WrappedIDXGISwapChain4 *swap, UINT SyncInte
   if(!activeWindow)
     return S_OK;
 
-  // kill any current capture that isn't application defined
+  // kill any current capture that isn't application defined, unless the next frame is to be
+  // captured too. In that case carry on into it and mark the boundary.
   if(IsActiveCapturing(m_State) && !m_AppControlledCapture)
-    RenderDoc::Inst().EndFrameCapture((ID3D12Device *)this, swapdesc.OutputWindow);
+  {
+    if(RenderDoc::Inst().ShouldContinueCapture(m_FrameCounter))
+    {
+      WrappedID3D12CommandQueue *queue = m_SwapChains[swap].queue;
+      if(queue == NULL)
+        queue = m_Queue;
+
+      std::string name = StringFormat::Fmt("Frame %u", m_FrameCounter);
+      queue->SetMarker(PIX_EVENT_ANSI_VERSION, name.c_str(), (UINT)name.length());
+    }
+    else
+    {
+      RenderDoc::Inst().EndFrameCapture((ID3D12Device *)this, swapdesc.OutputWindow);
+    }
+  }
 
   if(IsBackgroundCapturing(m_State) && RenderDoc::Inst().ShouldTriggerCapture(m_FrameCounter))
   {
@@ -1771,6 +1786,10 @@ bool WrappedID3D12Device::EndFrameCapture(void *dev, void *wnd)
 
     ser.SetUserData(GetResourceManager());
 
+    // callstack indices are remapped into the file's own table as chunks are written
+    if(rdc)
+      ser.SetCallstackTable(rdc->GetCallstackTable());
+
     {
       SCOPED_SERIALISE_CHUNK(SystemChunk::DriverInit, sizeof(D3D12InitParams));
 
@@ -2804,6 +2823,10 @@ ReplayStatus WrappedID3D12Device::ReadLogInitialisation(RDCFile *rdc, bool store
   ser.SetStringDatabase(&m_StringDB);
   ser.SetUserData(GetResourceManager());
 
+  // kept on the driver so the in-frame replay serialisers can expand indices too
+  rdc->ReadCallstackTable(m_Callstacks);
+  ser.SetCallstackTable(&m_Callstacks);
+
   ser.ConfigureStructuredExport(&GetChunkName, storeStructuredBuffers);
 
   m_StructuredFile = &ser.GetStructuredFile();
@@ -376,6 +376,8 @@ private:
   Chunk *m_HeaderChunk;
 
   std::set<std::string> m_StringDB;
+  // callstacks referenced by chunks in the loaded capture
+  CallstackTable m_Callstacks;
 
   ResourceId m_ResourceID;
   D3D12ResourceRecord *m_DeviceRecord;
@@ -490,6 +492,7 @@ public:
     m_SectionVersion = sectionVersion;
   }
   uint64_t GetLogVersion() { return m_SectionVersion; }
+  CallstackTable *GetCallstackTable() { return &m_Callstacks; }
   CaptureState GetState() { return m_State; }
   D3D12Replay *GetReplay() { return &m_Replay; }
   WrappedID3D12CommandQueue *GetQueue() { return m_Queue; }
@@ -1152,6 +1152,10 @@ bool GLInitParams::IsSupportedVersion(uint64_t ver)
   if(ver == 0x1E)
     return true;
 
+  // 0x1F -> 0x20 - buffer initial states only store the pages that contain non-zero data
+  if(ver == 0x1F)
+    return true;
+
   return false;
 }
 
@@ -588,7 +588,11 @@ WrappedOpenGL::WrappedOpenGL(GLPlatform &platform)
     ResourceIDGen::SetReplayResourceIDs();
   }
 
-  InitSPIRVCompiler();
+  // when capturing, the driver is constructed as soon as the library loads. Wait until a context
+  // is created before initialising the SPIR-V compiler, so processes that never use GL don't pay
+  // for it.
+  if(IsReplayMode(m_State))
+    InitSPIRVCompiler();
   RenderDoc::Inst().RegisterShutdownFunction(&ShutdownSPIRVCompiler);
 
   m_CurrentDefaultFBO = 0;
@@ -848,6 +852,13 @@ GLResourceRecord *WrappedOpenGL::GetContextRecord()
 
 WrappedOpenGL::ContextData &WrappedOpenGL::GetCtxData()
 {
+  GLContextTLSData *tlsData = (GLContextTLSData *)Threading::GetTLSValue(m_CurCtxDataTLS);
+  if(tlsData)
+  {
+    if(tlsData->ctxData == NULL)
+      tlsData->ctxData = &m_ContextData[tlsData->ctxPair.ctx];
+    return *(ContextData *)tlsData->ctxData;
+  }
   return m_ContextData[GetCtx().ctx];
 }
 
@@ -921,6 +932,16 @@ void WrappedOpenGL::DeleteContext(void *contextHandle)
     ctxdata.UnassociateWindow(wndHandle);
   }
 
+  // any thread that still has this context cached must look it up again
+  for(size_t i = 0; i < m_CtxDataVector.size(); i++)
+  {
+    if(m_CtxDataVector[i]->ctxData == &ctxdata)
+    {
+      m_CtxDataVector[i]->ctxData = NULL;
+      m_CtxDataVector[i]->ctxRecord = NULL;
+    }
+  }
+
   m_ContextData.erase(contextHandle);
 }
 
@@ -986,6 +1007,8 @@ void WrappedOpenGL::CreateContext(GLWindowingData winData, void *shareContext,
 
   RenderDoc::Inst().AddDeviceFrameCapturer(ctxdata.ctx, this);
 
+  InitSPIRVCompiler();
+
   // re-configure callstack capture, since WrappedOpenGL constructor may run too early
   uint32_t flags = m_ScratchSerialiser.GetChunkMetadataRecording();
 
@@ -1163,19 +1186,20 @@ void WrappedOpenGL::ActivateContext(GLWindowingData winData)
 
     ctxdata.CreateResourceRecord(this, winData.ctx);
 
-    // update thread-local context pair
+    // update thread-local context pair and cached context data
     {
       GLContextTLSData *tlsData = (GLContextTLSData *)Threading::GetTLSValue(m_CurCtxDataTLS);
 
       if(tlsData)
       {
-        tlsData->ctxPair = {winData.ctx, ShareCtx(winData.ctx)};
+        tlsData->ctxPair = {winData.ctx, ctxdata.shareGroup};
         tlsData->ctxRecord = ctxdata.m_ContextDataRecord;
+        tlsData->ctxData = &ctxdata;
       }
       else
       {
-        tlsData = new GLContextTLSData(ContextPair({winData.ctx, ShareCtx(winData.ctx)}),
-                                       ctxdata.m_ContextDataRecord);
+        tlsData = new GLContextTLSData(ContextPair({winData.ctx, ctxdata.shareGroup}),
+                                       ctxdata.m_ContextDataRecord, &ctxdata);
         m_CtxDataVector.push_back(tlsData);
 
         Threading::SetTLSValue(m_CurCtxDataTLS, tlsData);
@@ -1793,11 +1817,25 @@ void WrappedOpenGL::SwapBuffers(void *windowHandle)
   if(ctxdata.Legacy())
     return;
 
-  // kill any current capture that isn't application defined
+  // kill any current capture that isn't application defined, unless the next frame is to be
+  // captured too. In that case carry on into it and mark the boundary.
   if(IsActiveCapturing(m_State) && !m_AppControlledCapture)
-    RenderDoc::Inst().EndFrameCapture(ctxdata.ctx, windowHandle);
+  {
+    if(RenderDoc::Inst().ShouldContinueCapture(m_FrameCounter))
+    {
+      std::string name = StringFormat::Fmt("Frame %u", m_FrameCounter);
 
-  if(RenderDoc::Inst().ShouldTriggerCapture(m_FrameCounter) && IsBackgroundCapturing(m_State))
+      PUSH_CURRENT_CHUNK;
+      gl_CurChunk = GLChunk::glInsertEventMarkerEXT;
+      glInsertEventMarkerEXT((GLsizei)name.length(), name.c_str());
+    }
+    else
+    {
+      RenderDoc::Inst().EndFrameCapture(ctxdata.ctx, windowHandle);
+    }
+  }
+
+  if(IsBackgroundCapturing(m_State) && RenderDoc::Inst().ShouldTriggerCapture(m_FrameCounter))
   {
     RenderDoc::Inst().StartFrameCapture(ctxdata.ctx, windowHandle);
 
@@ -1976,6 +2014,10 @@ bool WrappedOpenGL::EndFrameCapture(void *dev, void *wnd)
 
       ser.SetUserData(GetResourceManager());
 
+      // callstack indices are remapped into the file's own table as chunks are written
+      if(rdc)
+        ser.SetCallstackTable(rdc->GetCallstackTable());
+
       {
         SCOPED_SERIALISE_CHUNK(SystemChunk::DriverInit, sizeof(GLInitParams) + 16);
 
@@ -2728,11 +2770,22 @@ ReplayStatus WrappedOpenGL::ReadLogInitialisation(RDCFile *rdc, bool storeStruct
     return ReplayStatus::FileIOFailed;
   }
 
+  // read and decompress the section on a worker thread, so it overlaps with processing the chunks
+  {
+    uint64_t sectionSize = reader->GetSize();
+    reader = new StreamReader(new ReadAheadDecompressor(reader, Ownership::Stream), sectionSize,
+                              Ownership::Stream);
+  }
+
   ReadSerialiser ser(reader, Ownership::Stream);
 
   ser.SetStringDatabase(&m_StringDB);
   ser.SetUserData(GetResourceManager());
 
+  // kept on the driver so the in-frame replay serialisers can expand indices too
+  rdc->ReadCallstackTable(m_Callstacks);
+  ser.SetCallstackTable(&m_Callstacks);
+
   ser.ConfigureStructuredExport(&GetChunkName, storeStructuredBuffers);
 
   m_StructuredFile = &ser.GetStructuredFile();
@@ -4437,6 +4490,7 @@ ReplayStatus WrappedOpenGL::ContextReplayLog(CaptureState readType, uint32_t sta
   ser.SetStringDatabase(&m_StringDB);
   ser.SetUserData(GetResourceManager());
   ser.SetVersion(m_SectionVersion);
+  ser.SetCallstackTable(&m_Callstacks);
 
   SDFile *prevFile = m_StructuredFile;
 
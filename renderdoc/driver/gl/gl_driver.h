@@ -52,7 +52,7 @@ struct GLInitParams
   bool isYFlipped;
 
   // check if a frame capture section version is supported
-  static const uint64_t CurrentVersion = 0x1F;
+  static const uint64_t CurrentVersion = 0x20;
   static bool IsSupportedVersion(uint64_t ver);
 };
 
@@ -125,6 +125,8 @@ private:
 
   WriteSerialiser m_ScratchSerialiser;
   std::set<std::string> m_StringDB;
+  // callstacks referenced by chunks in the loaded capture
+  CallstackTable m_Callstacks;
 
   StreamReader *m_FrameReader = NULL;
 
@@ -612,6 +614,9 @@ public:
 
     // used only when we're capturing and don't have driver-side reflection so we need to emulate
     glslang::TShader *glslangShader = NULL;
+    // while capturing the glslang compile is deferred until a program using this shader needs to be
+    // reflected, since applications can compile many shaders they never use in a capture.
+    bool glslangPending = false;
 
     // used for if the application actually uploaded SPIR-V
     std::vector<uint32_t> spirvWords;
@@ -625,6 +630,7 @@ public:
     ShaderBindpointMapping mapping;
 
     void ProcessCompilation(WrappedOpenGL &drv, ResourceId id, GLuint realShader);
+    void ResolveGlslangShader();
     void ProcessSPIRVCompilation(WrappedOpenGL &drv, ResourceId id, GLuint realShader,
                                  const GLchar *pEntryPoint, GLuint numSpecializationConstants,
                                  const GLuint *pConstantIndex, const GLuint *pConstantValue);
@@ -649,8 +655,14 @@ public:
 
     // used only when we're capturing and don't have driver-side reflection so we need to emulate
     glslang::TProgram *glslangProgram = NULL;
+    // as with shaders, the glslang link is deferred while capturing until the program is reflected.
+    // The stageShaders at link time are the dependencies to compile first.
+    bool glslangPending = false;
   };
 
+  void ResolveGlslangProgram(ResourceId id);
+  void ResolveGlslangProgramsUsing(ResourceId shader);
+
   struct PipelineData
   {
     PipelineData()
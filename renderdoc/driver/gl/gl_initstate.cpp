@@ -1218,9 +1218,56 @@ bool GLResourceManager::Serialise_InitialState(SerialiserType &ser, ResourceId i
       }
     }
 
-    // not using SERIALISE_ELEMENT_ARRAY so we can deliberately avoid allocation - we serialise
-    // directly into upload memory
-    ser.Serialise("BufferContents"_lit, BufferContents, BufferContentsSize, SerialiserFlags::NoFlags);
+    if(ser.VersionAtLeast(0x20))
+    {
+      // buffers are often mostly zero, so only the pages containing non-zero data are stored as
+      // offset/size pairs. Everything between them is zero-filled on replay.
+      std::vector<uint64_t> NonZeroRanges;
+
+      if(ser.IsWriting() && BufferContents)
+        FindNonZeroRanges(BufferContents, BufferContentsSize, 4096, NonZeroRanges);
+
+      SERIALISE_ELEMENT(NonZeroRanges);
+
+      uint64_t zeroStart = 0;
+
+      for(size_t i = 0; i + 1 < NonZeroRanges.size(); i += 2)
+      {
+        uint64_t rangeOffset = NonZeroRanges[i];
+        uint64_t rangeSize = NonZeroRanges[i + 1];
+
+        byte *RangeContents = NULL;
+
+        if(BufferContents && rangeOffset >= zeroStart && rangeOffset <= BufferContentsSize &&
+           rangeSize <= BufferContentsSize - rangeOffset)
+        {
+          if(IsReplayingAndReading())
+            memset(BufferContents + zeroStart, 0, size_t(rangeOffset - zeroStart));
+
+          RangeContents = BufferContents + rangeOffset;
+          zeroStart = rangeOffset + rangeSize;
+        }
+        else if(BufferContents)
+        {
+          RDCERR("Invalid non-zero range %llu bytes at %llu in %u bytes of initial contents",
+                 rangeSize, rangeOffset, BufferContentsSize);
+        }
+
+        // not using SERIALISE_ELEMENT_ARRAY so we can deliberately avoid allocation - we
+        // serialise directly into upload memory
+        ser.Serialise("BufferContents"_lit, RangeContents, rangeSize, SerialiserFlags::NoFlags);
+      }
+
+      if(IsReplayingAndReading() && BufferContents)
+        memset(BufferContents + zeroStart, 0, size_t(BufferContentsSize - zeroStart));
+    }
+    else
+    {
+      // not using SERIALISE_ELEMENT_ARRAY so we can deliberately avoid allocation - we serialise
+      // directly into upload memory
+      ser.Serialise("BufferContents"_lit, BufferContents, BufferContentsSize,
+                    SerialiserFlags::NoFlags);
+    }
 
     if(mappedBuffer.name)
       GL.glUnmapNamedBufferEXT(mappedBuffer.name);
@@ -527,32 +527,12 @@ void GLReplay::InitPostVSBuffers(uint32_t eventId)
 
     std::vector<uint32_t> indices;
 
-    uint8_t *idx8 = (uint8_t *)&idxdata[0];
-    uint16_t *idx16 = (uint16_t *)&idxdata[0];
-    uint32_t *idx32 = (uint32_t *)&idxdata[0];
-
     // only read as many indices as were available in the buffer
     uint32_t numIndices =
         RDCMIN(uint32_t(idxdata.size() / drawcall->indexByteWidth), drawcall->numIndices);
 
     // grab all unique vertex indices referenced
-    for(uint32_t i = 0; i < numIndices; i++)
-    {
-      uint32_t i32 = 0;
-      if(drawcall->indexByteWidth == 1)
-        i32 = uint32_t(idx8[i]);
-      else if(drawcall->indexByteWidth == 2)
-        i32 = uint32_t(idx16[i]);
-      else if(drawcall->indexByteWidth == 4)
-        i32 = idx32[i];
-
-      auto it = std::lower_bound(indices.begin(), indices.end(), i32);
-
-      if(it != indices.end() && *it == i32)
-        continue;
-
-      indices.insert(it, i32);
-    }
+    GetUniqueIndices(idxdata.data(), drawcall->indexByteWidth, numIndices, 0, ~0U, indices);
 
     // if we read out of bounds, we'll also have a 0 index being referenced
     // (as 0 is read). Don't insert 0 if we already have 0 though
@@ -570,15 +550,6 @@ void GLReplay::InitPostVSBuffers(uint32_t eventId)
     // so that what did point to 500 points to 0 (accounting for rebasing), and what did point
     // to 510 now points to 3 (accounting for the unique sort).
 
-    // we use a map here since the indices may be sparse. Especially considering if an index
-    // is 'invalid' like 0xcccccccc then we don't want an array of 3.4 billion entries.
-    std::map<uint32_t, size_t> indexRemap;
-    for(size_t i = 0; i < indices.size(); i++)
-    {
-      // by definition, this index will only appear once in indices[]
-      indexRemap[indices[i]] = i;
-    }
-
     // generate a temporary index buffer with our 'unique index set' indices,
     // so we can transform feedback each referenced vertex once
     GLuint indexSetBuffer = 0;
@@ -651,46 +622,9 @@ void GLReplay::InitPostVSBuffers(uint32_t eventId)
     }
 
     // rebase existing index buffer to point from 0 onwards (which will index into our
-    // stream-out'd vertex buffer)
-    if(drawcall->indexByteWidth == 1)
-    {
-      uint8_t stripRestartValue = stripRestartValue32 & 0xff;
-
-      for(uint32_t i = 0; i < numIndices; i++)
-      {
-        // preserve primitive restart indices
-        if(stripRestartValue && idx8[i] == stripRestartValue)
-          continue;
-
-        idx8[i] = uint8_t(indexRemap[idx8[i]]);
-      }
-    }
-    else if(drawcall->indexByteWidth == 2)
-    {
-      uint16_t stripRestartValue = stripRestartValue32 & 0xffff;
-
-      for(uint32_t i = 0; i < numIndices; i++)
-      {
-        // preserve primitive restart indices
-        if(stripRestartValue && idx16[i] == stripRestartValue)
-          continue;
-
-        idx16[i] = uint16_t(indexRemap[idx16[i]]);
-      }
-    }
-    else
-    {
-      uint32_t stripRestartValue = stripRestartValue32;
-
-      for(uint32_t i = 0; i < numIndices; i++)
-      {
-        // preserve primitive restart indices
-        if(stripRestartValue && idx32[i] == stripRestartValue)
-          continue;
-
-        idx32[i] = uint32_t(indexRemap[idx32[i]]);
-      }
-    }
+    // stream-out'd vertex buffer), preserving primitive restart indices
+    RemapIndices(idxdata.data(), drawcall->indexByteWidth, numIndices, indices, 0,
+                 stripRestartValue32);
 
     // make the index buffer that can be used to render this postvs data - the original
     // indices, repointed (since we transform feedback to the start of our feedback
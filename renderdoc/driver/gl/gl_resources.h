@@ -312,8 +312,14 @@ private:
 
 struct GLContextTLSData
 {
-  GLContextTLSData() : ctxPair({NULL, NULL}), ctxRecord(NULL) {}
-  GLContextTLSData(ContextPair p, GLResourceRecord *r) : ctxPair(p), ctxRecord(r) {}
+  GLContextTLSData() : ctxPair({NULL, NULL}), ctxRecord(NULL), ctxData(NULL) {}
+  GLContextTLSData(ContextPair p, GLResourceRecord *r, void *d)
+      : ctxPair(p), ctxRecord(r), ctxData(d)
+  {
+  }
   ContextPair ctxPair;
   GLResourceRecord *ctxRecord;
+  // the driver's ContextData for ctxPair.ctx, cached to avoid a lookup on every call. Opaque here
+  // as it's private to WrappedOpenGL.
+  void *ctxData;
 };
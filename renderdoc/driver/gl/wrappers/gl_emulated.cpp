@@ -2364,6 +2364,9 @@ static glslang::TProgram *GetGlslangProgram(GLuint program, bool *hasRealProgram
 
   ResourceId id = driver->GetResourceManager()->GetID(ProgramRes(driver->GetCtx(), program));
 
+  // link now if it was deferred when the program was linked
+  driver->ResolveGlslangProgram(id);
+
   if(!driver->m_Programs[id].glslangProgram)
   {
     RDCERR("Don't have glslang program for reflecting program %u = %s", program, ToStr(id).c_str());
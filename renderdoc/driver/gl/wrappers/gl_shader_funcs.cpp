@@ -82,6 +82,65 @@ void WrappedOpenGL::ShaderData::ProcessSPIRVCompilation(WrappedOpenGL &drv, Reso
   }
 }
 
+void WrappedOpenGL::ShaderData::ResolveGlslangShader()
+{
+  if(!glslangPending)
+    return;
+
+  glslangPending = false;
+  glslangShader = CompileShaderForReflection(SPIRVShaderStage(ShaderIdx(type)), sources);
+}
+
+void WrappedOpenGL::ResolveGlslangProgram(ResourceId id)
+{
+  ProgramData &progDetails = m_Programs[id];
+
+  if(!progDetails.glslangPending)
+    return;
+
+  progDetails.glslangPending = false;
+
+  std::vector<glslang::TShader *> glslangShaders;
+
+  for(ResourceId shadid : progDetails.stageShaders)
+  {
+    if(shadid == ResourceId())
+      continue;
+
+    ShaderData &shadDetails = m_Shaders[shadid];
+
+    shadDetails.ResolveGlslangShader();
+
+    if(shadDetails.glslangShader == NULL)
+    {
+      RDCERR("Shader attached with no compiled glslang reflection shader!");
+      continue;
+    }
+
+    glslangShaders.push_back(shadDetails.glslangShader);
+  }
+
+  progDetails.glslangProgram = LinkProgramForReflection(glslangShaders);
+}
+
+void WrappedOpenGL::ResolveGlslangProgramsUsing(ResourceId shader)
+{
+  for(auto it = m_Programs.begin(); it != m_Programs.end(); ++it)
+  {
+    if(!it->second.glslangPending)
+      continue;
+
+    for(ResourceId shadid : it->second.stageShaders)
+    {
+      if(shadid == shader)
+      {
+        ResolveGlslangProgram(it->first);
+        break;
+      }
+    }
+  }
+}
+
 void WrappedOpenGL::ShaderData::ProcessCompilation(WrappedOpenGL &drv, ResourceId id,
                                                    GLuint realShader)
 {
@@ -198,7 +257,12 @@ void WrappedOpenGL::ShaderData::ProcessCompilation(WrappedOpenGL &drv, ResourceI
   // if we don't have program_interface_query, need to compile the shader with glslang to be able
   // to reflect with. This is needed on capture or replay
   if(!HasExt[ARB_program_interface_query] && status == 1)
-    glslangShader = CompileShaderForReflection(SPIRVShaderStage(ShaderIdx(type)), sources);
+  {
+    if(IsCaptureMode(drv.GetState()))
+      glslangPending = true;
+    else
+      glslangShader = CompileShaderForReflection(SPIRVShaderStage(ShaderIdx(type)), sources);
+  }
 
   if(IsReplayMode(drv.GetState()) && !drv.IsInternalShader())
   {
@@ -439,6 +503,10 @@ void WrappedOpenGL::glShaderSource(GLuint shader, GLsizei count, const GLchar *c
   if(IsReplayMode(m_State) || !HasExt[ARB_program_interface_query])
   {
     ResourceId id = GetResourceManager()->GetID(ShaderRes(GetCtx(), shader));
+
+    // a deferred glslang compile must use the sources that were actually compiled
+    m_Shaders[id].ResolveGlslangShader();
+
     m_Shaders[id].sources.clear();
     m_Shaders[id].sources.reserve(count);
 
@@ -496,7 +564,17 @@ void WrappedOpenGL::glCompileShader(GLuint shader)
     // if we're capturing and don't have ARB_program_interface_query we're going to have to emulate
     // it using glslang for compilation and reflection
     if(IsReplayMode(m_State) || !HasExt[ARB_program_interface_query])
+    {
+      // programs linked against the previous compile of this shader, that haven't been reflected
+      // yet, must be linked with that version before it's replaced.
+      if(IsCaptureMode(m_State) && (m_Shaders[id].glslangShader || m_Shaders[id].glslangPending))
+      {
+        m_Shaders[id].ResolveGlslangShader();
+        ResolveGlslangProgramsUsing(id);
+      }
+
       m_Shaders[id].ProcessCompilation(*this, id, shader);
+    }
   }
 }
 
@@ -916,24 +994,11 @@ void WrappedOpenGL::glLinkProgram(GLuint program)
 
     if(!HasExt[ARB_program_interface_query])
     {
-      std::vector<glslang::TShader *> glslangShaders;
+      progDetails.glslangPending = true;
 
-      for(ResourceId id : progDetails.stageShaders)
-      {
-        if(id == ResourceId())
-          continue;
-
-        glslang::TShader *s = m_Shaders[id].glslangShader;
-        if(s == NULL)
-        {
-          RDCERR("Shader attached with no compiled glslang reflection shader!");
-          continue;
-        }
-
-        glslangShaders.push_back(m_Shaders[id].glslangShader);
-      }
-
-      progDetails.glslangProgram = LinkProgramForReflection(glslangShaders);
+      // while capturing, wait until the program is reflected before linking it with glslang
+      if(IsReplayMode(m_State))
+        ResolveGlslangProgram(progid);
     }
   }
 }
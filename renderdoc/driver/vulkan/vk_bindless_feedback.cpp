@@ -692,9 +692,9 @@ void VulkanReplay::FetchShaderFeedback(uint32_t eventId)
     const VulkanCreationInfo::ShaderModule &moduleInfo =
         creationInfo.m_ShaderModule[pipeInfo.shaders[5].module];
 
-    std::vector<uint32_t> modSpirv = moduleInfo.spirv.spirv;
+    std::vector<uint32_t> modSpirv = moduleInfo.spirvWords;
 
-    AnnotateShader(*pipeInfo.shaders[5].patchData, stage.pName, offsetMap, bufferAddress, modSpirv);
+    AnnotateShader(*pipeInfo.shaders[5].GetPatchData(), stage.pName, offsetMap, bufferAddress, modSpirv);
 
     moduleCreateInfo.pCode = modSpirv.data();
     moduleCreateInfo.codeSize = modSpirv.size() * sizeof(uint32_t);
@@ -716,9 +716,9 @@ void VulkanReplay::FetchShaderFeedback(uint32_t eventId)
       const VulkanCreationInfo::ShaderModule &moduleInfo =
           creationInfo.m_ShaderModule[pipeInfo.shaders[idx].module];
 
-      std::vector<uint32_t> modSpirv = moduleInfo.spirv.spirv;
+      std::vector<uint32_t> modSpirv = moduleInfo.spirvWords;
 
-      AnnotateShader(*pipeInfo.shaders[idx].patchData, stage.pName, offsetMap, bufferAddress,
+      AnnotateShader(*pipeInfo.shaders[idx].GetPatchData(), stage.pName, offsetMap, bufferAddress,
                      modSpirv);
 
       moduleCreateInfo.pCode = modSpirv.data();
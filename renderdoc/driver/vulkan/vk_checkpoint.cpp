@@ -0,0 +1,494 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include "vk_core.h"
+
+// Replay checkpoints are controlled by two config settings:
+//
+// Replay_CheckpointInterval - the minimum number of events between checkpoints. 0 (the default)
+//                             disables checkpoints entirely.
+// Replay_CheckpointBudgetMB - how much memory all checkpoints together may use. Defaults to 256.
+//
+// Checkpoints are only taken after a queue submit during a non-partial replay, so no command
+// buffer is ever split by one. Each checkpoint holds a GPU copy of every image and buffer that was
+// written or transitioned by the submits since the previous checkpoint, along with the layouts the
+// images were in. Resuming a replay from a checkpoint still processes every chunk from the start of
+// the frame so that CPU-side state like descriptor sets and host memory updates is reconstructed,
+// but submits before the checkpoint are skipped and their results copied back in instead.
+
+static uint32_t GetCheckpointInterval()
+{
+  return (uint32_t)atoi(RenderDoc::Inst().GetConfigSetting("Replay_CheckpointInterval").c_str());
+}
+
+static VkDeviceSize GetCheckpointBudget()
+{
+  int budget = atoi(RenderDoc::Inst().GetConfigSetting("Replay_CheckpointBudgetMB").c_str());
+
+  if(budget <= 0)
+    budget = 256;
+
+  return VkDeviceSize(budget) * 1024 * 1024;
+}
+
+static VkImageAspectFlags GetCopyAspects(VkFormat fmt)
+{
+  if(IsStencilOnlyFormat(fmt))
+    return VK_IMAGE_ASPECT_STENCIL_BIT;
+
+  if(IsDepthOnlyFormat(fmt))
+    return VK_IMAGE_ASPECT_DEPTH_BIT;
+
+  if(IsDepthOrStencilFormat(fmt))
+    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+
+  return VK_IMAGE_ASPECT_COLOR_BIT;
+}
+
+// transitions every tracked subresource of an image into or out of a single layout used for copying
+static void TransitionTrackedLayouts(VkCommandBuffer cmd, VkImage image, const ImageLayouts &layouts,
+                                     VkImageLayout copyLayout, VkAccessFlags copyAccess,
+                                     bool toCopyLayout)
+{
+  std::vector<VkImageMemoryBarrier> barriers;
+  barriers.reserve(layouts.subresourceStates.size());
+
+  for(const ImageRegionState &state : layouts.subresourceStates)
+  {
+    VkImageMemoryBarrier barrier = {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        NULL,
+        0,
+        0,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED,
+        image,
+        state.subresourceRange,
+    };
+
+    if(toCopyLayout)
+    {
+      barrier.srcAccessMask = VK_ACCESS_ALL_WRITE_BITS | MakeAccessMask(state.newLayout);
+      barrier.dstAccessMask = copyAccess;
+      barrier.oldLayout = state.newLayout;
+      barrier.newLayout = copyLayout;
+    }
+    else
+    {
+      barrier.srcAccessMask = copyAccess;
+      barrier.dstAccessMask = VK_ACCESS_ALL_READ_BITS | MakeAccessMask(state.newLayout);
+      barrier.oldLayout = copyLayout;
+      barrier.newLayout = state.newLayout;
+    }
+
+    barriers.push_back(barrier);
+  }
+
+  if(!barriers.empty())
+    DoPipelineBarrier(cmd, (uint32_t)barriers.size(), barriers.data());
+}
+
+static void CopyWholeImage(VkCommandBuffer cmd, VkImage src, VkImage dst,
+                           const VulkanCreationInfo::Image &c)
+{
+  std::vector<VkImageCopy> regions;
+
+  VkImageAspectFlags aspectMask = GetCopyAspects(c.format);
+  VkExtent3D extent = c.extent;
+
+  for(int m = 0; m < c.mipLevels; m++)
+  {
+    VkImageCopy region = {
+        {aspectMask, (uint32_t)m, 0, (uint32_t)c.arrayLayers},
+        {0, 0, 0},
+        {aspectMask, (uint32_t)m, 0, (uint32_t)c.arrayLayers},
+        {0, 0, 0},
+        extent,
+    };
+    regions.push_back(region);
+
+    extent.width = RDCMAX(extent.width >> 1, 1U);
+    extent.height = RDCMAX(extent.height >> 1, 1U);
+    extent.depth = RDCMAX(extent.depth >> 1, 1U);
+  }
+
+  ObjDisp(cmd)->CmdCopyImage(Unwrap(cmd), src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst,
+                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(),
+                             regions.data());
+}
+
+void WrappedVulkan::CreateReplayCheckpoint(uint32_t eventId)
+{
+  uint32_t interval = GetCheckpointInterval();
+
+  if(interval == 0 || m_CheckpointsFailed || m_DrawcallCallback || m_ResumeCheckpoint >= 0)
+    return;
+
+  // the submit must have been replayed in full, not stopped part way through
+  if(eventId > m_LastEventID)
+    return;
+
+  uint32_t prevEventId = m_Checkpoints.empty() ? 0 : m_Checkpoints.back().eventId;
+
+  if(eventId < prevEventId + interval)
+    return;
+
+  std::set<ResourceId> written;
+  for(const rdcpair<uint32_t, std::vector<ResourceId>> &submit : m_SubmitWrites)
+  {
+    if(submit.first >= prevEventId && submit.first < eventId)
+      written.insert(submit.second.begin(), submit.second.end());
+  }
+
+  VkDevice d = GetDev();
+  VkResult vkr = VK_SUCCESS;
+
+  // the replayed submits may have been on other queues
+  ObjDisp(d)->DeviceWaitIdle(Unwrap(d));
+
+  VkCommandBuffer cmd = GetNextCmd();
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  VkMemoryBarrier memBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, VK_ACCESS_ALL_WRITE_BITS, VK_ACCESS_TRANSFER_READ_BIT,
+  };
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  ReplayCheckpoint checkpoint;
+  checkpoint.eventId = eventId;
+
+  VkDeviceSize size = 0;
+  VkDeviceSize budget = GetCheckpointBudget();
+  bool success = true;
+
+  for(ResourceId id : written)
+  {
+    ResourceId origId = GetResourceManager()->GetOriginalID(id);
+
+    if(GetResourceManager()->GetInitialContents(origId).tag == VkInitialContents::Sparse)
+    {
+      RDCWARN("Can't create replay checkpoints for sparse resource %s", ToStr(origId).c_str());
+      success = false;
+      break;
+    }
+
+    auto imit = m_CreationInfo.m_Image.find(id);
+    if(imit != m_CreationInfo.m_Image.end())
+    {
+      const VulkanCreationInfo::Image &c = imit->second;
+      const ImageLayouts &layouts = m_ImageLayouts[id];
+
+      if(IsYUVFormat(c.format) || layouts.queueFamilyIndex != m_QueueFamilyIdx)
+      {
+        RDCWARN("Can't create replay checkpoints for image %s", ToStr(origId).c_str());
+        success = false;
+        break;
+      }
+
+      VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+      // multisampled images need an attachment usage to be creatable
+      if(c.samples != VK_SAMPLE_COUNT_1_BIT)
+        usage |= IsDepthOrStencilFormat(c.format) ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+                                                  : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+      VkImageCreateInfo imInfo = {
+          VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+          NULL,
+          0,
+          c.type,
+          c.format,
+          c.extent,
+          (uint32_t)c.mipLevels,
+          (uint32_t)c.arrayLayers,
+          c.samples,
+          VK_IMAGE_TILING_OPTIMAL,
+          usage,
+          VK_SHARING_MODE_EXCLUSIVE,
+          0,
+          NULL,
+          VK_IMAGE_LAYOUT_UNDEFINED,
+      };
+
+      VkImage snapshot = VK_NULL_HANDLE;
+
+      vkr = vkCreateImage(d, &imInfo, NULL, &snapshot);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      checkpoint.images[id] = {snapshot, layouts};
+
+      VkMemoryRequirements mrq = {};
+      ObjDisp(d)->GetImageMemoryRequirements(Unwrap(d), Unwrap(snapshot), &mrq);
+
+      size += mrq.size;
+      if(m_CheckpointBytes + size > budget)
+      {
+        success = false;
+        break;
+      }
+
+      MemoryAllocation mem =
+          AllocateMemoryForResource(snapshot, MemoryScope::ReplayCheckpoints, MemoryType::GPULocal);
+
+      vkr = vkBindImageMemory(d, snapshot, mem.mem, mem.offs);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      VkImage live = Unwrap(GetResourceManager()->GetCurrentHandle<VkImage>(id));
+
+      VkImageMemoryBarrier snapBarrier = {
+          VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          NULL,
+          0,
+          VK_ACCESS_TRANSFER_WRITE_BIT,
+          VK_IMAGE_LAYOUT_UNDEFINED,
+          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+          VK_QUEUE_FAMILY_IGNORED,
+          VK_QUEUE_FAMILY_IGNORED,
+          Unwrap(snapshot),
+          {GetCopyAspects(c.format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS},
+      };
+
+      DoPipelineBarrier(cmd, 1, &snapBarrier);
+
+      TransitionTrackedLayouts(cmd, live, layouts, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               VK_ACCESS_TRANSFER_READ_BIT, true);
+
+      CopyWholeImage(cmd, live, Unwrap(snapshot), c);
+
+      TransitionTrackedLayouts(cmd, live, layouts, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               VK_ACCESS_TRANSFER_READ_BIT, false);
+
+      // the snapshot stays in transfer source layout from now on
+      snapBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      snapBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+      snapBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      snapBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+      DoPipelineBarrier(cmd, 1, &snapBarrier);
+
+      continue;
+    }
+
+    auto bufit = m_CreationInfo.m_Buffer.find(id);
+    if(bufit != m_CreationInfo.m_Buffer.end())
+    {
+      VkBufferCreateInfo bufInfo = {
+          VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+          NULL,
+          0,
+          bufit->second.size,
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      };
+
+      VkBuffer snapshot = VK_NULL_HANDLE;
+
+      vkr = vkCreateBuffer(d, &bufInfo, NULL, &snapshot);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      checkpoint.buffers[id] = snapshot;
+
+      VkMemoryRequirements mrq = {};
+      ObjDisp(d)->GetBufferMemoryRequirements(Unwrap(d), Unwrap(snapshot), &mrq);
+
+      size += mrq.size;
+      if(m_CheckpointBytes + size > budget)
+      {
+        success = false;
+        break;
+      }
+
+      MemoryAllocation mem =
+          AllocateMemoryForResource(snapshot, MemoryScope::ReplayCheckpoints, MemoryType::GPULocal);
+
+      vkr = vkBindBufferMemory(d, snapshot, mem.mem, mem.offs);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      VkBufferCopy region = {0, 0, bufit->second.size};
+
+      ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd),
+                                  Unwrap(GetResourceManager()->GetCurrentHandle<VkBuffer>(id)),
+                                  Unwrap(snapshot), 1, &region);
+    }
+  }
+
+  memBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  memBarrier.dstAccessMask = VK_ACCESS_ALL_READ_BITS;
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  SubmitCmds();
+  FlushQ();
+
+  if(!success)
+  {
+    // later checkpoints would depend on this one, so stop creating them. The memory already
+    // allocated is only returned when the checkpoints are cleared.
+    RDCLOG("Stopped creating replay checkpoints at event %u, %llu bytes in use", eventId,
+           m_CheckpointBytes);
+
+    for(auto it = checkpoint.images.begin(); it != checkpoint.images.end(); ++it)
+    {
+      ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(it->second.image), NULL);
+      GetResourceManager()->ReleaseWrappedResource(it->second.image);
+    }
+    for(auto it = checkpoint.buffers.begin(); it != checkpoint.buffers.end(); ++it)
+    {
+      ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(it->second), NULL);
+      GetResourceManager()->ReleaseWrappedResource(it->second);
+    }
+
+    m_CheckpointsFailed = true;
+    return;
+  }
+
+  RDCDEBUG("Created replay checkpoint at event %u with %u images and %u buffers, %llu bytes",
+           eventId, (uint32_t)checkpoint.images.size(), (uint32_t)checkpoint.buffers.size(), size);
+
+  m_CheckpointBytes += size;
+  m_Checkpoints.push_back(checkpoint);
+}
+
+void WrappedVulkan::RestoreReplayCheckpoint()
+{
+  int32_t idx = m_ResumeCheckpoint;
+  m_ResumeCheckpoint = -1;
+
+  if(idx < 0 || idx >= (int32_t)m_Checkpoints.size())
+    return;
+
+  // each checkpoint only holds what changed since the previous one, so find the latest snapshot of
+  // every resource up to and including this checkpoint
+  std::map<ResourceId, const ReplayCheckpoint::ImageSnapshot *> images;
+  std::map<ResourceId, VkBuffer> buffers;
+
+  for(int32_t i = idx; i >= 0; i--)
+  {
+    for(auto it = m_Checkpoints[i].images.begin(); it != m_Checkpoints[i].images.end(); ++it)
+      images.insert(std::make_pair(it->first, &it->second));
+    for(auto it = m_Checkpoints[i].buffers.begin(); it != m_Checkpoints[i].buffers.end(); ++it)
+      buffers.insert(*it);
+  }
+
+  VkDevice d = GetDev();
+  VkResult vkr = VK_SUCCESS;
+
+  ObjDisp(d)->DeviceWaitIdle(Unwrap(d));
+
+  VkCommandBuffer cmd = GetNextCmd();
+
+  VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+                                        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+
+  vkr = ObjDisp(cmd)->BeginCommandBuffer(Unwrap(cmd), &beginInfo);
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  VkMemoryBarrier memBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, NULL, VK_ACCESS_ALL_WRITE_BITS,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+  };
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  for(auto it = images.begin(); it != images.end(); ++it)
+  {
+    ResourceId id = it->first;
+    VkImage live = Unwrap(GetResourceManager()->GetCurrentHandle<VkImage>(id));
+
+    // go from the layouts the image is in now, which are the ones from the start of the frame, to
+    // the layouts it was in when the snapshot was taken
+    TransitionTrackedLayouts(cmd, live, m_ImageLayouts[id], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                             VK_ACCESS_TRANSFER_WRITE_BIT, true);
+
+    CopyWholeImage(cmd, Unwrap(it->second->image), live, m_CreationInfo.m_Image[id]);
+
+    TransitionTrackedLayouts(cmd, live, it->second->layouts, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                             VK_ACCESS_TRANSFER_WRITE_BIT, false);
+
+    m_ImageLayouts[id] = it->second->layouts;
+  }
+
+  for(auto it = buffers.begin(); it != buffers.end(); ++it)
+  {
+    VkBufferCopy region = {0, 0, m_CreationInfo.m_Buffer[it->first].size};
+
+    ObjDisp(cmd)->CmdCopyBuffer(Unwrap(cmd), Unwrap(it->second),
+                                Unwrap(GetResourceManager()->GetCurrentHandle<VkBuffer>(it->first)),
+                                1, &region);
+  }
+
+  memBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  memBarrier.dstAccessMask = VK_ACCESS_ALL_READ_BITS;
+
+  DoPipelineBarrier(cmd, 1, &memBarrier);
+
+  vkr = ObjDisp(cmd)->EndCommandBuffer(Unwrap(cmd));
+  RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+  SubmitCmds();
+  FlushQ();
+
+  RDCDEBUG("Resumed replay from checkpoint at event %u, restoring %u images and %u buffers",
+           m_Checkpoints[idx].eventId, (uint32_t)images.size(), (uint32_t)buffers.size());
+}
+
+void WrappedVulkan::ClearReplayCheckpoints()
+{
+  if(!m_Checkpoints.empty())
+  {
+    VkDevice d = GetDev();
+
+    ObjDisp(d)->DeviceWaitIdle(Unwrap(d));
+
+    for(ReplayCheckpoint &checkpoint : m_Checkpoints)
+    {
+      for(auto it = checkpoint.images.begin(); it != checkpoint.images.end(); ++it)
+      {
+        ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(it->second.image), NULL);
+        GetResourceManager()->ReleaseWrappedResource(it->second.image);
+      }
+      for(auto it = checkpoint.buffers.begin(); it != checkpoint.buffers.end(); ++it)
+      {
+        ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(it->second), NULL);
+        GetResourceManager()->ReleaseWrappedResource(it->second);
+      }
+    }
+  }
+
+  m_Checkpoints.clear();
+  m_CheckpointBytes = 0;
+  m_CheckpointsFailed = false;
+
+  FreeAllMemory(MemoryScope::ReplayCheckpoints);
+}
@@ -320,6 +320,7 @@ enum class MemoryScope : uint8_t
   InitialContents,
   First = InitialContents,
   IndirectReadback,
+  ReplayCheckpoints,
   Count,
 };
 
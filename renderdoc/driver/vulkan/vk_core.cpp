@@ -110,6 +110,9 @@ WrappedVulkan::WrappedVulkan() : m_RenderState(this, &m_CreationInfo)
 
   m_SectionVersion = VkInitParams::CurrentVersion;
 
+  // the instance is created before any device, and may already record chunks with callstacks
+  RenderDoc::Inst().CompleteInitialise();
+
   InitSPIRVCompiler();
   RenderDoc::Inst().RegisterShutdownFunction(&ShutdownSPIRVCompiler);
 
@@ -167,6 +170,8 @@ WrappedVulkan::WrappedVulkan() : m_RenderState(this, &m_CreationInfo)
 
 WrappedVulkan::~WrappedVulkan()
 {
+  StopReflectionPrewarm();
+
   // records must be deleted before resource manager shutdown
   if(m_FrameCaptureRecord)
   {
@@ -1411,6 +1416,7 @@ void WrappedVulkan::StartFrameCapture(void *dev, void *wnd)
 
   GetResourceManager()->ClearReferencedResources();
   GetResourceManager()->ClearReferencedMemory();
+  GetResourceManager()->ClearReferencedImageSubresources();
 
   GetResourceManager()->MarkResourceFrameReferenced(GetResID(m_Instance), eFrameRef_Read);
   GetResourceManager()->MarkResourceFrameReferenced(GetResID(m_Device), eFrameRef_Read);
@@ -1466,6 +1472,9 @@ void WrappedVulkan::StartFrameCapture(void *dev, void *wnd)
 
     GetResourceManager()->PrepareInitialContents();
 
+    // wait for any batched initial state readbacks to complete
+    FlushInitialStatePrepares();
+
     RDCDEBUG("Attempting capture");
     m_FrameCaptureRecord->DeleteChunks();
 
@@ -1795,6 +1804,10 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
     ser.SetUserData(GetResourceManager());
 
+    // callstack indices are remapped into the file's own table as chunks are written
+    if(rdc)
+      ser.SetCallstackTable(rdc->GetCallstackTable());
+
     {
       SCOPED_SERIALISE_CHUNK(SystemChunk::DriverInit, m_InitParams.GetSerialiseSize());
 
@@ -1805,8 +1818,12 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
 
     GetResourceManager()->InsertReferencedChunks(ser);
 
+    GetResourceManager()->MarkReferencedImageViews();
+
     GetResourceManager()->InsertInitialContentsChunks(ser);
 
+    UnmapInitialStateReadbacks();
+
     RDCDEBUG("Creating Capture Scope");
 
     GetResourceManager()->Serialise_InitialContentsNeeded(ser);
@@ -1874,6 +1891,7 @@ bool WrappedVulkan::EndFrameCapture(void *dev, void *wnd)
   GetResourceManager()->MarkUnwrittenResources();
 
   GetResourceManager()->ClearReferencedMemory();
+  GetResourceManager()->ClearReferencedImageSubresources();
 
   GetResourceManager()->ClearReferencedResources();
 
@@ -1941,7 +1959,7 @@ void WrappedVulkan::AdvanceFrame()
   m_FrameCounter++;    // first present becomes frame #1, this function is at the end of the frame
 }
 
-void WrappedVulkan::Present(void *dev, void *wnd)
+void WrappedVulkan::Present(VkQueue queue, void *dev, void *wnd)
 {
   bool activeWindow = wnd == NULL || RenderDoc::Inst().IsActiveWindow(dev, wnd);
 
@@ -1950,9 +1968,30 @@ void WrappedVulkan::Present(void *dev, void *wnd)
     return;
 
   if(IsActiveCapturing(m_State) && !m_AppControlledCapture)
-    RenderDoc::Inst().EndFrameCapture(dev, wnd);
+  {
+    // if the next frame is to be captured too, carry on into it and mark the boundary
+    if(RenderDoc::Inst().ShouldContinueCapture(m_FrameCounter))
+    {
+      std::string name = StringFormat::Fmt("Frame %u", m_FrameCounter);
+
+      VkDebugUtilsLabelEXT label = {VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
+      label.pLabelName = name.c_str();
+
+      CACHE_THREAD_SERIALISER();
+      ser.SetDrawChunk();
+      SCOPED_SERIALISE_CHUNK(VulkanChunk::vkQueueInsertDebugUtilsLabelEXT);
+      Serialise_vkQueueInsertDebugUtilsLabelEXT(ser, queue, &label);
+
+      m_FrameCaptureRecord->AddChunk(scope.Get());
+      GetResourceManager()->MarkResourceFrameReferenced(GetResID(queue), eFrameRef_Read);
+    }
+    else
+    {
+      RenderDoc::Inst().EndFrameCapture(dev, wnd);
+    }
+  }
 
-  if(RenderDoc::Inst().ShouldTriggerCapture(m_FrameCounter) && IsBackgroundCapturing(m_State))
+  if(IsBackgroundCapturing(m_State) && RenderDoc::Inst().ShouldTriggerCapture(m_FrameCounter))
   {
     RenderDoc::Inst().StartFrameCapture(dev, wnd);
 
@@ -1990,6 +2029,49 @@ void WrappedVulkan::AddResourceCurChunk(ResourceId id)
   AddResourceCurChunk(GetReplay()->GetResourceDesc(id));
 }
 
+void WrappedVulkan::StartReflectionPrewarm()
+{
+  StopReflectionPrewarm();
+
+  // gather the shaders here, since the creation info can be added to while the thread runs. The
+  // shaders themselves never move once created.
+  std::vector<const VulkanCreationInfo::Pipeline::Shader *> shaders;
+
+  for(auto it = m_CreationInfo.m_Pipeline.begin(); it != m_CreationInfo.m_Pipeline.end(); ++it)
+  {
+    for(size_t i = 0; i < ARRAY_COUNT(it->second.shaders); i++)
+    {
+      if(it->second.shaders[i].module != ResourceId())
+        shaders.push_back(&it->second.shaders[i]);
+    }
+  }
+
+  if(shaders.empty())
+    return;
+
+  m_ReflectionPrewarmShutdown = false;
+  m_ReflectionPrewarmThread = Threading::CreateThread([this, shaders]() {
+    for(const VulkanCreationInfo::Pipeline::Shader *sh : shaders)
+    {
+      if(m_ReflectionPrewarmShutdown)
+        break;
+
+      sh->GetReflection();
+    }
+  });
+}
+
+void WrappedVulkan::StopReflectionPrewarm()
+{
+  if(m_ReflectionPrewarmThread)
+  {
+    m_ReflectionPrewarmShutdown = true;
+    Threading::JoinThread(m_ReflectionPrewarmThread);
+    Threading::CloseThread(m_ReflectionPrewarmThread);
+    m_ReflectionPrewarmThread = 0;
+  }
+}
+
 ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers)
 {
   int sectionIdx = rdc->SectionIndex(SectionType::FrameCapture);
@@ -2007,11 +2089,22 @@ ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStruct
     return ReplayStatus::FileIOFailed;
   }
 
+  // read and decompress the section on a worker thread, so it overlaps with processing the chunks
+  {
+    uint64_t sectionSize = reader->GetSize();
+    reader = new StreamReader(new ReadAheadDecompressor(reader, Ownership::Stream), sectionSize,
+                              Ownership::Stream);
+  }
+
   ReadSerialiser ser(reader, Ownership::Stream);
 
   ser.SetStringDatabase(&m_StringDB);
   ser.SetUserData(GetResourceManager());
 
+  // kept on the driver so the in-frame replay serialisers can expand indices too
+  rdc->ReadCallstackTable(m_Callstacks);
+  ser.SetCallstackTable(&m_Callstacks);
+
   ser.ConfigureStructuredExport(&GetChunkName, storeStructuredBuffers);
 
   m_StructuredFile = &ser.GetStructuredFile();
@@ -2080,6 +2173,9 @@ ReplayStatus WrappedVulkan::ReadLogInitialisation(RDCFile *rdc, bool storeStruct
 
       m_FrameReader = new StreamReader(reader, frameDataSize);
 
+      if(IsReplayMode(m_State))
+        StartReflectionPrewarm();
+
       ReplayStatus status = ContextReplayLog(m_State, 0, 0, false);
 
       if(status != ReplayStatus::Succeeded)
@@ -2156,6 +2252,7 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
   ser.SetStringDatabase(&m_StringDB);
   ser.SetUserData(GetResourceManager());
   ser.SetVersion(m_SectionVersion);
+  ser.SetCallstackTable(&m_Callstacks);
 
   SDFile *prevFile = m_StructuredFile;
 
@@ -2235,6 +2332,10 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
       break;
     }
 
+    // when resuming from a checkpoint, everything skipped up to here is copied back in at once
+    if(m_ResumeCheckpoint >= 0 && m_RootEventID >= m_ResumeEventID)
+      RestoreReplayCheckpoint();
+
     m_CurChunkOffset = ser.GetReader()->GetOffset();
 
     VulkanChunk chunktype = ser.ReadChunk<VulkanChunk>();
@@ -2288,6 +2389,10 @@ ReplayStatus WrappedVulkan::ContextReplayLog(CaptureState readType, uint32_t sta
          chunktype != VulkanChunk::vkEndCommandBuffer)
         m_BakedCmdBufferInfo[m_LastCmdBufferID].curEventID++;
     }
+
+    // submits are the only place we can take a checkpoint without splitting a command buffer
+    if(!partial && IsActiveReplaying(m_State) && chunktype == VulkanChunk::vkQueueSubmit)
+      CreateReplayCheckpoint(m_RootEventID);
   }
 
   if(!partial && !IsStructuredExporting(m_State))
@@ -3022,6 +3127,22 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 
     SubmitCmds();
     FlushQ();
+
+    // resume from the latest checkpoint we don't replay past. Drawcall callbacks need to see every
+    // event, so they always replay from the start.
+    uint32_t lastEventID = endEventID;
+    if(replayType == eReplay_WithoutDraw)
+      lastEventID = RDCMAX(1U, endEventID) - 1;
+
+    for(int32_t i = (int32_t)m_Checkpoints.size() - 1; m_DrawcallCallback == NULL && i >= 0; i--)
+    {
+      if(m_Checkpoints[i].eventId <= lastEventID)
+      {
+        m_ResumeCheckpoint = i;
+        m_ResumeEventID = m_Checkpoints[i].eventId;
+        break;
+      }
+    }
   }
 
   m_State = CaptureState::ActiveReplaying;
@@ -3114,6 +3235,9 @@ void WrappedVulkan::ReplayLog(uint32_t startEventID, uint32_t endEventID, Replay
 
     RDCASSERTEQUAL(status, ReplayStatus::Succeeded);
 
+    m_ResumeCheckpoint = -1;
+    m_ResumeEventID = 0;
+
     if(m_OutsideCmdBuffer != VK_NULL_HANDLE)
     {
       VkCommandBuffer cmd = m_OutsideCmdBuffer;
@@ -3517,6 +3641,30 @@ VkCommandBuffer WrappedVulkan::RerecordCmdBuf(ResourceId cmdid, PartialReplayInd
   return it->second;
 }
 
+static bool IsReadOnlyUsage(ResourceUsage usage)
+{
+  if(usage >= ResourceUsage::VS_Constants && usage <= ResourceUsage::All_Constants)
+    return true;
+
+  if(usage >= ResourceUsage::VS_Resource && usage <= ResourceUsage::All_Resource)
+    return true;
+
+  switch(usage)
+  {
+    case ResourceUsage::Unused:
+    case ResourceUsage::VertexBuffer:
+    case ResourceUsage::IndexBuffer:
+    case ResourceUsage::InputTarget:
+    case ResourceUsage::Indirect:
+    case ResourceUsage::ResolveSrc:
+    case ResourceUsage::CopySrc:
+    case ResourceUsage::Barrier: return true;
+    default: break;
+  }
+
+  return false;
+}
+
 void WrappedVulkan::AddDrawcall(const DrawcallDescription &d, bool hasEvents)
 {
   m_AddedDrawcall = true;
@@ -3610,8 +3758,16 @@ void WrappedVulkan::AddDrawcall(const DrawcallDescription &d, bool hasEvents)
     node.resourceUsage.swap(m_BakedCmdBufferInfo[m_LastCmdBufferID].resourceUsage);
 
     if(m_LastCmdBufferID != ResourceId())
+    {
       AddUsage(node, m_BakedCmdBufferInfo[m_LastCmdBufferID].debugMessages);
 
+      // anything the drawcall doesn't only read needs to be saved in replay checkpoints
+      std::set<ResourceId> &written = m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources;
+      for(const rdcpair<ResourceId, EventUsage> &u : node.resourceUsage)
+        if(!IsReadOnlyUsage(u.second.usage))
+          written.insert(u.first);
+    }
+
     node.children.insert(node.children.begin(), draw.children.begin(), draw.children.end());
     GetDrawcallStack().back()->children.push_back(node);
   }
@@ -3674,7 +3830,10 @@ void WrappedVulkan::AddUsage(VulkanDrawcallTreeNode &drawNode,
     const std::vector<BakedCmdBufferInfo::CmdBufferState::DescriptorAndOffsets> &descSets =
         (shad == 5 ? state.computeDescSets : state.graphicsDescSets);
 
-    RDCASSERT(sh.mapping);
+    ShaderBindpointMapping *mapping = sh.GetMapping();
+    ShaderReflection *refl = sh.GetReflection();
+
+    RDCASSERT(mapping);
 
     struct ResUsageType
     {
@@ -3684,9 +3843,9 @@ void WrappedVulkan::AddUsage(VulkanDrawcallTreeNode &drawNode,
     };
 
     ResUsageType types[] = {
-        ResUsageType(sh.mapping->readOnlyResources, ResourceUsage::VS_Resource),
-        ResUsageType(sh.mapping->readWriteResources, ResourceUsage::VS_RWResource),
-        ResUsageType(sh.mapping->constantBlocks, ResourceUsage::VS_Constants),
+        ResUsageType(mapping->readOnlyResources, ResourceUsage::VS_Resource),
+        ResUsageType(mapping->readWriteResources, ResourceUsage::VS_RWResource),
+        ResUsageType(mapping->constantBlocks, ResourceUsage::VS_Constants),
     };
 
     DebugMessage msg;
@@ -3704,7 +3863,7 @@ void WrappedVulkan::AddUsage(VulkanDrawcallTreeNode &drawNode,
           continue;
 
         // ignore push constants
-        if(t == 2 && !sh.refl->constantBlocks[i].bufferBacked)
+        if(t == 2 && !refl->constantBlocks[i].bufferBacked)
           continue;
 
         int32_t bindset = types[t].bindmap[i].bindset;
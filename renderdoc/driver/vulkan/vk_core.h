@@ -52,7 +52,7 @@ struct VkInitParams
   uint64_t GetSerialiseSize();
 
   // check if a frame capture section version is supported
-  static const uint64_t CurrentVersion = 0xF;
+  static const uint64_t CurrentVersion = 0x10;
   static bool IsSupportedVersion(uint64_t ver);
 };
 
@@ -278,6 +278,8 @@ private:
   StreamReader *m_FrameReader = NULL;
 
   std::set<std::string> m_StringDB;
+  // callstacks referenced by chunks in the loaded capture
+  CallstackTable m_Callstacks;
 
   VkResourceRecord *m_FrameCaptureRecord;
   Chunk *m_HeaderChunk;
@@ -486,6 +488,71 @@ private:
   std::vector<VkEvent> m_CleanupEvents;
   std::vector<VkEvent> m_PersistentEvents;
 
+  // Temporary objects created while preparing initial states. The readback copies are batched up
+  // and only submitted and waited on every few resources, so these can't be destroyed until the
+  // batch has completed in FlushInitialStatePrepares()
+  std::vector<VkBuffer> m_PrepareInitStateBuffers;
+  std::vector<VkImage> m_PrepareInitStateImages;
+  uint32_t m_PendingInitStatePrepares = 0;
+
+  void AddPendingInitialStatePrepare();
+  void FlushInitialStatePrepares();
+
+  // Readback memory mapped while serialising initial states. Several resources share each
+  // allocation and may be serialised on different threads, so each allocation is mapped once and
+  // stays mapped until UnmapInitialStateReadbacks()
+  Threading::CriticalSection m_InitStateMapLock;
+  std::map<VkDeviceMemory, byte *> m_InitStateMaps;
+
+  byte *MapInitialStateReadback(const MemoryAllocation &mem);
+  void UnmapInitialStateReadbacks();
+
+  // removes the parts of an image's initial contents that no view or command in the frame
+  // references from a list of offset/size pairs
+  void RemoveUnreferencedSubresources(ResourceId id, std::vector<uint64_t> &ranges);
+
+  // builds shader reflection for every pipeline on a background thread after loading, so it's
+  // usually ready by the time it's first looked at
+  Threading::ThreadHandle m_ReflectionPrewarmThread = 0;
+  volatile bool m_ReflectionPrewarmShutdown = false;
+
+  void StartReflectionPrewarm();
+  void StopReflectionPrewarm();
+
+  // Replay checkpoints. While replaying the whole frame we snapshot the images and buffers written
+  // since the previous checkpoint after every few queue submits, so that seeking can restore the
+  // nearest earlier checkpoint and skip submitting everything before it.
+  struct ReplayCheckpoint
+  {
+    // the root event the checkpoint was taken before
+    uint32_t eventId = 0;
+
+    struct ImageSnapshot
+    {
+      VkImage image;
+      ImageLayouts layouts;
+    };
+    std::map<ResourceId, ImageSnapshot> images;
+    std::map<ResourceId, VkBuffer> buffers;
+  };
+  std::vector<ReplayCheckpoint> m_Checkpoints;
+
+  // the memory used by all checkpoints, compared against the budget
+  VkDeviceSize m_CheckpointBytes = 0;
+
+  // set if a checkpoint couldn't be created, no more are created until they're cleared
+  bool m_CheckpointsFailed = false;
+
+  // the checkpoint a non-partial replay is resuming from, or -1 if it replays from the start
+  int32_t m_ResumeCheckpoint = -1;
+  uint32_t m_ResumeEventID = 0;
+
+  // for each queue submit recorded while loading, the event ID and the resources it writes
+  std::vector<rdcpair<uint32_t, std::vector<ResourceId>>> m_SubmitWrites;
+
+  void CreateReplayCheckpoint(uint32_t eventId);
+  void RestoreReplayCheckpoint();
+
   const VkFormatProperties &GetFormatProperties(VkFormat f)
   {
     return m_PhysicalDeviceData.fmtprops[f];
@@ -523,6 +590,9 @@ private:
 
     std::vector<rdcpair<ResourceId, EventUsage>> resourceUsage;
 
+    // resources this command buffer may write, for replay checkpoints
+    std::set<ResourceId> writtenResources;
+
     struct CmdBufferState
     {
       ResourceId pipeline;
@@ -811,7 +881,7 @@ private:
   bool DiscardFrameCapture(void *dev, void *wnd);
 
   void AdvanceFrame();
-  void Present(void *dev, void *wnd);
+  void Present(VkQueue queue, void *dev, void *wnd);
 
   void HandleVRFrameMarkers(const char *marker, VkCommandBuffer commandBuffer);
 
@@ -934,6 +1004,7 @@ public:
   }
   void Shutdown();
   void ReplayLog(uint32_t startEventID, uint32_t endEventID, ReplayLogType replayType);
+  void ClearReplayCheckpoints();
   ReplayStatus ReadLogInitialisation(RDCFile *rdc, bool storeStructuredBuffers);
 
   SDFile &GetStructuredFile() { return *m_StructuredFile; }
@@ -1634,6 +1634,7 @@ void VulkanReplay::DestroyResources()
 {
   ClearPostVSCache();
   ClearFeedbackCache();
+  ClearPipelineStateCache();
 
   m_General.Destroy(m_pDriver);
   m_TexRender.Destroy(m_pDriver);
@@ -2578,6 +2579,8 @@ void VulkanReplay::PostVS::Destroy(WrappedVulkan *driver)
 {
   if(XFBQueryPool != VK_NULL_HANDLE)
     driver->vkDestroyQueryPool(driver->GetDev(), XFBQueryPool, NULL);
+
+  SAFE_DELETE(DiskCache);
 }
 
 void VulkanReplay::Feedback::Destroy(WrappedVulkan *driver)
@@ -232,10 +232,9 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
     shad.module = id;
     shad.entryPoint = pCreateInfo->pStages[i].pName;
 
-    ShaderModule::Reflection &reflData = info.m_ShaderModule[id].m_Reflections[shad.entryPoint];
-
-    reflData.Init(resourceMan, id, info.m_ShaderModule[id].spirv, shad.entryPoint,
-                  pCreateInfo->pStages[i].stage);
+    shad.moduleInfo = &info.m_ShaderModule[id];
+    shad.originalModule = resourceMan->GetOriginalID(id);
+    shad.stage = pCreateInfo->pStages[i].stage;
 
     if(pCreateInfo->pStages[i].pSpecializationInfo)
     {
@@ -251,10 +250,6 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
         shad.specialization.push_back(spec);
       }
     }
-
-    shad.refl = &reflData.refl;
-    shad.mapping = &reflData.mapping;
-    shad.patchData = &reflData.patchData;
   }
 
   if(pCreateInfo->pVertexInputState)
@@ -539,10 +534,9 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
     shad.module = id;
     shad.entryPoint = pCreateInfo->stage.pName;
 
-    ShaderModule::Reflection &reflData = info.m_ShaderModule[id].m_Reflections[shad.entryPoint];
-
-    reflData.Init(resourceMan, id, info.m_ShaderModule[id].spirv, shad.entryPoint,
-                  pCreateInfo->stage.stage);
+    shad.moduleInfo = &info.m_ShaderModule[id];
+    shad.originalModule = resourceMan->GetOriginalID(id);
+    shad.stage = pCreateInfo->stage.stage;
 
     if(pCreateInfo->stage.pSpecializationInfo)
     {
@@ -558,10 +552,6 @@ void VulkanCreationInfo::Pipeline::Init(VulkanResourceManager *resourceMan, Vulk
         shad.specialization.push_back(spec);
       }
     }
-
-    shad.refl = &reflData.refl;
-    shad.mapping = &reflData.mapping;
-    shad.patchData = &reflData.patchData;
   }
 
   topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -978,6 +968,30 @@ void VulkanCreationInfo::ImageView::Init(VulkanResourceManager *resourceMan, Vul
   swizzle[3] = Convert(pCreateInfo->components.a, 3);
 }
 
+ShaderReflection *VulkanCreationInfo::Pipeline::Shader::GetReflection() const
+{
+  if(!moduleInfo)
+    return NULL;
+
+  return &moduleInfo->GetReflection(originalModule, entryPoint, stage).refl;
+}
+
+ShaderBindpointMapping *VulkanCreationInfo::Pipeline::Shader::GetMapping() const
+{
+  if(!moduleInfo)
+    return NULL;
+
+  return &moduleInfo->GetReflection(originalModule, entryPoint, stage).mapping;
+}
+
+SPIRVPatchData *VulkanCreationInfo::Pipeline::Shader::GetPatchData() const
+{
+  if(!moduleInfo)
+    return NULL;
+
+  return &moduleInfo->GetReflection(originalModule, entryPoint, stage).patchData;
+}
+
 void VulkanCreationInfo::ShaderModule::Init(VulkanResourceManager *resourceMan,
                                             VulkanCreationInfo &info,
                                             const VkShaderModuleCreateInfo *pCreateInfo)
@@ -990,12 +1004,50 @@ void VulkanCreationInfo::ShaderModule::Init(VulkanResourceManager *resourceMan,
   else
   {
     RDCASSERT(pCreateInfo->codeSize % sizeof(uint32_t) == 0);
-    ParseSPIRV((uint32_t *)pCreateInfo->pCode, pCreateInfo->codeSize / sizeof(uint32_t), spirv);
+    spirvWords.assign(pCreateInfo->pCode,
+                      pCreateInfo->pCode + pCreateInfo->codeSize / sizeof(uint32_t));
   }
 }
 
-void VulkanCreationInfo::ShaderModule::Reflection::Init(VulkanResourceManager *resourceMan,
-                                                        ResourceId id, const SPVModule &spv,
+SPVModule &VulkanCreationInfo::ShaderModule::GetParsedSPIRV()
+{
+  if(!parsed)
+  {
+    parsed = true;
+
+    if(!spirvWords.empty())
+      ParseSPIRV(spirvWords.data(), spirvWords.size(), spirv);
+  }
+
+  return spirv;
+}
+
+const SPVModule &VulkanCreationInfo::ShaderModule::GetSPIRV()
+{
+  SCOPED_LOCK(lock);
+  return GetParsedSPIRV();
+}
+
+std::string VulkanCreationInfo::ShaderModule::Disassemble(const std::string &entry)
+{
+  SCOPED_LOCK(lock);
+  return GetParsedSPIRV().Disassemble(entry);
+}
+
+VulkanCreationInfo::ShaderModule::Reflection &VulkanCreationInfo::ShaderModule::GetReflection(
+    ResourceId originalId, const std::string &entry, VkShaderStageFlagBits stage)
+{
+  SCOPED_LOCK(lock);
+
+  Reflection &reflData = m_Reflections[std::make_pair(entry, (uint32_t)StageIndex(stage))];
+
+  if(reflData.entryPoint.empty())
+    reflData.Init(originalId, GetParsedSPIRV(), entry, stage);
+
+  return reflData;
+}
+
+void VulkanCreationInfo::ShaderModule::Reflection::Init(ResourceId originalId, const SPVModule &spv,
                                                         const std::string &entry,
                                                         VkShaderStageFlagBits stage)
 {
@@ -1007,7 +1059,7 @@ void VulkanCreationInfo::ShaderModule::Reflection::Init(VulkanResourceManager *r
     spv.MakeReflection(GraphicsAPI::Vulkan, ShaderStage(stageIndex), entryPoint, refl, mapping,
                        patchData);
 
-    refl.resourceId = resourceMan->GetOriginalID(id);
+    refl.resourceId = originalId;
     refl.entryPoint = entryPoint;
 
     if(!spv.spirv.empty())
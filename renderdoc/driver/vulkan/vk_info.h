@@ -134,6 +134,8 @@ struct DescUpdateTemplate
 
 struct VulkanCreationInfo
 {
+  struct ShaderModule;
+
   struct Pipeline
   {
     void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
@@ -155,14 +157,20 @@ struct VulkanCreationInfo
     // VkPipelineShaderStageCreateInfo
     struct Shader
     {
-      Shader() : refl(NULL), mapping(NULL), patchData(NULL) {}
       ResourceId module;
       std::string entryPoint;
-      ShaderReflection *refl;
-      ShaderBindpointMapping *mapping;
-      SPIRVPatchData *patchData;
+
+      // reflection is built from the module the first time one of these is called, and is NULL
+      // for unused stages
+      ShaderReflection *GetReflection() const;
+      ShaderBindpointMapping *GetMapping() const;
+      SPIRVPatchData *GetPatchData() const;
 
       std::vector<SpecConstant> specialization;
+
+      ShaderModule *moduleInfo = NULL;
+      ResourceId originalModule;
+      VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
     };
     Shader shaders[6];
 
@@ -461,7 +469,7 @@ struct VulkanCreationInfo
     void Init(VulkanResourceManager *resourceMan, VulkanCreationInfo &info,
               const VkShaderModuleCreateInfo *pCreateInfo);
 
-    SPVModule spirv;
+    std::vector<uint32_t> spirvWords;
 
     std::string unstrippedPath;
 
@@ -474,10 +482,25 @@ struct VulkanCreationInfo
       ShaderBindpointMapping mapping;
       SPIRVPatchData patchData;
 
-      void Init(VulkanResourceManager *resourceMan, ResourceId id, const SPVModule &spv,
-                const std::string &entry, VkShaderStageFlagBits stage);
+      void Init(ResourceId originalId, const SPVModule &spv, const std::string &entry,
+                VkShaderStageFlagBits stage);
     };
-    std::map<std::string, Reflection> m_Reflections;
+
+    // most modules in a capture are never looked at, so the SPIR-V is only parsed and each entry
+    // point only reflected the first time they're needed. These are safe to call from any thread.
+    const SPVModule &GetSPIRV();
+    Reflection &GetReflection(ResourceId originalId, const std::string &entry,
+                              VkShaderStageFlagBits stage);
+    std::string Disassemble(const std::string &entry);
+
+  private:
+    // must be called with the lock held
+    SPVModule &GetParsedSPIRV();
+
+    Threading::CriticalSection lock;
+    bool parsed = false;
+    SPVModule spirv;
+    std::map<std::pair<std::string, uint32_t>, Reflection> m_Reflections;
   };
   std::map<ResourceId, ShaderModule> m_ShaderModule;
 
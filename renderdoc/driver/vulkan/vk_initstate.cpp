@@ -34,13 +34,190 @@
 // VKTODOLOW The code pattern for creating a few contiguous arrays all in one
 // AllocAlignedBuffer for the initial contents buffer is ugly.
 
-// VKTODOLOW in general we do a lot of "create buffer, use it, flush/sync then destroy".
-// I don't know what the exact cost is, but it would be nice to batch up the buffers/etc
-// used across init state use, and only do a single flush. Also we could then get some
-// nice command buffer reuse (although need to be careful we don't create too large a
-// command buffer that stalls the GPU).
+// VKTODOLOW in general we do a lot of "create buffer, use it, flush/sync then destroy" when
+// applying initial states. Preparing initial states at capture time is batched - see
+// AddPendingInitialStatePrepare() - but applying on replay still syncs per resource.
 // See INITSTATEBATCH
 
+// initial contents of memory and images are scanned for non-zero data at this granularity
+static const uint64_t initialContentsZeroPageSize = 4096;
+
+void WrappedVulkan::AddPendingInitialStatePrepare()
+{
+  // the readback copies for initial states don't need to be waited on until we serialise them at
+  // the end of the frame, so submit them in batches to avoid a CPU-GPU sync for every resource.
+  // We still flush periodically to bound the number of in-flight command buffers and temporary
+  // objects.
+  m_PendingInitStatePrepares++;
+
+  if(m_PendingInitStatePrepares >= 128)
+    FlushInitialStatePrepares();
+}
+
+void WrappedVulkan::FlushInitialStatePrepares()
+{
+  if(m_PendingInitStatePrepares == 0 && m_PrepareInitStateBuffers.empty() &&
+     m_PrepareInitStateImages.empty())
+    return;
+
+  SubmitCmds();
+  FlushQ();
+
+  VkDevice d = GetDev();
+
+  for(VkBuffer buf : m_PrepareInitStateBuffers)
+  {
+    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(buf), NULL);
+    GetResourceManager()->ReleaseWrappedResource(buf);
+  }
+
+  for(VkImage im : m_PrepareInitStateImages)
+  {
+    ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(im), NULL);
+    GetResourceManager()->ReleaseWrappedResource(im);
+  }
+
+  m_PrepareInitStateBuffers.clear();
+  m_PrepareInitStateImages.clear();
+  m_PendingInitStatePrepares = 0;
+}
+
+byte *WrappedVulkan::MapInitialStateReadback(const MemoryAllocation &mem)
+{
+  SCOPED_LOCK(m_InitStateMapLock);
+
+  byte *&base = m_InitStateMaps[mem.mem];
+
+  if(base == NULL)
+  {
+    VkDevice d = GetDev();
+
+    VkResult vkr =
+        ObjDisp(d)->MapMemory(Unwrap(d), Unwrap(mem.mem), 0, VK_WHOLE_SIZE, 0, (void **)&base);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    // invalidate the cpu cache for the whole allocation to avoid reading stale data
+    VkMappedMemoryRange range = {
+        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, Unwrap(mem.mem), 0, VK_WHOLE_SIZE,
+    };
+
+    vkr = ObjDisp(d)->InvalidateMappedMemoryRanges(Unwrap(d), 1, &range);
+    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+    if(base == NULL)
+    {
+      m_InitStateMaps.erase(mem.mem);
+      return NULL;
+    }
+  }
+
+  return base + mem.offs;
+}
+
+void WrappedVulkan::UnmapInitialStateReadbacks()
+{
+  SCOPED_LOCK(m_InitStateMapLock);
+
+  VkDevice d = GetDev();
+
+  for(auto it = m_InitStateMaps.begin(); it != m_InitStateMaps.end(); ++it)
+    ObjDisp(d)->UnmapMemory(Unwrap(d), Unwrap(it->first));
+
+  m_InitStateMaps.clear();
+}
+
+void WrappedVulkan::RemoveUnreferencedSubresources(ResourceId id, std::vector<uint64_t> &ranges)
+{
+  if(RenderDoc::Inst().GetCaptureOptions().refAllResources)
+    return;
+
+  ImageSubresourceRefs refs;
+  if(!GetResourceManager()->GetReferencedImageSubresources(id, refs))
+    return;
+
+  ImageLayouts layout;
+  {
+    SCOPED_LOCK(m_ImageLayoutsLock);
+    auto it = m_ImageLayouts.find(id);
+    if(it == m_ImageLayouts.end())
+      return;
+    layout = it->second;
+  }
+
+  // MSAA images are copied via an array image, and planes are packed differently. Keep those whole.
+  if(layout.sampleCount > 1 || GetYUVPlaneCount(layout.format) > 1)
+    return;
+
+  VkDeviceSize bufAlignment = 4;
+  if(IsBlockFormat(layout.format))
+    bufAlignment = (VkDeviceSize)GetByteSize(1, 1, 1, layout.format, 0);
+
+  VkFormat sizeFormat = GetDepthOnlyFormat(layout.format);
+
+  // walk the subresources in the same order and with the same packing as the readback copies in
+  // Prepare_InitialState, noting the byte range of each one that's referenced.
+  std::vector<uint64_t> referenced;
+  VkDeviceSize offs = 0;
+
+  for(int a = 0; a < layout.layerCount; a++)
+  {
+    for(int m = 0; m < layout.levelCount; m++)
+    {
+      offs = AlignUp(offs, bufAlignment);
+
+      VkDeviceSize start = offs;
+
+      offs += GetByteSize(layout.extent.width, layout.extent.height, layout.extent.depth,
+                          sizeFormat, m);
+
+      if(sizeFormat != layout.format)
+      {
+        offs = AlignUp(offs, bufAlignment);
+        offs += GetByteSize(layout.extent.width, layout.extent.height, layout.extent.depth,
+                            VK_FORMAT_S8_UINT, m);
+      }
+
+      if(!refs.Contains((uint32_t)a, (uint32_t)m))
+        continue;
+
+      if(!referenced.empty() && referenced[referenced.size() - 2] + referenced.back() == start)
+      {
+        referenced.back() += offs - start;
+      }
+      else
+      {
+        referenced.push_back(start);
+        referenced.push_back(offs - start);
+      }
+    }
+  }
+
+  // intersect the two sorted lists of ranges
+  std::vector<uint64_t> result;
+
+  for(size_t i = 0, r = 0; i + 1 < ranges.size() && r + 1 < referenced.size();)
+  {
+    uint64_t rangeEnd = ranges[i] + ranges[i + 1];
+    uint64_t refEnd = referenced[r] + referenced[r + 1];
+
+    uint64_t start = RDCMAX(ranges[i], referenced[r]);
+    uint64_t end = RDCMIN(rangeEnd, refEnd);
+
+    if(start < end)
+    {
+      result.push_back(start);
+      result.push_back(end - start);
+    }
+
+    if(rangeEnd < refEnd)
+      i += 2;
+    else
+      r += 2;
+  }
+
+  ranges.swap(result);
+}
+
 bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
 {
   ResourceId id = GetResourceManager()->GetID(res);
@@ -122,7 +299,6 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     }
 
     VkDevice d = GetDev();
-    // INITSTATEBATCH
     VkCommandBuffer cmd = GetNextCmd();
 
     if(layout->queueFamilyIndex != m_QueueFamilyIdx)
@@ -506,21 +682,17 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
-
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(dstBuf), NULL);
-    GetResourceManager()->ReleaseWrappedResource(dstBuf);
+    // the copy is batched with other prepares, the temporary objects are destroyed once the batch
+    // is flushed
+    m_PrepareInitStateBuffers.push_back(dstBuf);
 
     if(arrayIm != VK_NULL_HANDLE)
-    {
-      ObjDisp(d)->DestroyImage(Unwrap(d), Unwrap(arrayIm), NULL);
-      GetResourceManager()->ReleaseWrappedResource(arrayIm);
-    }
+      m_PrepareInitStateImages.push_back(arrayIm);
 
     GetResourceManager()->SetInitialContents(id, VkInitialContents(type, readbackmem));
 
+    AddPendingInitialStatePrepare();
+
     return true;
   }
   else if(type == eResDeviceMemory)
@@ -528,7 +700,6 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     VkResult vkr = VK_SUCCESS;
 
     VkDevice d = GetDev();
-    // INITSTATEBATCH
     VkCommandBuffer cmd = GetNextCmd();
 
     VkResourceRecord *record = GetResourceManager()->GetResourceRecord(id);
@@ -602,17 +773,13 @@ bool WrappedVulkan::Prepare_InitialState(WrappedVkRes *res)
     vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
     RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-    // INITSTATEBATCH
-    SubmitCmds();
-    FlushQ();
-
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(srcBuf), NULL);
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(dstBuf), NULL);
-    GetResourceManager()->ReleaseWrappedResource(srcBuf);
-    GetResourceManager()->ReleaseWrappedResource(dstBuf);
+    m_PrepareInitStateBuffers.push_back(srcBuf);
+    m_PrepareInitStateBuffers.push_back(dstBuf);
 
     GetResourceManager()->SetInitialContents(id, VkInitialContents(type, readbackmem));
 
+    AddPendingInitialStatePrepare();
+
     return true;
   }
   else
@@ -964,28 +1131,12 @@ bool WrappedVulkan::Serialise_InitialState(SerialiserType &ser, ResourceId id,
     MemoryAllocation uploadMemory;
     VkBuffer uploadBuf = VK_NULL_HANDLE;
 
-    // during writing, we already have the memory copied off - we just need to map it.
+    // during writing, we already have the memory copied off - we just need to map it. The mapping
+    // is shared with other resources in the same allocation and is unmapped once they're all done.
     if(ser.IsWriting())
     {
       if(initial && initial->mem.mem != VK_NULL_HANDLE)
-      {
-        mappedMem = initial->mem;
-        vkr = ObjDisp(d)->MapMemory(Unwrap(d), Unwrap(mappedMem.mem), initial->mem.offs,
-                                    initial->mem.size, 0, (void **)&Contents);
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-        // invalidate the cpu cache for this memory range to avoid reading stale data
-        VkMappedMemoryRange range = {
-            VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-            NULL,
-            Unwrap(mappedMem.mem),
-            mappedMem.offs,
-            mappedMem.size,
-        };
-
-        vkr = ObjDisp(d)->InvalidateMappedMemoryRanges(Unwrap(d), 1, &range);
-        RDCASSERTEQUAL(vkr, VK_SUCCESS);
-      }
+        Contents = MapInitialStateReadback(initial->mem);
     }
     else if(IsReplayingAndReading() && !ser.IsErrored())
     {
@@ -1013,9 +1164,61 @@ bool WrappedVulkan::Serialise_InitialState(SerialiserType &ser, ResourceId id,
                             (void **)&Contents);
     }
 
-    // not using SERIALISE_ELEMENT_ARRAY so we can deliberately avoid allocation - we serialise
-    // directly into upload memory
-    ser.Serialise("Contents"_lit, Contents, ContentsSize, SerialiserFlags::NoFlags);
+    if(ser.VersionAtLeast(0x10))
+    {
+      // memory is often mostly zero, so only the pages containing non-zero data are stored as
+      // offset/size pairs. Everything between them is zero-filled on replay.
+      std::vector<uint64_t> NonZeroRanges;
+
+      if(ser.IsWriting() && Contents)
+      {
+        FindNonZeroRanges(Contents, ContentsSize, initialContentsZeroPageSize, NonZeroRanges);
+
+        // images also drop any array layers and mips that the frame doesn't reference
+        if(type == eResImage)
+          RemoveUnreferencedSubresources(id, NonZeroRanges);
+      }
+
+      SERIALISE_ELEMENT(NonZeroRanges);
+
+      uint64_t zeroStart = 0;
+
+      for(size_t i = 0; i + 1 < NonZeroRanges.size(); i += 2)
+      {
+        uint64_t rangeOffset = NonZeroRanges[i];
+        uint64_t rangeSize = NonZeroRanges[i + 1];
+
+        byte *RangeContents = NULL;
+
+        if(Contents && rangeOffset >= zeroStart && rangeOffset <= ContentsSize &&
+           rangeSize <= ContentsSize - rangeOffset)
+        {
+          if(IsReplayingAndReading())
+            memset(Contents + zeroStart, 0, size_t(rangeOffset - zeroStart));
+
+          RangeContents = Contents + rangeOffset;
+          zeroStart = rangeOffset + rangeSize;
+        }
+        else if(Contents)
+        {
+          RDCERR("Invalid non-zero range %llu bytes at %llu in %llu bytes of initial contents",
+                 rangeSize, rangeOffset, ContentsSize);
+        }
+
+        // not using SERIALISE_ELEMENT_ARRAY so we can deliberately avoid allocation - we serialise
+        // directly into upload memory
+        ser.Serialise("Contents"_lit, RangeContents, rangeSize, SerialiserFlags::NoFlags);
+      }
+
+      if(IsReplayingAndReading() && Contents)
+        memset(Contents + zeroStart, 0, size_t(ContentsSize - zeroStart));
+    }
+    else
+    {
+      // not using SERIALISE_ELEMENT_ARRAY so we can deliberately avoid allocation - we serialise
+      // directly into upload memory
+      ser.Serialise("Contents"_lit, Contents, ContentsSize, SerialiserFlags::NoFlags);
+    }
 
     // unmap the resource we mapped before - we need to do this on read and on write.
     if(!IsStructuredExporting(m_State) && mappedMem.mem != VK_NULL_HANDLE)
@@ -1986,16 +2189,22 @@ void WrappedVulkan::Apply_InitialState(WrappedVkRes *live, const VkInitialConten
     {
       bool initialized = memRefs->initializedLiveRes == live;
       memRefs->initializedLiveRes = live;
+
+      // the referenced ranges are already sorted and disjoint, so gather them and apply them all
+      // in one pass.
+      std::vector<IntervalUpdate<InitReqType> > updates;
+      updates.reserve(memRefs->rangeRefs.size());
       for(auto it = memRefs->rangeRefs.begin(); it != memRefs->rangeRefs.end(); it++)
       {
         InitReqType t = InitReq(it->value());
         if(t == eInitReq_Reset || (t == eInitReq_InitOnce && !initialized))
-          resetReq.update(it->start(), it->finish(), eInitReq_Reset,
-                          [](InitReqType x, InitReqType y) -> InitReqType { return std::max(x, y); });
+          updates.push_back({it->start(), it->finish(), eInitReq_Reset});
         else if(t == eInitReq_Clear || (t == eInitReq_None && !initialized))
-          resetReq.update(it->start(), it->finish(), eInitReq_Clear,
-                          [](InitReqType x, InitReqType y) -> InitReqType { return std::max(x, y); });
+          updates.push_back({it->start(), it->finish(), eInitReq_Clear});
       }
+
+      resetReq.update(updates,
+                      [](InitReqType x, InitReqType y) -> InitReqType { return std::max(x, y); });
     }
 
     VkResult vkr = VK_SUCCESS;
@@ -689,7 +689,16 @@ void VulkanResourceManager::MarkMemoryFrameReferenced(ResourceId mem, VkDeviceSi
 {
   SCOPED_LOCK(m_Lock);
 
-  FrameRefType maxRef = MarkMemoryReferenced(m_MemFrameRefs, mem, offset, size, refType);
+  bool changed = m_MemFrameRefs.find(mem) == m_MemFrameRefs.end();
+  FrameRefType maxRef = MarkMemoryReferenced(m_MemFrameRefs, mem, offset, size, refType,
+                                             [&changed](FrameRefType oldRef, FrameRefType newRef) {
+                                               FrameRefType ref = ComposeFrameRefs(oldRef, newRef);
+                                               changed |= (ref != oldRef);
+                                               return ref;
+                                             });
+  if(changed)
+    m_FrameRefGeneration++;
+
   MarkResourceFrameReferenced(
       mem, maxRef, [](FrameRefType x, FrameRefType y) -> FrameRefType { return std::max(x, y); });
 }
@@ -698,14 +707,28 @@ void VulkanResourceManager::MergeReferencedMemory(std::map<ResourceId, MemRefs>
 {
   SCOPED_LOCK(m_Lock);
 
+  bool changed = false;
+
   for(auto j = memRefs.begin(); j != memRefs.end(); j++)
   {
     auto i = m_MemFrameRefs.find(j->first);
     if(i == m_MemFrameRefs.end())
+    {
       m_MemFrameRefs.insert(*j);
+      changed = true;
+    }
     else
-      i->second.Merge(j->second);
+    {
+      i->second.Merge(j->second, [&changed](FrameRefType oldRef, FrameRefType newRef) {
+        FrameRefType ref = ComposeFrameRefs(oldRef, newRef);
+        changed |= (ref != oldRef);
+        return ref;
+      });
+    }
   }
+
+  if(changed)
+    m_FrameRefGeneration++;
 }
 
 void VulkanResourceManager::ClearReferencedMemory()
@@ -713,6 +736,51 @@ void VulkanResourceManager::ClearReferencedMemory()
   SCOPED_LOCK(m_Lock);
 
   m_MemFrameRefs.clear();
+  m_FrameRefGeneration++;
+}
+
+void VulkanResourceManager::MergeReferencedImageSubresources(
+    std::map<ResourceId, ImageSubresourceRefs> &imgRefs)
+{
+  SCOPED_LOCK(m_ImgFrameRefsLock);
+
+  for(auto it = imgRefs.begin(); it != imgRefs.end(); ++it)
+    m_ImgFrameRefs[it->first].Merge(it->second);
+}
+
+void VulkanResourceManager::MarkReferencedImageViews()
+{
+  SCOPED_LOCK(m_Lock);
+  SCOPED_LOCK(m_ImgFrameRefsLock);
+
+  for(auto it = m_FrameReferencedResources.begin(); it != m_FrameReferencedResources.end(); ++it)
+  {
+    VkResourceRecord *record = GetResourceRecord(it->first);
+
+    if(record && record->Resource && IdentifyTypeByPtr(record->Resource) == eResImageView &&
+       record->baseResource != ResourceId())
+      m_ImgFrameRefs[record->baseResource].Add((VkImageSubresourceRange)record->viewRange);
+  }
+}
+
+void VulkanResourceManager::ClearReferencedImageSubresources()
+{
+  SCOPED_LOCK(m_ImgFrameRefsLock);
+
+  m_ImgFrameRefs.clear();
+}
+
+bool VulkanResourceManager::GetReferencedImageSubresources(ResourceId img,
+                                                           ImageSubresourceRefs &refs)
+{
+  SCOPED_LOCK(m_ImgFrameRefsLock);
+
+  auto it = m_ImgFrameRefs.find(img);
+  if(it == m_ImgFrameRefs.end())
+    return false;
+
+  refs = it->second;
+  return true;
 }
 
 MemRefs *VulkanResourceManager::FindMemRefs(ResourceId mem)
@@ -429,6 +429,14 @@ public:
   void ClearReferencedMemory();
   MemRefs *FindMemRefs(ResourceId mem);
 
+  // image subresource refs, gathered from command buffers on submit and from the views the frame
+  // references at the end of the frame.
+  void MergeReferencedImageSubresources(std::map<ResourceId, ImageSubresourceRefs> &imgRefs);
+  void MarkReferencedImageViews();
+  void ClearReferencedImageSubresources();
+  // returns false if nothing recorded which parts of the image are referenced
+  bool GetReferencedImageSubresources(ResourceId img, ImageSubresourceRefs &refs);
+
   inline bool OptimizeInitialState() { return m_OptimizeInitialState; }
 private:
   bool ResourceTypeRelease(WrappedVkRes *res);
@@ -437,6 +445,7 @@ private:
   uint64_t GetSize_InitialState(ResourceId id, const VkInitialContents &initial);
   bool Serialise_InitialState(WriteSerialiser &ser, ResourceId id, VkResourceRecord *record,
                               const VkInitialContents *initial);
+  bool Serialise_InitialStateConcurrently() { return true; }
   void Create_InitialState(ResourceId id, WrappedVkRes *live, bool hasData);
   void Apply_InitialState(WrappedVkRes *live, const VkInitialContents &initial);
   std::vector<ResourceId> InitialContentResources();
@@ -444,5 +453,9 @@ private:
   CaptureState m_State;
   WrappedVulkan *m_Core;
   std::map<ResourceId, MemRefs> m_MemFrameRefs;
+  // separate from m_Lock, since initial contents are serialised on several threads while the
+  // thread that started serialising holds m_Lock
+  Threading::CriticalSection m_ImgFrameRefsLock;
+  std::map<ResourceId, ImageSubresourceRefs> m_ImgFrameRefs;
   bool m_OptimizeInitialState = false;
 };
@@ -1608,7 +1608,7 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
   const VulkanCreationInfo::ShaderModule &moduleInfo =
       creationInfo.m_ShaderModule[pipeInfo.shaders[0].module];
 
-  ShaderReflection *refl = pipeInfo.shaders[0].refl;
+  ShaderReflection *refl = pipeInfo.shaders[0].GetReflection();
 
   // set defaults so that we don't try to fetch this output again if something goes wrong and the
   // same event is selected again
@@ -1740,8 +1740,6 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     bool index16 = (idxsize == 2);
     bytebuf idxdata;
     std::vector<uint32_t> indices;
-    uint16_t *idx16 = NULL;
-    uint32_t *idx32 = NULL;
 
     // fetch ibuffer
     if(state.ibuffer.buf != ResourceId())
@@ -1787,42 +1785,14 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
 
     // do ibuffer rebasing/remapping
 
-    idx16 = (uint16_t *)&idxdata[0];
-    idx32 = (uint32_t *)&idxdata[0];
-
     // only read as many indices as were available in the buffer
     uint32_t numIndices =
         RDCMIN(uint32_t(index16 ? idxdata.size() / 2 : idxdata.size() / 4), drawcall->numIndices);
 
-    uint32_t idxclamp = 0;
-    if(drawcall->baseVertex < 0)
-      idxclamp = uint32_t(-drawcall->baseVertex);
-
-    // grab all unique vertex indices referenced
-    for(uint32_t i = 0; i < numIndices; i++)
-    {
-      uint32_t i32 = index16 ? uint32_t(idx16[i]) : idx32[i];
-
-      // apply baseVertex but clamp to 0 (don't allow index to become negative)
-      if(i32 < idxclamp)
-        i32 = 0;
-      else if(drawcall->baseVertex < 0)
-        i32 -= idxclamp;
-      else if(drawcall->baseVertex > 0)
-        i32 += drawcall->baseVertex;
-
-      // we clamp to maxIdx here, to avoid any invalid indices like 0xffffffff
-      // from filtering through. Worst case we index to the end of the vertex
-      // buffers which is generally much more reasonable
-      i32 = RDCMIN(maxIdx, i32);
-
-      auto it = std::lower_bound(indices.begin(), indices.end(), i32);
-
-      if(it != indices.end() && *it == i32)
-        continue;
-
-      indices.insert(it, i32);
-    }
+    // grab all unique vertex indices referenced. We clamp to maxIdx here, to avoid any invalid
+    // indices like 0xffffffff from filtering through. Worst case we index to the end of the vertex
+    // buffers which is generally much more reasonable
+    GetUniqueIndices(idxdata.data(), idxsize, numIndices, drawcall->baseVertex, maxIdx, indices);
 
     // if we read out of bounds, we'll also have a 0 index being referenced
     // (as 0 is read). Don't insert 0 if we already have 0 though
@@ -1845,15 +1815,6 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     // so that what did point to 500 points to 0 (accounting for rebasing), and what did point
     // to 510 now points to 3 (accounting for the unique sort).
 
-    // we use a map here since the indices may be sparse. Especially considering if an index
-    // is 'invalid' like 0xcccccccc then we don't want an array of 3.4 billion entries.
-    std::map<uint32_t, size_t> indexRemap;
-    for(size_t i = 0; i < indices.size(); i++)
-    {
-      // by definition, this index will only appear once in indices[]
-      indexRemap[indices[i]] = i;
-    }
-
     // create buffer with unique 0-based indices
     VkBufferCreateInfo bufInfo = {
         VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -1916,28 +1877,8 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     m_pDriver->vkUnmapMemory(m_Device, uniqIdxBufMem);
 
     // rebase existing index buffer to point to the right elements in our stream-out'd
-    // vertex buffer
-    for(uint32_t i = 0; i < numIndices; i++)
-    {
-      uint32_t i32 = index16 ? uint32_t(idx16[i]) : idx32[i];
-
-      // preserve primitive restart indices
-      if(i32 == (index16 ? 0xffff : 0xffffffff))
-        continue;
-
-      // apply baseVertex but clamp to 0 (don't allow index to become negative)
-      if(i32 < idxclamp)
-        i32 = 0;
-      else if(drawcall->baseVertex < 0)
-        i32 -= idxclamp;
-      else if(drawcall->baseVertex > 0)
-        i32 += drawcall->baseVertex;
-
-      if(index16)
-        idx16[i] = uint16_t(indexRemap[i32]);
-      else
-        idx32[i] = uint32_t(indexRemap[i32]);
-    }
+    // vertex buffer, preserving primitive restart indices
+    RemapIndices(idxdata.data(), idxsize, numIndices, indices, drawcall->baseVertex, ~0U);
 
     bufInfo.size = RDCMAX((VkDeviceSize)64, (VkDeviceSize)idxdata.size());
     bufInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
@@ -1979,7 +1920,7 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
   }
 
   uint32_t bufStride = 0;
-  std::vector<uint32_t> modSpirv = moduleInfo.spirv.spirv;
+  std::vector<uint32_t> modSpirv = moduleInfo.spirvWords;
 
   struct CompactedAttrBuffer
   {
@@ -2347,7 +2288,7 @@ void VulkanReplay::FetchVSOut(uint32_t eventId)
     m_pDriver->vkUpdateDescriptorSets(dev, numWrites, descWrites, 0, NULL);
   }
 
-  ConvertToMeshOutputCompute(*refl, *pipeInfo.shaders[0].patchData,
+  ConvertToMeshOutputCompute(*refl, *pipeInfo.shaders[0].GetPatchData(),
                              pipeInfo.shaders[0].entryPoint.c_str(), attrInstDivisor, drawcall,
                              numVerts, numViews, modSpirv, bufStride);
 
@@ -2733,21 +2674,21 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   int stageIndex = 3;
 
   // if there is no such shader bound, try tessellation
-  if(!pipeInfo.shaders[stageIndex].refl)
+  if(pipeInfo.shaders[stageIndex].module == ResourceId())
     stageIndex = 2;
 
   // if still nothing, do vertex
-  if(!pipeInfo.shaders[stageIndex].refl)
+  if(pipeInfo.shaders[stageIndex].module == ResourceId())
     stageIndex = 0;
 
-  ShaderReflection *lastRefl = pipeInfo.shaders[stageIndex].refl;
+  ShaderReflection *lastRefl = pipeInfo.shaders[stageIndex].GetReflection();
 
   RDCASSERT(lastRefl);
 
   uint32_t primitiveMultiplier = 1;
 
   // transform feedback expands strips to lists
-  switch(pipeInfo.shaders[stageIndex].patchData->outTopo)
+  switch(pipeInfo.shaders[stageIndex].GetPatchData()->outTopo)
   {
     case Topology::PointList:
       m_PostVS.Data[eventId].gsout.topo = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
@@ -2759,7 +2700,7 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
       break;
     default:
       RDCERR("Unexpected output topology %s",
-             ToStr(pipeInfo.shaders[stageIndex].patchData->outTopo).c_str());
+             ToStr(pipeInfo.shaders[stageIndex].GetPatchData()->outTopo).c_str());
     // deliberate fallthrough
     case Topology::TriangleList:
     case Topology::TriangleStrip:
@@ -2796,12 +2737,12 @@ void VulkanReplay::FetchTessGSOut(uint32_t eventId)
   const VulkanCreationInfo::ShaderModule &moduleInfo =
       creationInfo.m_ShaderModule[pipeInfo.shaders[stageIndex].module];
 
-  std::vector<uint32_t> modSpirv = moduleInfo.spirv.spirv;
+  std::vector<uint32_t> modSpirv = moduleInfo.spirvWords;
 
   uint32_t xfbStride = 0;
 
   // adds XFB annotations in order of the output signature (with the position first)
-  AddXFBAnnotations(*lastRefl, *pipeInfo.shaders[stageIndex].patchData,
+  AddXFBAnnotations(*lastRefl, *pipeInfo.shaders[stageIndex].GetPatchData(),
                     pipeInfo.shaders[stageIndex].entryPoint.c_str(), modSpirv, xfbStride);
 
   // create vertex shader with modified code
@@ -3268,21 +3209,31 @@ void VulkanReplay::InitPostVSBuffers(uint32_t eventId)
   if(drawcall == NULL || drawcall->numIndices == 0 || drawcall->numInstances == 0)
     return;
 
+  // the outputs only depend on the draw's inputs, so they may have been saved by a previous session
+  // or from an identical draw in another capture
+  uint64_t cacheKey = GetPostVSCacheKey(eventId);
+
+  if(cacheKey != 0 && LoadPostVSCache(eventId, cacheKey))
+    return;
+
   VkMarkerRegion::Begin(StringFormat::Fmt("FetchVSOut for %u", eventId));
 
   FetchVSOut(eventId);
 
   VkMarkerRegion::End();
 
-  // if there's no tessellation or geometry shader active, bail out now
-  if(pipeInfo.shaders[2].module == ResourceId() && pipeInfo.shaders[3].module == ResourceId())
-    return;
+  // only fetch tessellation/geometry output if one of those shaders is active
+  if(pipeInfo.shaders[2].module != ResourceId() || pipeInfo.shaders[3].module != ResourceId())
+  {
+    VkMarkerRegion::Begin(StringFormat::Fmt("FetchTessGSOut for %u", eventId));
 
-  VkMarkerRegion::Begin(StringFormat::Fmt("FetchTessGSOut for %u", eventId));
+    FetchTessGSOut(eventId);
 
-  FetchTessGSOut(eventId);
+    VkMarkerRegion::End();
+  }
 
-  VkMarkerRegion::End();
+  if(cacheKey != 0)
+    StorePostVSCache(eventId, cacheKey);
 }
 
 struct VulkanInitPostVSCallback : public VulkanDrawcallCallback
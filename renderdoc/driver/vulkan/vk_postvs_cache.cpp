@@ -0,0 +1,602 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015-2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include <algorithm>
+
+#define XXH_STATIC_LINKING_ONLY
+#include "3rdparty/zstd/xxhash.h"
+#include "serialise/streamio.h"
+#include "vk_core.h"
+#include "vk_replay.h"
+
+// Post-transform outputs are saved to disk between sessions, keyed by a hash of everything the
+// vertex/tessellation/geometry stages read. The size is controlled by a config setting:
+//
+// Replay_PostVSCacheSizeMB - how large the cache folder may grow. Defaults to 512, 0 disables it.
+//
+// Draws that read images or samplers from a pre-rasterization stage aren't cached, since their
+// contents can't be hashed cheaply. Neither are draws using an edited shader.
+
+// bump this whenever the hashed inputs or the stored data change
+static const uint32_t PostVSDiskCacheVersion = 1;
+
+// upper limit on how much buffer data is read back to hash a draw's inputs. Draws reading more than
+// this aren't cached
+static const uint64_t MaxPostVSCacheInputSize = 256 * 1024 * 1024;
+
+static uint64_t GetPostVSDiskCacheSize()
+{
+  const std::string &setting = RenderDoc::Inst().GetConfigSetting("Replay_PostVSCacheSizeMB");
+
+  int size = setting.empty() ? 512 : atoi(setting.c_str());
+
+  return uint64_t(RDCMAX(size, 0)) * 1024 * 1024;
+}
+
+struct PostVSCacheHasher
+{
+  PostVSCacheHasher() { XXH64_reset(&state, 0); }
+  void Add(const void *data, size_t size) { XXH64_update(&state, data, size); }
+  template <typename T>
+  void Add(const T &val)
+  {
+    Add(&val, sizeof(val));
+  }
+  void Add(const std::string &str)
+  {
+    Add(str.size());
+    Add(str.c_str(), str.size());
+  }
+  template <typename T>
+  void Add(const std::vector<T> &vec)
+  {
+    Add(vec.size());
+    Add(vec.data(), vec.size() * sizeof(T));
+  }
+  uint64_t Get() { return XXH64_digest(&state); }
+  XXH64_state_t state;
+};
+
+ReplayDiskCache &VulkanReplay::GetPostVSDiskCache()
+{
+  if(m_PostVS.DiskCache == NULL)
+    m_PostVS.DiskCache =
+        new ReplayDiskCache("postvs_cache", PostVSDiskCacheVersion, GetPostVSDiskCacheSize());
+
+  return *m_PostVS.DiskCache;
+}
+
+uint64_t VulkanReplay::GetPostVSCacheKey(uint32_t eventId)
+{
+  if(!GetPostVSDiskCache().IsEnabled())
+    return 0;
+
+  const VulkanRenderState &state = m_pDriver->m_RenderState;
+  VulkanCreationInfo &c = m_pDriver->m_CreationInfo;
+
+  // replaced shaders aren't reflected in the creation info we hash
+  if(m_pDriver->GetResourceManager()->HasReplacement(state.graphics.pipeline))
+    return 0;
+
+  const VulkanCreationInfo::Pipeline &pipe = c.m_Pipeline[state.graphics.pipeline];
+  const DrawcallDescription *drawcall = m_pDriver->GetDrawcall(eventId);
+
+  PostVSCacheHasher hash;
+  uint64_t hashedBytes = 0;
+
+  // hashes a range of a buffer's contents, returning false if we've read too much to be worthwhile
+  auto hashBuffer = [this, &c, &hash, &hashedBytes](ResourceId buf, uint64_t offs, uint64_t size) {
+    hash.Add(buf != ResourceId());
+
+    if(buf == ResourceId())
+      return true;
+
+    uint64_t bufSize = c.m_Buffer[buf].size;
+    offs = RDCMIN(offs, bufSize);
+    size = RDCMIN(size, bufSize - offs);
+
+    hash.Add(offs);
+    hash.Add(size);
+
+    hashedBytes += size;
+    if(hashedBytes > MaxPostVSCacheInputSize)
+      return false;
+
+    if(size > 0)
+    {
+      bytebuf data;
+      GetBufferData(buf, offs, size, data);
+      hash.Add(data.data(), data.size());
+    }
+
+    return true;
+  };
+
+  // the results depend on the GPU and driver we're replaying on
+  const VkPhysicalDeviceProperties &props = m_pDriver->GetDeviceProps();
+  hash.Add(props.vendorID);
+  hash.Add(props.deviceID);
+  hash.Add(props.driverVersion);
+  hash.Add(props.pipelineCacheUUID);
+
+  DrawFlags drawFlags = drawcall->flags & (DrawFlags::Indexed | DrawFlags::Instanced);
+  hash.Add(drawFlags);
+  hash.Add(drawcall->numIndices);
+  hash.Add(drawcall->numInstances);
+  hash.Add(drawcall->indexOffset);
+  hash.Add(drawcall->baseVertex);
+  hash.Add(drawcall->vertexOffset);
+  hash.Add(drawcall->instanceOffset);
+
+  hash.Add(pipe.topology);
+  hash.Add(pipe.primitiveRestartEnable);
+  hash.Add(pipe.patchControlPoints);
+
+  // the views we expand the output to
+  const VulkanCreationInfo::RenderPass &rp = c.m_RenderPass[state.renderPass];
+  if(state.subpass < rp.subpasses.size())
+    hash.Add(rp.subpasses[state.subpass].multiviews);
+
+  for(uint32_t s = 0; s < 4; s++)
+  {
+    const VulkanCreationInfo::Pipeline::Shader &sh = pipe.shaders[s];
+
+    hash.Add(sh.module != ResourceId());
+
+    if(sh.module == ResourceId())
+      continue;
+
+    hash.Add(c.m_ShaderModule[sh.module].spirvWords);
+    hash.Add(sh.entryPoint);
+    hash.Add(sh.specialization.size());
+    for(const SpecConstant &spec : sh.specialization)
+    {
+      hash.Add(spec.specID);
+      hash.Add(spec.data);
+    }
+  }
+
+  hash.Add(state.pushConstSize);
+  hash.Add(state.pushconsts, RDCMIN((size_t)state.pushConstSize, sizeof(state.pushconsts)));
+
+  // find the range of vertices and instances read, so we only hash the vertex data that's used
+  uint32_t minVert = drawcall->vertexOffset;
+  uint32_t maxVert = drawcall->vertexOffset + drawcall->numIndices - 1;
+
+  if(drawcall->flags & DrawFlags::Indexed)
+  {
+    uint32_t idxsize = state.ibuffer.bytewidth;
+
+    bytebuf idxdata;
+    if(state.ibuffer.buf != ResourceId())
+      GetBufferData(state.ibuffer.buf, state.ibuffer.offs + drawcall->indexOffset * idxsize,
+                    uint64_t(drawcall->numIndices) * idxsize, idxdata);
+
+    hash.Add(idxsize);
+    hash.Add(idxdata.size());
+    hash.Add(idxdata.data(), idxdata.size());
+
+    hashedBytes += idxdata.size();
+    if(hashedBytes > MaxPostVSCacheInputSize)
+      return 0;
+
+    uint32_t numIndices = uint32_t(idxdata.size() / RDCMAX(1U, idxsize));
+
+    std::vector<uint32_t> indices(numIndices);
+    WidenIndices(idxdata.data(), idxsize, numIndices, indices.data());
+
+    uint32_t restart = idxsize == 1 ? 0xff : idxsize == 2 ? 0xffff : 0xffffffff;
+
+    minVert = ~0U;
+    maxVert = 0;
+    for(uint32_t idx : indices)
+    {
+      if(pipe.primitiveRestartEnable && idx == restart)
+        continue;
+
+      idx = uint32_t(RDCMAX((int64_t)0, int64_t(idx) + drawcall->baseVertex));
+      minVert = RDCMIN(minVert, idx);
+      maxVert = RDCMAX(maxVert, idx);
+    }
+
+    if(minVert > maxVert)
+      minVert = maxVert = 0;
+  }
+
+  uint32_t minInst = drawcall->instanceOffset;
+  uint32_t maxInst = drawcall->instanceOffset + drawcall->numInstances - 1;
+
+  for(const VulkanCreationInfo::Pipeline::Binding &bind : pipe.vertexBindings)
+  {
+    hash.Add(bind.vbufferBinding);
+    hash.Add(bind.bytestride);
+    hash.Add(bind.perInstance);
+    hash.Add(bind.instanceDivisor);
+
+    // the furthest any attribute reads past the start of an element
+    uint32_t elemSize = 0;
+    for(const VulkanCreationInfo::Pipeline::Attribute &attr : pipe.vertexAttrs)
+    {
+      if(attr.binding != bind.vbufferBinding)
+        continue;
+
+      hash.Add(attr.location);
+      hash.Add(attr.format);
+      hash.Add(attr.byteoffset);
+
+      elemSize = RDCMAX(elemSize, attr.byteoffset + GetByteSize(1, 1, 1, attr.format, 0));
+    }
+
+    if(bind.vbufferBinding >= state.vbuffers.size())
+    {
+      hash.Add(false);
+      continue;
+    }
+
+    uint64_t first = bind.perInstance ? minInst : minVert;
+    uint64_t last = bind.perInstance ? maxInst : maxVert;
+
+    uint64_t offs = state.vbuffers[bind.vbufferBinding].offs + first * bind.bytestride;
+    uint64_t size = (last - first) * bind.bytestride + elemSize;
+
+    if(!hashBuffer(state.vbuffers[bind.vbufferBinding].buf, offs, size))
+      return 0;
+  }
+
+  // gather the descriptors that are statically used by any of the stages
+  std::vector<Bindpoint> binds;
+
+  auto addBind = [&binds](const Bindpoint &bp) {
+    if(bp.used)
+      binds.push_back(bp);
+  };
+
+  for(uint32_t s = 0; s < 4; s++)
+  {
+    const VulkanCreationInfo::Pipeline::Shader &sh = pipe.shaders[s];
+
+    if(sh.module == ResourceId())
+      continue;
+
+    const ShaderReflection *refl = sh.GetReflection();
+    const ShaderBindpointMapping *mapping = sh.GetMapping();
+
+    if(refl == NULL || mapping == NULL)
+      return 0;
+
+    // constant blocks that aren't buffer backed are push constants or specialisation constants,
+    // which are hashed above
+    for(const ConstantBlock &cb : refl->constantBlocks)
+      if(cb.bufferBacked)
+        addBind(mapping->constantBlocks[cb.bindPoint]);
+    for(const ShaderSampler &samp : refl->samplers)
+      addBind(mapping->samplers[samp.bindPoint]);
+    for(const ShaderResource &res : refl->readOnlyResources)
+      addBind(mapping->readOnlyResources[res.bindPoint]);
+    for(const ShaderResource &res : refl->readWriteResources)
+      addBind(mapping->readWriteResources[res.bindPoint]);
+  }
+
+  std::sort(binds.begin(), binds.end());
+  binds.erase(std::unique(binds.begin(), binds.end()), binds.end());
+
+  for(const Bindpoint &bp : binds)
+  {
+    hash.Add(bp.bindset);
+    hash.Add(bp.bind);
+
+    if(bp.bindset < 0 || (size_t)bp.bindset >= state.graphics.descSets.size() ||
+       state.graphics.descSets[bp.bindset].descSet == ResourceId())
+    {
+      hash.Add(false);
+      continue;
+    }
+
+    const WrappedVulkan::DescriptorSetInfo &setInfo =
+        m_pDriver->m_DescriptorSetState[state.graphics.descSets[bp.bindset].descSet];
+    const DescSetLayout &layout = c.m_DescSetLayout[setInfo.layout];
+
+    if(bp.bind < 0 || (size_t)bp.bind >= layout.bindings.size() ||
+       (size_t)bp.bind >= setInfo.currentBindings.size())
+    {
+      hash.Add(false);
+      continue;
+    }
+
+    const DescSetLayout::Binding &layoutBind = layout.bindings[bp.bind];
+    const DescriptorSetBindingElement *elems = setInfo.currentBindings[bp.bind];
+
+    hash.Add(layoutBind.descriptorType);
+    hash.Add(layoutBind.descriptorCount);
+
+    for(uint32_t a = 0; a < layoutBind.descriptorCount; a++)
+    {
+      switch(layoutBind.descriptorType)
+      {
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+        {
+          const VkDescriptorBufferInfo &info = elems[a].bufferInfo;
+
+          uint64_t offs = info.offset;
+
+          // dynamic offsets are stored in the otherwise unused image layout
+          if(layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+             layoutBind.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+            offs += (uint32_t)elems[a].imageInfo.imageLayout;
+
+          ResourceId buf = info.buffer != VK_NULL_HANDLE ? GetResID(info.buffer) : ResourceId();
+
+          if(!hashBuffer(buf, offs, info.range))
+            return 0;
+
+          break;
+        }
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+        {
+          if(elems[a].texelBufferView == VK_NULL_HANDLE)
+          {
+            hash.Add(false);
+            break;
+          }
+
+          const VulkanCreationInfo::BufferView &view =
+              c.m_BufferView[GetResID(elems[a].texelBufferView)];
+
+          hash.Add(view.format);
+
+          if(!hashBuffer(view.buffer, view.offset, view.size))
+            return 0;
+
+          break;
+        }
+        // images and samplers can't be hashed cheaply, don't cache this draw
+        default: return 0;
+      }
+    }
+  }
+
+  uint64_t ret = hash.Get();
+
+  // 0 means uncacheable
+  return ret == 0 ? 1 : ret;
+}
+
+static void WritePostVSStage(StreamWriter &writer, const VulkanPostVSData::StageData &stage,
+                             const bytebuf &vertexData, const bytebuf &indexData)
+{
+  writer.Write(stage.topo);
+  writer.Write(stage.baseVertex);
+  writer.Write(stage.numVerts);
+  writer.Write(stage.vertStride);
+  writer.Write(stage.instStride);
+  writer.Write(stage.numViews);
+  writer.Write((uint32_t)stage.useIndices);
+  writer.Write(stage.idxFmt);
+  writer.Write((uint32_t)stage.hasPosOut);
+  writer.Write(stage.nearPlane);
+  writer.Write(stage.farPlane);
+
+  writer.Write((uint64_t)stage.instData.size());
+  writer.Write(stage.instData.data(), stage.instData.size() * sizeof(VulkanPostVSData::InstData));
+
+  writer.Write((uint64_t)vertexData.size());
+  writer.Write(vertexData.data(), vertexData.size());
+  writer.Write((uint64_t)indexData.size());
+  writer.Write(indexData.data(), indexData.size());
+}
+
+static bool ReadPostVSStage(StreamReader &reader, VulkanPostVSData::StageData &stage,
+                            bytebuf &vertexData, bytebuf &indexData)
+{
+  uint32_t useIndices = 0, hasPosOut = 0;
+
+  reader.Read(stage.topo);
+  reader.Read(stage.baseVertex);
+  reader.Read(stage.numVerts);
+  reader.Read(stage.vertStride);
+  reader.Read(stage.instStride);
+  reader.Read(stage.numViews);
+  reader.Read(useIndices);
+  reader.Read(stage.idxFmt);
+  reader.Read(hasPosOut);
+  reader.Read(stage.nearPlane);
+  reader.Read(stage.farPlane);
+
+  stage.useIndices = useIndices != 0;
+  stage.hasPosOut = hasPosOut != 0;
+
+  uint64_t size = 0;
+
+  reader.Read(size);
+  if(size > reader.GetSize())
+    return false;
+  stage.instData.resize((size_t)size);
+  reader.Read(stage.instData.data(), size * sizeof(VulkanPostVSData::InstData));
+
+  reader.Read(size);
+  if(size > reader.GetSize())
+    return false;
+  vertexData.resize((size_t)size);
+  reader.Read(vertexData.data(), size);
+
+  reader.Read(size);
+  if(size > reader.GetSize())
+    return false;
+  indexData.resize((size_t)size);
+  reader.Read(indexData.data(), size);
+
+  return !reader.IsErrored();
+}
+
+void VulkanReplay::StorePostVSCache(uint32_t eventId, uint64_t key)
+{
+  auto it = m_PostVS.Data.find(eventId);
+
+  // failed fetches aren't cached, so they're retried next time
+  if(it == m_PostVS.Data.end() || it->second.vsout.buf == VK_NULL_HANDLE)
+    return;
+
+  const VulkanPostVSData &data = it->second;
+
+  StreamWriter writer(StreamWriter::DefaultScratchSize);
+
+  writer.Write(data.vsin.topo);
+
+  const VulkanPostVSData::StageData *stages[] = {&data.vsout, &data.gsout};
+
+  for(const VulkanPostVSData::StageData *stage : stages)
+  {
+    bytebuf vertexData, indexData;
+
+    if(stage->buf != VK_NULL_HANDLE)
+      GetBufferData(GetResID(stage->buf), 0, 0, vertexData);
+    if(stage->idxbuf != VK_NULL_HANDLE)
+      GetBufferData(GetResID(stage->idxbuf), 0, 0, indexData);
+
+    WritePostVSStage(writer, *stage, vertexData, indexData);
+  }
+
+  bytebuf blob;
+  blob.assign(writer.GetData(), (size_t)writer.GetOffset());
+
+  GetPostVSDiskCache().Store(key, blob);
+}
+
+bool VulkanReplay::LoadPostVSCache(uint32_t eventId, uint64_t key)
+{
+  bytebuf blob;
+
+  if(!GetPostVSDiskCache().Load(key, blob))
+    return false;
+
+  VkDevice dev = m_Device;
+  VkResult vkr = VK_SUCCESS;
+
+  VulkanPostVSData data;
+
+  StreamReader reader(blob.data(), blob.size());
+
+  reader.Read(data.vsin.topo);
+
+  VulkanPostVSData::StageData *stages[] = {&data.vsout, &data.gsout};
+
+  bool success = true;
+
+  for(VulkanPostVSData::StageData *stage : stages)
+  {
+    bytebuf vertexData, indexData;
+
+    if(!success || !ReadPostVSStage(reader, *stage, vertexData, indexData))
+    {
+      success = false;
+      break;
+    }
+
+    const bytebuf *contents[] = {&vertexData, &indexData};
+    VkBuffer *bufs[] = {&stage->buf, &stage->idxbuf};
+    VkDeviceMemory *mems[] = {&stage->bufmem, &stage->idxbufmem};
+    VkBufferUsageFlags usages[] = {VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                   VK_BUFFER_USAGE_INDEX_BUFFER_BIT};
+
+    for(int i = 0; i < 2; i++)
+    {
+      *bufs[i] = VK_NULL_HANDLE;
+      *mems[i] = VK_NULL_HANDLE;
+
+      if(contents[i]->empty() || !success)
+        continue;
+
+      VkBufferCreateInfo bufInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+      bufInfo.size = contents[i]->size();
+      bufInfo.usage = usages[i] | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+      vkr = m_pDriver->vkCreateBuffer(dev, &bufInfo, NULL, bufs[i]);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      VkMemoryRequirements mrq = {0};
+      m_pDriver->vkGetBufferMemoryRequirements(dev, *bufs[i], &mrq);
+
+      VkMemoryAllocateInfo allocInfo = {
+          VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, NULL, mrq.size,
+          m_pDriver->GetUploadMemoryIndex(mrq.memoryTypeBits),
+      };
+
+      vkr = m_pDriver->vkAllocateMemory(dev, &allocInfo, NULL, mems[i]);
+
+      if(vkr != VK_SUCCESS)
+      {
+        RDCWARN("Failed to allocate %llu bytes for cached post-transform data", mrq.size);
+        *mems[i] = VK_NULL_HANDLE;
+        success = false;
+        continue;
+      }
+
+      vkr = m_pDriver->vkBindBufferMemory(dev, *bufs[i], *mems[i], 0);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      byte *mapped = NULL;
+      vkr = m_pDriver->vkMapMemory(dev, *mems[i], 0, VK_WHOLE_SIZE, 0, (void **)&mapped);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      if(mapped)
+        memcpy(mapped, contents[i]->data(), contents[i]->size());
+
+      VkMappedMemoryRange range = {
+          VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, NULL, *mems[i], 0, VK_WHOLE_SIZE,
+      };
+
+      vkr = m_pDriver->vkFlushMappedMemoryRanges(dev, 1, &range);
+      RDCASSERTEQUAL(vkr, VK_SUCCESS);
+
+      m_pDriver->vkUnmapMemory(dev, *mems[i]);
+    }
+  }
+
+  if(!success || !reader.AtEnd() || data.vsout.buf == VK_NULL_HANDLE)
+  {
+    RDCWARN("Couldn't restore cached post-transform data for event %u", eventId);
+
+    for(VulkanPostVSData::StageData *stage : stages)
+    {
+      if(stage->buf != VK_NULL_HANDLE)
+        m_pDriver->vkDestroyBuffer(dev, stage->buf, NULL);
+      if(stage->bufmem != VK_NULL_HANDLE)
+        m_pDriver->vkFreeMemory(dev, stage->bufmem, NULL);
+      if(stage->idxbuf != VK_NULL_HANDLE)
+        m_pDriver->vkDestroyBuffer(dev, stage->idxbuf, NULL);
+      if(stage->idxbufmem != VK_NULL_HANDLE)
+        m_pDriver->vkFreeMemory(dev, stage->idxbufmem, NULL);
+    }
+
+    return false;
+  }
+
+  m_PostVS.Data[eventId] = data;
+
+  return true;
+}
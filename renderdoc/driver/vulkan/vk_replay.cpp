@@ -318,12 +318,14 @@ rdcarray<ShaderEntryPoint> VulkanReplay::GetShaderEntryPoints(ResourceId shader)
   if(shad == m_pDriver->m_CreationInfo.m_ShaderModule.end())
     return {};
 
-  std::vector<std::string> entries = shad->second.spirv.EntryPoints();
+  const SPVModule &spirv = shad->second.GetSPIRV();
+
+  std::vector<std::string> entries = spirv.EntryPoints();
 
   rdcarray<ShaderEntryPoint> ret;
 
   for(const std::string &e : entries)
-    ret.push_back({e, shad->second.spirv.StageForEntry(e)});
+    ret.push_back({e, spirv.StageForEntry(e)});
 
   return ret;
 }
@@ -338,11 +340,10 @@ ShaderReflection *VulkanReplay::GetShader(ResourceId shader, ShaderEntryPoint en
     return NULL;
   }
 
-  shad->second.m_Reflections[entry.name].Init(GetResourceManager(), shader, shad->second.spirv,
-                                              entry.name,
-                                              VkShaderStageFlagBits(1 << uint32_t(entry.stage)));
-
-  return &shad->second.m_Reflections[entry.name].refl;
+  return &shad->second
+              .GetReflection(GetResourceManager()->GetOriginalID(shader), entry.name,
+                             VkShaderStageFlagBits(1 << uint32_t(entry.stage)))
+              .refl;
 }
 
 std::vector<std::string> VulkanReplay::GetDisassemblyTargets()
@@ -373,12 +374,15 @@ std::string VulkanReplay::DisassembleShader(ResourceId pipeline, const ShaderRef
   if(it == m_pDriver->m_CreationInfo.m_ShaderModule.end())
     return "; Invalid Shader Specified";
 
+  VulkanCreationInfo::ShaderModule::Reflection &reflData = it->second.GetReflection(
+      refl->resourceId, refl->entryPoint.c_str(), VkShaderStageFlagBits(1 << uint32_t(refl->stage)));
+
   if(target == SPIRVDisassemblyTarget || target.empty())
   {
-    std::string &disasm = it->second.m_Reflections[refl->entryPoint.c_str()].disassembly;
+    std::string &disasm = reflData.disassembly;
 
     if(disasm.empty())
-      disasm = it->second.spirv.Disassemble(refl->entryPoint.c_str());
+      disasm = it->second.Disassemble(refl->entryPoint.c_str());
 
     return disasm;
   }
@@ -396,8 +400,7 @@ std::string VulkanReplay::DisassembleShader(ResourceId pipeline, const ShaderRef
 
     VkPipeline pipe = m_pDriver->GetResourceManager()->GetLiveHandle<VkPipeline>(pipeline);
 
-    VkShaderStageFlagBits stageBit =
-        VkShaderStageFlagBits(1 << it->second.m_Reflections[refl->entryPoint.c_str()].stageIndex);
+    VkShaderStageFlagBits stageBit = VkShaderStageFlagBits(1 << reflData.stageIndex);
 
     size_t size;
     vt->GetShaderInfoAMD(Unwrap(dev), Unwrap(pipe), stageBit, VK_SHADER_INFO_TYPE_DISASSEMBLY_AMD,
@@ -864,8 +867,74 @@ void VulkanReplay::SetDriverInformation(const VkPhysicalDeviceProperties &props)
   memcpy(m_DriverInfo.version, versionString.c_str(), versionString.size());
 }
 
+void VulkanReplay::ClearPipelineStateCache()
+{
+  m_PipelineStateCache.sets[0].clear();
+  m_PipelineStateCache.sets[1].clear();
+  m_PipelineStateCache.states.clear();
+}
+
+bool VulkanReplay::PipelineStateCache::SetSource::Update(
+    ResourceId set, const DescSetLayout &layout,
+    const std::vector<DescriptorSetBindingElement *> &bindings, bool used,
+    const BindIdx *usedBegin, const BindIdx *usedEnd)
+{
+  size_t count = 0;
+  for(size_t b = 0; b < bindings.size(); b++)
+    count += layout.bindings[b].descriptorCount;
+
+  bool changed = !valid || descSet != set || contents.size() != count ||
+                 hasUsedBinds != used || usedBinds.size() != size_t(usedEnd - usedBegin);
+
+  if(!changed && !usedBinds.empty())
+    changed = memcmp(usedBinds.data(), usedBegin, usedBinds.size() * sizeof(BindIdx)) != 0;
+
+  for(size_t b = 0, offs = 0; !changed && b < bindings.size(); b++)
+  {
+    uint32_t descriptorCount = layout.bindings[b].descriptorCount;
+    if(descriptorCount > 0)
+      changed = memcmp(&contents[offs], bindings[b],
+                       descriptorCount * sizeof(DescriptorSetBindingElement)) != 0;
+    offs += descriptorCount;
+  }
+
+  if(!changed)
+    return false;
+
+  valid = true;
+  descSet = set;
+  hasUsedBinds = used;
+  usedBinds.assign(usedBegin, usedEnd);
+  contents.resize(count);
+
+  for(size_t b = 0, offs = 0; b < bindings.size(); b++)
+  {
+    uint32_t descriptorCount = layout.bindings[b].descriptorCount;
+    if(descriptorCount > 0)
+      memcpy(&contents[offs], bindings[b], descriptorCount * sizeof(DescriptorSetBindingElement));
+    offs += descriptorCount;
+  }
+
+  return true;
+}
+
 void VulkanReplay::SavePipelineState(uint32_t eventId)
 {
+  for(auto it = m_PipelineStateCache.states.begin(); it != m_PipelineStateCache.states.end(); ++it)
+  {
+    if(it->eventId == eventId)
+    {
+      m_PipelineStateCache.states.splice(m_PipelineStateCache.states.begin(),
+                                         m_PipelineStateCache.states, it);
+      m_VulkanPipelineState = it->state;
+
+      // the descriptor sets were filled elsewhere, so they must be rebuilt on the next miss
+      m_PipelineStateCache.sets[0].clear();
+      m_PipelineStateCache.sets[1].clear();
+      return;
+    }
+  }
+
   const VulkanRenderState &state = m_pDriver->m_RenderState;
   VulkanCreationInfo &c = m_pDriver->m_CreationInfo;
 
@@ -877,7 +946,18 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
 
   VkMarkerRegion::End();
 
-  m_VulkanPipelineState = VKPipe::State();
+  // reset everything but the descriptor sets, which are updated in place further down so that
+  // unchanged sets can be skipped and large descriptor arrays don't need to be reallocated.
+  {
+    rdcarray<VKPipe::DescriptorSet> graphicsSets, computeSets;
+    graphicsSets.swap(m_VulkanPipelineState.graphics.descriptorSets);
+    computeSets.swap(m_VulkanPipelineState.compute.descriptorSets);
+
+    m_VulkanPipelineState = VKPipe::State();
+
+    m_VulkanPipelineState.graphics.descriptorSets.swap(graphicsSets);
+    m_VulkanPipelineState.compute.descriptorSets.swap(computeSets);
+  }
 
   m_VulkanPipelineState.pushconsts.resize(state.pushConstSize);
   memcpy(m_VulkanPipelineState.pushconsts.data(), state.pushconsts, state.pushConstSize);
@@ -902,10 +982,9 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
       stage.entryPoint = p.shaders[i].entryPoint;
 
       stage.stage = ShaderStage::Compute;
-      if(p.shaders[i].mapping)
-        stage.bindpointMapping = *p.shaders[i].mapping;
-      if(p.shaders[i].refl)
-        stage.reflection = p.shaders[i].refl;
+      if(p.shaders[i].GetMapping())
+        stage.bindpointMapping = *p.shaders[i].GetMapping();
+      stage.reflection = p.shaders[i].GetReflection();
 
       stage.specialization.resize(p.shaders[i].specialization.size());
       for(size_t s = 0; s < p.shaders[i].specialization.size(); s++)
@@ -978,10 +1057,9 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
       stages[i]->entryPoint = p.shaders[i].entryPoint;
 
       stages[i]->stage = StageFromIndex(i);
-      if(p.shaders[i].mapping)
-        stages[i]->bindpointMapping = *p.shaders[i].mapping;
-      if(p.shaders[i].refl)
-        stages[i]->reflection = p.shaders[i].refl;
+      if(p.shaders[i].GetMapping())
+        stages[i]->bindpointMapping = *p.shaders[i].GetMapping();
+      stages[i]->reflection = p.shaders[i].GetReflection();
 
       stages[i]->specialization.resize(p.shaders[i].specialization.size());
       for(size_t s = 0; s < p.shaders[i].specialization.size(); s++)
@@ -1349,6 +1427,8 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
   // Descriptor sets
   m_VulkanPipelineState.graphics.descriptorSets.resize(state.graphics.descSets.size());
   m_VulkanPipelineState.compute.descriptorSets.resize(state.compute.descSets.size());
+  m_PipelineStateCache.sets[0].resize(state.graphics.descSets.size());
+  m_PipelineStateCache.sets[1].resize(state.compute.descSets.size());
 
   {
     rdcarray<VKPipe::DescriptorSet> *dsts[] = {
@@ -1376,6 +1456,8 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
         }
       }
 
+      const BindIdx *usedBindsEnd = usedBindsData + usedBindsSize;
+
       BindIdx curBind;
 
       for(size_t i = 0; i < srcs[p]->size(); i++)
@@ -1387,6 +1469,22 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
 
         ResourceId layoutId = m_pDriver->m_DescriptorSetState[src].layout;
 
+        // the used binds for this set, to check along with the descriptors whether anything changed
+        const BindIdx *setUsedBegin = usedBindsData, *setUsedEnd = usedBindsData;
+        if(hasUsedBinds)
+        {
+          BindIdx setStart = {(uint32_t)i, 0, 0}, nextSetStart = {(uint32_t)i + 1, 0, 0};
+          setUsedBegin = std::lower_bound(usedBindsData, usedBindsEnd, setStart);
+          setUsedEnd = std::lower_bound(setUsedBegin, usedBindsEnd, nextSetStart);
+        }
+
+        // if this set was filled from the same descriptors last time, it's already up to date.
+        // The used binds list below is consumed by position so skipping a set is safe.
+        if(!m_PipelineStateCache.sets[p][i].Update(
+               src, c.m_DescSetLayout[layoutId], m_pDriver->m_DescriptorSetState[src].currentBindings,
+               hasUsedBinds, setUsedBegin, setUsedEnd))
+          continue;
+
         // push descriptors don't have a real descriptor set backing them
         if(c.m_DescSetLayout[layoutId].flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR)
         {
@@ -1410,6 +1508,7 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
 
           bool dynamicOffset = false;
 
+          dst.bindings[b].dynamicallyUsedCount = 0;
           dst.bindings[b].descriptorCount = layoutBind.descriptorCount;
           dst.bindings[b].stageFlags = (ShaderStageMask)layoutBind.stageFlags;
           switch(layoutBind.descriptorType)
@@ -1455,6 +1554,9 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
           {
             VKPipe::BindingElement &dstel = dst.bindings[b].binds[a];
 
+            // the storage may still hold an element from a previous event
+            dstel = VKPipe::BindingElement();
+
             curBind.arrayidx = a;
 
             // if we have a list of used binds, and this is an array descriptor (so would be
@@ -1713,6 +1815,13 @@ void VulkanReplay::SavePipelineState(uint32_t eventId)
       m_VulkanPipelineState.conditionalRendering.isPassing =
           !m_VulkanPipelineState.conditionalRendering.isPassing;
   }
+
+  if(m_PipelineStateCache.states.size() >= PipelineStateCache::NUM_CACHED_STATES)
+    m_PipelineStateCache.states.pop_back();
+
+  m_PipelineStateCache.states.push_front(PipelineStateCache::CachedState());
+  m_PipelineStateCache.states.front().eventId = eventId;
+  m_PipelineStateCache.states.front().state = m_VulkanPipelineState;
 }
 
 void VulkanReplay::FillCBufferVariables(ResourceId shader, std::string entryPoint, uint32_t cbufSlot,
@@ -1730,8 +1839,12 @@ void VulkanReplay::FillCBufferVariables(ResourceId shader, std::string entryPoin
     return;
   }
 
-  ShaderReflection &refl = it->second.m_Reflections[entryPoint].refl;
-  ShaderBindpointMapping &mapping = it->second.m_Reflections[entryPoint].mapping;
+  VulkanCreationInfo::ShaderModule::Reflection &reflData = it->second.GetReflection(
+      GetResourceManager()->GetOriginalID(shader), entryPoint,
+      VkShaderStageFlagBits(1 << uint32_t(it->second.GetSPIRV().StageForEntry(entryPoint))));
+
+  ShaderReflection &refl = reflData.refl;
+  ShaderBindpointMapping &mapping = reflData.mapping;
 
   if(cbufSlot >= (uint32_t)refl.constantBlocks.count())
   {
@@ -1761,7 +1874,7 @@ void VulkanReplay::FillCBufferVariables(ResourceId shader, std::string entryPoin
         if(pipeIt != m_pDriver->m_CreationInfo.m_Pipeline.end())
         {
           auto specInfo =
-              pipeIt->second.shaders[it->second.m_Reflections[entryPoint].stageIndex].specialization;
+              pipeIt->second.shaders[reflData.stageIndex].specialization;
 
           FillSpecConstantVariables(c.variables, outvars, specInfo);
         }
@@ -3576,6 +3689,9 @@ void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
 {
   VkDevice dev = m_pDriver->GetDev();
 
+  // checkpoints were taken with the old shaders, so results after them would be stale
+  m_pDriver->ClearReplayCheckpoints();
+
   VulkanResourceManager *rm = m_pDriver->GetResourceManager();
 
   // we're passed in the original ID but we want the live ID for comparison
@@ -3650,6 +3766,7 @@ void VulkanReplay::ReplaceResource(ResourceId from, ResourceId to)
 
   ClearPostVSCache();
   ClearFeedbackCache();
+  ClearPipelineStateCache();
 }
 
 void VulkanReplay::RemoveReplacement(ResourceId id)
@@ -3664,6 +3781,8 @@ void VulkanReplay::RemoveReplacement(ResourceId id)
   if(!rm->HasReplacement(id))
     return;
 
+  m_pDriver->ClearReplayCheckpoints();
+
   // remove the actual shader module replacements
   rm->RemoveReplacement(id);
   rm->RemoveReplacement(liveid);
@@ -3697,6 +3816,7 @@ void VulkanReplay::RemoveReplacement(ResourceId id)
 
   ClearPostVSCache();
   ClearFeedbackCache();
+  ClearPipelineStateCache();
 }
 
 std::vector<PixelModification> VulkanReplay::PixelHistory(std::vector<EventUsage> events,
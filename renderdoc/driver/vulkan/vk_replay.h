@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <list>
 #include "api/replay/renderdoc_replay.h"
 #include "core/core.h"
 #include "replay/replay_driver.h"
@@ -388,6 +389,8 @@ private:
   void FetchShaderFeedback(uint32_t eventId);
   void ClearFeedbackCache();
 
+  void ClearPipelineStateCache();
+
   void PatchReservedDescriptors(const VulkanStatePipeline &pipe, VkDescriptorPool &descpool,
                                 std::vector<VkDescriptorSetLayout> &setLayouts,
                                 std::vector<VkDescriptorSet> &descSets,
@@ -399,6 +402,11 @@ private:
   void FetchTessGSOut(uint32_t eventId);
   void ClearPostVSCache();
 
+  ReplayDiskCache &GetPostVSDiskCache();
+  uint64_t GetPostVSCacheKey(uint32_t eventId);
+  bool LoadPostVSCache(uint32_t eventId, uint64_t key);
+  void StorePostVSCache(uint32_t eventId, uint64_t key);
+
   bool RenderTextureInternal(TextureDisplay cfg, VkRenderPassBeginInfo rpbegin, int flags);
 
   bool GetMinMax(ResourceId texid, uint32_t sliceFace, uint32_t mip, uint32_t sample,
@@ -656,6 +664,9 @@ private:
 
     std::map<uint32_t, VulkanPostVSData> Data;
     std::map<uint32_t, uint32_t> Alias;
+
+    // outputs saved between sessions, created on first use
+    ReplayDiskCache *DiskCache = NULL;
   } m_PostVS;
 
   struct Feedback
@@ -672,6 +683,38 @@ private:
 
   VKPipe::State m_VulkanPipelineState;
 
+  struct PipelineStateCache
+  {
+    // the raw descriptors each set in m_VulkanPipelineState was last filled from, indexed by
+    // [graphics/compute][set]. Sets whose source hasn't changed are left as-is on the next event.
+    struct SetSource
+    {
+      // returns true and records the new source if anything differs from last time
+      bool Update(ResourceId set, const DescSetLayout &layout,
+                  const std::vector<DescriptorSetBindingElement *> &bindings, bool used,
+                  const BindIdx *usedBegin, const BindIdx *usedEnd);
+
+      bool valid = false;
+      ResourceId descSet;
+      bool hasUsedBinds = false;
+      std::vector<BindIdx> usedBinds;
+      std::vector<DescriptorSetBindingElement> contents;
+    };
+
+    std::vector<SetSource> sets[2];
+
+    struct CachedState
+    {
+      uint32_t eventId;
+      VKPipe::State state;
+    };
+
+    static const size_t NUM_CACHED_STATES = 8;
+
+    // most recently used at the front
+    std::list<CachedState> states;
+  } m_PipelineStateCache;
+
   DriverInformation m_DriverInfo;
 
   void CreateTexImageView(VkImage liveIm, const VulkanCreationInfo::Image &iminfo,
@@ -2903,6 +2903,13 @@ VkFormat MakeVkFormat(ResourceFormat fmt)
   return ret;
 }
 
+static volatile int64_t bindRefGenerationCounter = 0;
+
+int64_t DescriptorSetData::NewBindRefGeneration()
+{
+  return Atomic::Inc64(&bindRefGenerationCounter);
+}
+
 VkResourceRecord::~VkResourceRecord()
 {
   VkResourceType resType = Resource != NULL ? IdentifyTypeByPtr(Resource) : eResUnknown;
@@ -2974,6 +2981,53 @@ void VkResourceRecord::MarkBufferFrameReferenced(VkResourceRecord *buf, VkDevice
     MarkMemoryFrameReferenced(buf->baseResource, buf->memOffset + offset, size, refType);
 }
 
+void ImageSubresourceRefs::Add(VkImageSubresourceRange range)
+{
+  range.aspectMask = 0;
+
+  for(const VkImageSubresourceRange &r : ranges)
+  {
+    if(r.baseMipLevel == range.baseMipLevel && r.levelCount == range.levelCount &&
+       r.baseArrayLayer == range.baseArrayLayer && r.layerCount == range.layerCount)
+      return;
+  }
+
+  // an image referenced in lots of different ways is just treated as entirely referenced, to keep
+  // this list short
+  if(ranges.size() >= 32)
+  {
+    ranges.clear();
+    range = {0, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+  }
+
+  ranges.push_back(range);
+}
+
+void ImageSubresourceRefs::Merge(const ImageSubresourceRefs &other)
+{
+  for(const VkImageSubresourceRange &r : other.ranges)
+    Add(r);
+}
+
+bool ImageSubresourceRefs::Contains(uint32_t layer, uint32_t mip) const
+{
+  for(const VkImageSubresourceRange &r : ranges)
+  {
+    if(mip < r.baseMipLevel || layer < r.baseArrayLayer)
+      continue;
+
+    if(r.levelCount != VK_REMAINING_MIP_LEVELS && mip - r.baseMipLevel >= r.levelCount)
+      continue;
+
+    if(r.layerCount != VK_REMAINING_ARRAY_LAYERS && layer - r.baseArrayLayer >= r.layerCount)
+      continue;
+
+    return true;
+  }
+
+  return false;
+}
+
 void VkResourceRecord::MarkBufferImageCopyFrameReferenced(
     VkResourceRecord *buf, VkResourceRecord *img, const ImageLayouts &layout, uint32_t regionCount,
     const VkBufferImageCopy *regions, FrameRefType bufRefType, FrameRefType imgRefType)
@@ -2991,6 +3045,8 @@ void VkResourceRecord::MarkBufferImageCopyFrameReferenced(
   {
     const VkBufferImageCopy &region = regions[ri];
 
+    MarkImageSubresourcesReferenced(img->GetResourceID(), region.imageSubresource);
+
     VkFormat regionFormat = layout.format;
     uint32_t plane = 0;
     switch(region.imageSubresource.aspectMask)
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <unordered_map>
 #include "common/wrapped_pool.h"
 #include "core/intervals.h"
 #include "core/resource_manager.h"
@@ -909,6 +910,22 @@ struct ResourceInfo
 
 struct MemRefs;
 
+// the array layers and mips of an image that a frame references, as a short list of ranges. Aspects
+// are ignored. Only used while capturing, so that initial contents can skip subresources nothing in
+// the frame can see.
+struct ImageSubresourceRefs
+{
+  void Add(VkImageSubresourceRange range);
+  void Add(const VkImageSubresourceLayers &layers)
+  {
+    Add({layers.aspectMask, layers.mipLevel, 1, layers.baseArrayLayer, layers.layerCount});
+  }
+  void Merge(const ImageSubresourceRefs &other);
+  bool Contains(uint32_t layer, uint32_t mip) const;
+
+  std::vector<VkImageSubresourceRange> ranges;
+};
+
 struct CmdBufferRecordingInfo
 {
   VkDevice device;
@@ -935,8 +952,26 @@ struct CmdBufferRecordingInfo
 
   std::map<ResourceId, MemRefs> memFrameRefs;
 
+  // subresources of images referenced directly by commands, rather than through a view
+  std::map<ResourceId, ImageSubresourceRefs> imgFrameRefs;
+
   // AdvanceFrame/Present should be called after this buffer is submitted
   bool present;
+
+  // when capturing, the frame refs a submit of this command buffer makes - its own, its
+  // secondaries' and its bound descriptor sets' - composed per resource and sorted by ID, along
+  // with the sparse resources among them. They're recomposed only when the generation of a bound
+  // descriptor set differs from the one in composedDescSetGens (in boundDescSets order).
+  Threading::CriticalSection composedRefsLock;
+  bool refsComposed = false;
+  std::vector<int64_t> composedDescSetGens;
+  std::vector<std::pair<ResourceId, FrameRefTransition> > composedRefs;
+  std::vector<ResourceInfo *> composedSparse;
+
+  // the frame ref generation from just before the composed refs were last merged. If it's still
+  // the same, merging them again would have no effect.
+  bool refsMerged = false;
+  uint64_t mergedFrameRefGen = 0;
 };
 
 struct DescSetLayout;
@@ -957,7 +992,7 @@ struct DescriptorSetData
   // create from the layout.
   std::vector<DescriptorSetBindingElement *> descBindings;
 
-  // lock protecting bindFrameRefs and bindMemRefs
+  // lock protecting bindFrameRefs, bindFrameRefIndex, pendingDirtyRefs and bindMemRefs
   Threading::CriticalSection refLock;
 
   // contains the framerefs (ref counted) for the bound resources
@@ -965,9 +1000,106 @@ struct DescriptorSetData
   // and then applied in a block on descriptor set bind.
   // the refcount has the high-bit set if this resource has sparse
   // mapping information
+  // This is a dense unordered array so that walking every bound resource on submit is a linear
+  // scan, with bindFrameRefIndex giving the slot for each ID. Removed entries are swapped with the
+  // last element.
   static const uint32_t SPARSE_REF_BIT = 0x80000000;
-  std::map<ResourceId, rdcpair<uint32_t, FrameRefType> > bindFrameRefs;
+  typedef rdcpair<ResourceId, rdcpair<uint32_t, FrameRefType> > BindFrameRef;
+  std::vector<BindFrameRef> bindFrameRefs;
+
+  struct ResourceIdHash
+  {
+    size_t operator()(ResourceId id) const
+    {
+      uint64_t num;
+      memcpy(&num, &id, sizeof(num));
+      return std::hash<uint64_t>()(num);
+    }
+  };
+  std::unordered_map<ResourceId, size_t, ResourceIdHash> bindFrameRefIndex;
+
+  // IDs whose ref became a write since the last submit this set was bound in. Resources never
+  // become clean again once dirty, so the per-submit dirty marking only has to look at these rather
+  // than at every bound resource.
+  std::vector<ResourceId> pendingDirtyRefs;
+
   std::map<ResourceId, MemRefs> bindMemRefs;
+
+  // returns a value that changes whenever the refs above change, so submits can tell when their
+  // composed refs are stale. Values come from a global counter and are only assigned when asked
+  // for, so they're never repeated by another set (or this one after being freed and reallocated).
+  // Must be called with refLock held.
+  int64_t GetBindRefGeneration()
+  {
+    if(bindRefsChanged)
+    {
+      bindRefGeneration = NewBindRefGeneration();
+      bindRefsChanged = false;
+    }
+    return bindRefGeneration;
+  }
+
+  void MarkBindRefsChanged() { bindRefsChanged = true; }
+
+  static bool IsDirtyingRef(FrameRefType ref)
+  {
+    return ref == eFrameRef_PartialWrite || ref == eFrameRef_ReadBeforeWrite;
+  }
+
+  void AddPendingDirtyRef(ResourceId id)
+  {
+    pendingDirtyRefs.push_back(id);
+
+    // a set that's updated repeatedly but never submitted would grow this without bound, so rebuild
+    // it from the current refs once it's much larger than them.
+    if(pendingDirtyRefs.size() > 64 && pendingDirtyRefs.size() > bindFrameRefs.size() * 2)
+    {
+      pendingDirtyRefs.clear();
+      for(const BindFrameRef &ref : bindFrameRefs)
+        if(IsDirtyingRef(ref.second.second))
+          pendingDirtyRefs.push_back(ref.first);
+    }
+  }
+
+  rdcpair<uint32_t, FrameRefType> &GetBindFrameRef(ResourceId id)
+  {
+    auto it = bindFrameRefIndex.find(id);
+    if(it != bindFrameRefIndex.end())
+      return bindFrameRefs[it->second].second;
+
+    bindFrameRefIndex[id] = bindFrameRefs.size();
+    bindFrameRefs.push_back(make_rdcpair(id, make_rdcpair(0U, eFrameRef_None)));
+    return bindFrameRefs.back().second;
+  }
+
+  const rdcpair<uint32_t, FrameRefType> *FindBindFrameRef(ResourceId id) const
+  {
+    auto it = bindFrameRefIndex.find(id);
+    if(it == bindFrameRefIndex.end())
+      return NULL;
+    return &bindFrameRefs[it->second].second;
+  }
+
+  void EraseBindFrameRef(ResourceId id)
+  {
+    auto it = bindFrameRefIndex.find(id);
+    if(it == bindFrameRefIndex.end())
+      return;
+
+    size_t idx = it->second;
+    bindFrameRefIndex.erase(it);
+
+    if(idx + 1 < bindFrameRefs.size())
+    {
+      bindFrameRefs[idx] = bindFrameRefs.back();
+      bindFrameRefIndex[bindFrameRefs[idx].first] = idx;
+    }
+    bindFrameRefs.pop_back();
+  }
+
+  static int64_t NewBindRefGeneration();
+  bool bindRefsChanged = true;
+  int64_t bindRefGeneration = 0;
 };
 
 struct PipelineLayoutData
@@ -1123,7 +1255,9 @@ public:
       RDCERR("Unexpected NULL resource ID being added as a bind frame ref");
       return;
     }
-    rdcpair<uint32_t, FrameRefType> &p = descInfo->bindFrameRefs[id];
+    descInfo->MarkBindRefsChanged();
+    rdcpair<uint32_t, FrameRefType> &p = descInfo->GetBindFrameRef(id);
+    FrameRefType prevRef = p.second;
     if((p.first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
     {
       p.second = ref;
@@ -1132,10 +1266,12 @@ public:
     else
     {
       // be conservative - mark refs as read before write if we see a write and a read ref on it
-      p.second = ComposeFrameRefsUnordered(descInfo->bindFrameRefs[id].second, ref);
+      p.second = ComposeFrameRefsUnordered(p.second, ref);
       p.first++;
       p.first |= (hasSparse ? DescriptorSetData::SPARSE_REF_BIT : 0);
     }
+    if(p.second != prevRef && DescriptorSetData::IsDirtyingRef(p.second))
+      descInfo->AddPendingDirtyRef(id);
   }
 
   void AddMemFrameRef(ResourceId mem, VkDeviceSize offset, VkDeviceSize size, FrameRefType refType)
@@ -1145,12 +1281,14 @@ public:
       RDCERR("Unexpected NULL resource ID being added as a bind frame ref");
       return;
     }
-    rdcpair<uint32_t, FrameRefType> &p = descInfo->bindFrameRefs[mem];
+    descInfo->MarkBindRefsChanged();
+    rdcpair<uint32_t, FrameRefType> &p = descInfo->GetBindFrameRef(mem);
+    FrameRefType prevRef = p.second;
     if((p.first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
     {
       descInfo->bindMemRefs.erase(mem);
       p.first = 1;
-      p.second = eFrameRef_None;
+      p.second = prevRef = eFrameRef_None;
     }
     else
     {
@@ -1159,6 +1297,8 @@ public:
     FrameRefType maxRef = MarkMemoryReferenced(descInfo->bindMemRefs, mem, offset, size, refType,
                                                ComposeFrameRefsUnordered);
     p.second = std::max(p.second, maxRef);
+    if(p.second != prevRef && DescriptorSetData::IsDirtyingRef(p.second))
+      descInfo->AddPendingDirtyRef(mem);
   }
 
   void RemoveBindFrameRef(ResourceId id)
@@ -1168,19 +1308,22 @@ public:
     if(id == ResourceId())
       return;
 
-    auto it = descInfo->bindFrameRefs.find(id);
+    auto it = descInfo->bindFrameRefIndex.find(id);
 
     // in the case of re-used handles bound to descriptor sets,
     // it's possible to try and remove a frameref on something we
     // don't have (which means we'll have a corresponding stale ref)
     // but this is harmless so we can ignore it.
-    if(it == descInfo->bindFrameRefs.end())
+    if(it == descInfo->bindFrameRefIndex.end())
       return;
 
-    it->second.first--;
+    rdcpair<uint32_t, FrameRefType> &p = descInfo->bindFrameRefs[it->second].second;
+
+    descInfo->MarkBindRefsChanged();
+    p.first--;
 
-    if((it->second.first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
-      descInfo->bindFrameRefs.erase(it);
+    if((p.first & ~DescriptorSetData::SPARSE_REF_BIT) == 0)
+      descInfo->EraseBindFrameRef(id);
   }
 
   // we have a lot of 'cold' data in the resource record, as it can be accessed
@@ -1217,6 +1360,11 @@ public:
                                           const VkBufferImageCopy *regions, FrameRefType bufRefType,
                                           FrameRefType imgRefType);
   void MarkBufferViewFrameReferenced(VkResourceRecord *buf, FrameRefType refType);
+  template <typename SubresourceType>
+  void MarkImageSubresourcesReferenced(ResourceId img, const SubresourceType &subresources)
+  {
+    cmdInfo->imgFrameRefs[img].Add(subresources);
+  }
   // these are all disjoint, so only a record of the right type will have each
   // Note some of these need to be deleted in the constructor, so we check the
   // allocation type of the Resource
@@ -101,7 +101,6 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
          sizeof(VkSparseMemoryBind) * numElems);
 
   VkDevice d = GetDev();
-  // INITSTATEBATCH
   VkCommandBuffer cmd = GetNextCmd();
 
   VkBufferCreateInfo bufInfo = {
@@ -182,18 +181,13 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkBuffer *buf)
   vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
-
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-  {
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(bufdeletes[i]), NULL);
-    GetResourceManager()->ReleaseWrappedResource(bufdeletes[i]);
-  }
+  m_PrepareInitStateBuffers.insert(m_PrepareInitStateBuffers.end(), bufdeletes.begin(),
+                                  bufdeletes.end());
 
   GetResourceManager()->SetInitialContents(id, initContents);
 
+  AddPendingInitialStatePrepare();
+
   return true;
 }
 
@@ -263,7 +257,6 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
   }
 
   VkDevice d = GetDev();
-  // INITSTATEBATCH
   VkCommandBuffer cmd = GetNextCmd();
 
   VkBufferCreateInfo bufInfo = {
@@ -344,18 +337,13 @@ bool WrappedVulkan::Prepare_SparseInitialState(WrappedVkImage *im)
   vkr = ObjDisp(d)->EndCommandBuffer(Unwrap(cmd));
   RDCASSERTEQUAL(vkr, VK_SUCCESS);
 
-  // INITSTATEBATCH
-  SubmitCmds();
-  FlushQ();
-
-  for(size_t i = 0; i < bufdeletes.size(); i++)
-  {
-    ObjDisp(d)->DestroyBuffer(Unwrap(d), Unwrap(bufdeletes[i]), NULL);
-    GetResourceManager()->ReleaseWrappedResource(bufdeletes[i]);
-  }
+  m_PrepareInitStateBuffers.insert(m_PrepareInitStateBuffers.end(), bufdeletes.begin(),
+                                  bufdeletes.end());
 
   GetResourceManager()->SetInitialContents(id, initContents);
 
+  AddPendingInitialStatePrepare();
+
   return true;
 }
 
@@ -429,26 +417,11 @@ bool WrappedVulkan::Serialise_SparseBufferInitialState(SerialiserType &ser, Reso
   MemoryAllocation uploadMemory;
   VkBuffer uploadBuf = VK_NULL_HANDLE;
 
-  // during writing, we already have the memory copied off - we just need to map it.
+  // during writing, we already have the memory copied off - we just need to map it. The mapping
+  // is shared with other resources in the same allocation and is unmapped once they're all done.
   if(ser.IsWriting())
   {
-    // the memory was created not wrapped.
-    mappedMem = contents->mem;
-    vkr = ObjDisp(d)->MapMemory(Unwrap(d), Unwrap(mappedMem.mem), mappedMem.offs, mappedMem.size, 0,
-                                (void **)&Contents);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
-
-    // invalidate the cpu cache for this memory range to avoid reading stale data
-    VkMappedMemoryRange range = {
-        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-        NULL,
-        Unwrap(mappedMem.mem),
-        mappedMem.offs,
-        mappedMem.size,
-    };
-
-    vkr = ObjDisp(d)->InvalidateMappedMemoryRanges(Unwrap(d), 1, &range);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    Contents = MapInitialStateReadback(contents->mem);
   }
   else if(IsReplayingAndReading() && !ser.IsErrored())
   {
@@ -545,13 +518,11 @@ bool WrappedVulkan::Serialise_SparseImageInitialState(SerialiserType &ser, Resou
   MemoryAllocation uploadMemory;
   VkBuffer uploadBuf = VK_NULL_HANDLE;
 
-  // during writing, we already have the memory copied off - we just need to map it.
+  // during writing, we already have the memory copied off - we just need to map it. The mapping
+  // is shared with other resources in the same allocation and is unmapped once they're all done.
   if(ser.IsWriting())
   {
-    mappedMem = contents->mem;
-    vkr = ObjDisp(d)->MapMemory(Unwrap(d), Unwrap(mappedMem.mem), mappedMem.offs, mappedMem.size, 0,
-                                (void **)&Contents);
-    RDCASSERTEQUAL(vkr, VK_SUCCESS);
+    Contents = MapInitialStateReadback(contents->mem);
   }
   else if(IsReplayingAndReading() && !ser.IsErrored())
   {
@@ -215,6 +215,7 @@ rdcstr DoStringise(const MemoryScope &el)
   {
     STRINGISE_ENUM_CLASS(InitialContents);
     STRINGISE_ENUM_CLASS(IndirectReadback);
+    STRINGISE_ENUM_CLASS(ReplayCheckpoints);
   }
   END_ENUM_STRINGISE()
 }
@@ -697,14 +697,15 @@ bool WrappedVulkan::Serialise_vkBeginCommandBuffer(SerialiserType &ser, VkComman
             partial = true;
             partialType = p;
           }
-          else if(it->baseEvent <= m_LastEventID)
+          else if(it->baseEvent <= m_LastEventID && it->baseEvent + length >= m_ResumeEventID)
           {
 #if ENABLED(VERBOSE_PARTIAL_REPLAY)
             RDCDEBUG("vkBegin - full re-record detected %u < %u <= %u, %llu -> %llu", it->baseEvent,
                      it->baseEvent + length, m_LastEventID, m_LastCmdBufferID, BakedCommandBuffer);
 #endif
 
-            // this submission is completely within the range, so it should still be re-recorded
+            // this submission is completely within the range, so it should still be re-recorded.
+            // Submissions before a checkpoint we're resuming from are never submitted, so skip them
             rerecord = true;
           }
         }
@@ -1189,6 +1190,14 @@ bool WrappedVulkan::Serialise_vkCmdBeginRenderPass(SerialiserType &ser, VkComman
       m_BakedCmdBufferInfo[m_LastCmdBufferID].state.framebuffer =
           GetResID(RenderPassBegin.framebuffer);
 
+      // load/store ops and resolves can write attachments even if nothing is drawn
+      const VulkanCreationInfo::Framebuffer &fbinfo =
+          m_CreationInfo.m_Framebuffer[GetResID(RenderPassBegin.framebuffer)];
+      for(size_t i = 0; i < fbinfo.attachments.size(); i++)
+        if(fbinfo.attachments[i].view != ResourceId())
+          m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(
+              m_CreationInfo.m_ImageView[fbinfo.attachments[i].view].image);
+
       std::vector<VkImageMemoryBarrier> imgBarriers = GetImplicitRenderPassBarriers();
 
       ResourceId cmd = GetResID(commandBuffer);
@@ -1247,6 +1256,8 @@ void WrappedVulkan::vkCmdBeginRenderPass(VkCommandBuffer commandBuffer,
         break;
 
       record->MarkResourceFrameReferenced(att->baseResource, eFrameRef_ReadBeforeWrite);
+      record->MarkImageSubresourcesReferenced(att->baseResource,
+                                              (VkImageSubresourceRange)att->viewRange);
       if(att->baseResourceMem != ResourceId())
         record->MarkResourceFrameReferenced(att->baseResourceMem, eFrameRef_Read);
       if(att->resInfo)
@@ -1528,6 +1539,14 @@ bool WrappedVulkan::Serialise_vkCmdBeginRenderPass2KHR(SerialiserType &ser,
       m_BakedCmdBufferInfo[m_LastCmdBufferID].state.framebuffer =
           GetResID(RenderPassBegin.framebuffer);
 
+      // load/store ops and resolves can write attachments even if nothing is drawn
+      const VulkanCreationInfo::Framebuffer &fbinfo =
+          m_CreationInfo.m_Framebuffer[GetResID(RenderPassBegin.framebuffer)];
+      for(size_t i = 0; i < fbinfo.attachments.size(); i++)
+        if(fbinfo.attachments[i].view != ResourceId())
+          m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(
+              m_CreationInfo.m_ImageView[fbinfo.attachments[i].view].image);
+
       std::vector<VkImageMemoryBarrier> imgBarriers = GetImplicitRenderPassBarriers();
 
       ResourceId cmd = GetResID(commandBuffer);
@@ -1592,6 +1611,8 @@ void WrappedVulkan::vkCmdBeginRenderPass2KHR(VkCommandBuffer commandBuffer,
         break;
 
       record->MarkResourceFrameReferenced(att->baseResource, eFrameRef_ReadBeforeWrite);
+      record->MarkImageSubresourcesReferenced(att->baseResource,
+                                              (VkImageSubresourceRange)att->viewRange);
       if(att->baseResourceMem != ResourceId())
         record->MarkResourceFrameReferenced(att->baseResourceMem, eFrameRef_Read);
       if(att->resInfo)
@@ -2322,6 +2343,10 @@ bool WrappedVulkan::Serialise_vkCmdUpdateBuffer(SerialiserType &ser, VkCommandBu
       else
         commandBuffer = VK_NULL_HANDLE;
     }
+    else
+    {
+      m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(GetResID(destBuffer));
+    }
 
     if(commandBuffer != VK_NULL_HANDLE)
     {
@@ -2385,6 +2410,10 @@ bool WrappedVulkan::Serialise_vkCmdFillBuffer(SerialiserType &ser, VkCommandBuff
       else
         commandBuffer = VK_NULL_HANDLE;
     }
+    else
+    {
+      m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(GetResID(destBuffer));
+    }
 
     if(commandBuffer != VK_NULL_HANDLE)
     {
@@ -2747,6 +2776,10 @@ bool WrappedVulkan::Serialise_vkCmdCopyQueryPoolResults(
       else
         commandBuffer = VK_NULL_HANDLE;
     }
+    else
+    {
+      m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(GetResID(destBuffer));
+    }
 
     if(commandBuffer != VK_NULL_HANDLE)
     {
@@ -2993,6 +3026,15 @@ bool WrappedVulkan::Serialise_vkCmdExecuteCommands(SerialiserType &ser, VkComman
             m_BakedCmdBufferInfo[GetResID(pCommandBuffers[i])].imgbarriers);
       }
 
+      // likewise the resources the secondaries write
+      for(uint32_t i = 0; i < commandBufferCount; i++)
+      {
+        ResourceId origId = GetResourceManager()->GetOriginalID(GetResID(pCommandBuffers[i]));
+        const std::set<ResourceId> &written = m_BakedCmdBufferInfo[origId].writtenResources;
+        m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(written.begin(),
+                                                                        written.end());
+      }
+
       // append deferred indirect copies
       {
         std::vector<VkIndirectRecordData> &dstIndirect =
@@ -4115,6 +4157,10 @@ bool WrappedVulkan::Serialise_vkCmdWriteBufferMarkerAMD(SerialiserType &ser,
       else
         commandBuffer = VK_NULL_HANDLE;
     }
+    else
+    {
+      m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(GetResID(dstBuffer));
+    }
 
     if(commandBuffer != VK_NULL_HANDLE)
     {
@@ -4650,6 +4696,11 @@ bool WrappedVulkan::Serialise_vkCmdEndTransformFeedbackEXT(
       // track while reading, for fetching the right set of outputs in AddDrawcall
       m_BakedCmdBufferInfo[m_LastCmdBufferID].state.xfbfirst = 0;
       m_BakedCmdBufferInfo[m_LastCmdBufferID].state.xfbcount = 0;
+
+      for(uint32_t i = 0; i < bufferCount; i++)
+        if(pCounterBuffers && pCounterBuffers[i] != VK_NULL_HANDLE)
+          m_BakedCmdBufferInfo[m_LastCmdBufferID].writtenResources.insert(
+              GetResID(pCounterBuffers[i]));
     }
   }
 
@@ -773,6 +773,8 @@ void WrappedVulkan::Shutdown()
     }
   }
 
+  ClearReplayCheckpoints();
+
   FreeAllMemory(MemoryScope::InitialContents);
 
   // we do more in Shutdown than the equivalent vkDestroyInstance since on replay there's
@@ -1415,6 +1415,11 @@ void WrappedVulkan::vkCmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcIma
     record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetResID(destImage), eFrameRef_PartialWrite);
     record->MarkResourceFrameReferenced(GetRecord(destImage)->baseResource, eFrameRef_Read);
+    for(uint32_t i = 0; i < regionCount; i++)
+    {
+      record->MarkImageSubresourcesReferenced(GetResID(srcImage), pRegions[i].srcSubresource);
+      record->MarkImageSubresourcesReferenced(GetResID(destImage), pRegions[i].dstSubresource);
+    }
     record->cmdInfo->dirtied.insert(GetResID(destImage));
     if(GetRecord(srcImage)->resInfo)
       record->cmdInfo->sparse.insert(GetRecord(srcImage)->resInfo);
@@ -1539,6 +1544,11 @@ void WrappedVulkan::vkCmdResolveImage(VkCommandBuffer commandBuffer, VkImage src
     record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetResID(destImage), eFrameRef_PartialWrite);
     record->MarkResourceFrameReferenced(GetRecord(destImage)->baseResource, eFrameRef_Read);
+    for(uint32_t i = 0; i < regionCount; i++)
+    {
+      record->MarkImageSubresourcesReferenced(GetResID(srcImage), pRegions[i].srcSubresource);
+      record->MarkImageSubresourcesReferenced(GetResID(destImage), pRegions[i].dstSubresource);
+    }
     record->cmdInfo->dirtied.insert(GetResID(destImage));
     if(GetRecord(srcImage)->resInfo)
       record->cmdInfo->sparse.insert(GetRecord(srcImage)->resInfo);
@@ -1661,6 +1671,11 @@ void WrappedVulkan::vkCmdCopyImage(VkCommandBuffer commandBuffer, VkImage srcIma
     record->MarkResourceFrameReferenced(GetRecord(srcImage)->baseResource, eFrameRef_Read);
     record->MarkResourceFrameReferenced(GetResID(destImage), eFrameRef_PartialWrite);
     record->MarkResourceFrameReferenced(GetRecord(destImage)->baseResource, eFrameRef_Read);
+    for(uint32_t i = 0; i < regionCount; i++)
+    {
+      record->MarkImageSubresourcesReferenced(GetResID(srcImage), pRegions[i].srcSubresource);
+      record->MarkImageSubresourcesReferenced(GetResID(destImage), pRegions[i].dstSubresource);
+    }
     record->cmdInfo->dirtied.insert(GetResID(destImage));
     if(GetRecord(srcImage)->resInfo)
       record->cmdInfo->sparse.insert(GetRecord(srcImage)->resInfo);
@@ -2098,6 +2113,8 @@ void WrappedVulkan::vkCmdClearColorImage(VkCommandBuffer commandBuffer, VkImage
     record->AddChunk(scope.Get());
     record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_PartialWrite);
     record->MarkResourceFrameReferenced(GetRecord(image)->baseResource, eFrameRef_Read);
+    for(uint32_t i = 0; i < rangeCount; i++)
+      record->MarkImageSubresourcesReferenced(GetResID(image), pRanges[i]);
     if(GetRecord(image)->resInfo)
       record->cmdInfo->sparse.insert(GetRecord(image)->resInfo);
   }
@@ -2205,6 +2222,8 @@ void WrappedVulkan::vkCmdClearDepthStencilImage(VkCommandBuffer commandBuffer, V
     record->AddChunk(scope.Get());
     record->MarkResourceFrameReferenced(GetResID(image), eFrameRef_PartialWrite);
     record->MarkResourceFrameReferenced(GetRecord(image)->baseResource, eFrameRef_Read);
+    for(uint32_t i = 0; i < rangeCount; i++)
+      record->MarkImageSubresourcesReferenced(GetResID(image), pRanges[i]);
     if(GetRecord(image)->resInfo)
       record->cmdInfo->sparse.insert(GetRecord(image)->resInfo);
   }
@@ -235,6 +235,26 @@ bool WrappedVulkan::Serialise_vkQueueSubmit(SerialiserType &ser, VkQueue queue,
 
         ObjDisp(queue)->QueueSubmit(Unwrap(queue), 1, &unwrapped, VK_NULL_HANDLE);
 
+        // remember everything this submit can write or transition, for replay checkpoints
+        {
+          std::set<ResourceId> written;
+
+          for(uint32_t c = 0; c < submitInfo.commandBufferCount; c++)
+          {
+            ResourceId cmd =
+                GetResourceManager()->GetOriginalID(GetResID(submitInfo.pCommandBuffers[c]));
+
+            const BakedCmdBufferInfo &cmdBufInfo = m_BakedCmdBufferInfo[cmd];
+
+            written.insert(cmdBufInfo.writtenResources.begin(), cmdBufInfo.writtenResources.end());
+            for(size_t b = 0; b < cmdBufInfo.imgbarriers.size(); b++)
+              written.insert(cmdBufInfo.imgbarriers[b].first);
+          }
+
+          m_SubmitWrites.push_back(
+              make_rdcpair(m_RootEventID, std::vector<ResourceId>(written.begin(), written.end())));
+        }
+
         AddEvent();
 
         // we're adding multiple events, need to increment ourselves
@@ -343,6 +363,12 @@ bool WrappedVulkan::Serialise_vkQueueSubmit(SerialiserType &ser, VkQueue queue,
         {
 #if ENABLED(VERBOSE_PARTIAL_REPLAY)
           RDCDEBUG("Queue Submit no replay %u == %u", m_LastEventID, startEID);
+#endif
+        }
+        else if(m_RootEventID < m_ResumeEventID)
+        {
+#if ENABLED(VERBOSE_PARTIAL_REPLAY)
+          RDCDEBUG("Queue Submit skipped, before checkpoint at %u", m_ResumeEventID);
 #endif
         }
         else
@@ -705,6 +731,52 @@ void WrappedVulkan::InsertDrawsAndRefreshIDs(BakedCmdBufferInfo &cmdBufInfo)
   }
 }
 
+// composes every frame ref a submit of this command buffer makes, in the order they would be
+// applied one at a time, and caches them on its baked recording info. Must be called with the
+// info's composedRefsLock held.
+static void ComposeSubmitFrameRefs(VulkanResourceManager *rm, VkResourceRecord *record)
+{
+  CmdBufferRecordingInfo *cmdInfo = record->bakedCommands->cmdInfo;
+
+  ComposedFrameRefs refs;
+  std::set<ResourceInfo *> sparse = cmdInfo->sparse;
+
+  // each bound descriptor set is referenced, as well as all resources currently bound to it
+  for(auto it = cmdInfo->boundDescSets.begin(); it != cmdInfo->boundDescSets.end(); ++it)
+  {
+    refs[GetResID(*it)].Then(eFrameRef_Read);
+
+    VkResourceRecord *setrecord = GetRecord(*it);
+
+    SCOPED_LOCK(setrecord->descInfo->refLock);
+
+    for(auto refit = setrecord->descInfo->bindFrameRefs.begin();
+        refit != setrecord->descInfo->bindFrameRefs.end(); ++refit)
+    {
+      refs[refit->first].Then(refit->second.second);
+
+      if(refit->second.first & DescriptorSetData::SPARSE_REF_BIT)
+        sparse.insert(rm->GetResourceRecord(refit->first)->resInfo);
+    }
+  }
+
+  record->bakedCommands->AddResourceReferences(refs);
+
+  // ref the parent command buffer's alloc record, this will pull in the cmd buffer pool
+  refs[record->cmdInfo->allocRecord->GetResourceID()].Then(eFrameRef_Read);
+
+  for(size_t sub = 0; sub < cmdInfo->subcmds.size(); sub++)
+  {
+    VkResourceRecord *subrecord = cmdInfo->subcmds[sub];
+
+    subrecord->bakedCommands->AddResourceReferences(refs);
+    refs[subrecord->cmdInfo->allocRecord->GetResourceID()].Then(eFrameRef_Read);
+  }
+
+  cmdInfo->composedRefs.assign(refs.begin(), refs.end());
+  cmdInfo->composedSparse.assign(sparse.begin(), sparse.end());
+}
+
 VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
                                       const VkSubmitInfo *pSubmits, VkFence fence)
 {
@@ -787,7 +859,17 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
     capframe = IsActiveCapturing(m_State);
   }
 
-  std::set<ResourceId> refdIDs;
+  // coherent maps that are referenced by this submit, and so need to be checked for changes
+  std::vector<VkResourceRecord *> maps;
+  std::set<VkResourceRecord *> refdMaps;
+
+  if(capframe)
+  {
+    SCOPED_LOCK(m_CoherentMapsLock);
+    maps = m_CoherentMaps;
+  }
+
+  std::vector<int64_t> descSetGens;
 
   VkResourceRecord *queueRecord = GetRecord(queue);
 
@@ -814,6 +896,8 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
           GetResourceManager()->MarkDirtyResource(*it);
       }
 
+      descSetGens.clear();
+
       // with EXT_descriptor_indexing a binding might have been updated after
       // vkCmdBindDescriptorSets, so we need to track dirtied here at the last second.
       for(auto it = record->bakedCommands->cmdInfo->boundDescSets.begin();
@@ -823,77 +907,98 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
 
         SCOPED_LOCK(setrecord->descInfo->refLock);
 
-        const std::map<ResourceId, rdcpair<uint32_t, FrameRefType>> &frameRefs =
-            setrecord->descInfo->bindFrameRefs;
+        if(capframe)
+          descSetGens.push_back(setrecord->descInfo->GetBindRefGeneration());
 
-        for(auto refit = frameRefs.begin(); refit != frameRefs.end(); ++refit)
+        // only the refs that became writes since this set was last submitted need to be checked,
+        // anything before that is already dirty.
+        std::vector<ResourceId> &pendingDirty = setrecord->descInfo->pendingDirtyRefs;
+
+        for(ResourceId id : pendingDirty)
         {
-          if(refit->second.second == eFrameRef_PartialWrite ||
-             refit->second.second == eFrameRef_ReadBeforeWrite)
+          const rdcpair<uint32_t, FrameRefType> *ref = setrecord->descInfo->FindBindFrameRef(id);
+
+          // skip anything that was unbound again before being submitted
+          if(ref && DescriptorSetData::IsDirtyingRef(ref->second))
           {
-            if(GetResourceManager()->HasCurrentResource(refit->first))
-              GetResourceManager()->MarkDirtyResource(refit->first);
+            if(GetResourceManager()->HasCurrentResource(id))
+              GetResourceManager()->MarkDirtyResource(id);
           }
         }
+
+        pendingDirty.clear();
       }
 
       if(capframe)
       {
-        // for each bound descriptor set, mark it referenced as well as all resources currently
-        // bound to it
-        for(auto it = record->bakedCommands->cmdInfo->boundDescSets.begin();
-            it != record->bakedCommands->cmdInfo->boundDescSets.end(); ++it)
-        {
-          GetResourceManager()->MarkResourceFrameReferenced(GetResID(*it), eFrameRef_Read);
+        CmdBufferRecordingInfo *cmdInfo = record->bakedCommands->cmdInfo;
+
+        SCOPED_LOCK(cmdInfo->composedRefsLock);
 
-          VkResourceRecord *setrecord = GetRecord(*it);
+        // the refs only need composing again if a bound descriptor set has changed since
+        bool recomposed = false;
+        if(!cmdInfo->refsComposed || cmdInfo->composedDescSetGens != descSetGens)
+        {
+          ComposeSubmitFrameRefs(GetResourceManager(), record);
+          cmdInfo->composedDescSetGens.swap(descSetGens);
+          cmdInfo->refsComposed = true;
+          recomposed = true;
+        }
 
-          SCOPED_LOCK(setrecord->descInfo->refLock);
+        // sparse mappings can change at any time so aren't cached. Their memory is only read, and
+        // marking a read before the composed refs rather than between them can only make the
+        // result more conservative.
+        for(ResourceInfo *sparse : cmdInfo->composedSparse)
+          GetResourceManager()->MarkSparseMapReferenced(sparse);
+
+        // if nothing has changed the frame refs since just before these were last merged, that
+        // merge changed nothing and merging again won't either. This makes re-submitting the same
+        // command buffers cheap.
+        uint64_t frameRefGen = GetResourceManager()->GetFrameRefGeneration();
+        if(recomposed || !cmdInfo->refsMerged || cmdInfo->mergedFrameRefGen != frameRefGen)
+        {
+          GetResourceManager()->MarkResourceFrameReferenced(cmdInfo->composedRefs);
 
-          for(auto refit = setrecord->descInfo->bindFrameRefs.begin();
-              refit != setrecord->descInfo->bindFrameRefs.end(); ++refit)
+          for(auto it = cmdInfo->boundDescSets.begin(); it != cmdInfo->boundDescSets.end(); ++it)
           {
-            refdIDs.insert(refit->first);
-            GetResourceManager()->MarkResourceFrameReferenced(refit->first, refit->second.second);
+            VkResourceRecord *setrecord = GetRecord(*it);
 
-            if(refit->second.first & DescriptorSetData::SPARSE_REF_BIT)
-            {
-              VkResourceRecord *sparserecord = GetResourceManager()->GetResourceRecord(refit->first);
+            SCOPED_LOCK(setrecord->descInfo->refLock);
 
-              GetResourceManager()->MarkSparseMapReferenced(sparserecord->resInfo);
-            }
+            GetResourceManager()->MergeReferencedMemory(setrecord->descInfo->bindMemRefs);
           }
-          GetResourceManager()->MergeReferencedMemory(setrecord->descInfo->bindMemRefs);
-        }
 
-        for(auto it = record->bakedCommands->cmdInfo->sparse.begin();
-            it != record->bakedCommands->cmdInfo->sparse.end(); ++it)
-          GetResourceManager()->MarkSparseMapReferenced(*it);
+          GetResourceManager()->MergeReferencedMemory(cmdInfo->memFrameRefs);
+          GetResourceManager()->MergeReferencedImageSubresources(cmdInfo->imgFrameRefs);
 
-        // pull in frame refs from this baked command buffer
-        record->bakedCommands->AddResourceReferences(GetResourceManager());
-        record->bakedCommands->AddReferencedIDs(refdIDs);
-
-        GetResourceManager()->MergeReferencedMemory(record->bakedCommands->cmdInfo->memFrameRefs);
+          for(size_t sub = 0; sub < cmdInfo->subcmds.size(); sub++)
+          {
+            CmdBufferRecordingInfo *subInfo = cmdInfo->subcmds[sub]->bakedCommands->cmdInfo;
+            GetResourceManager()->MergeReferencedMemory(subInfo->memFrameRefs);
+            GetResourceManager()->MergeReferencedImageSubresources(subInfo->imgFrameRefs);
+          }
 
-        // ref the parent command buffer's alloc record, this will pull in the cmd buffer pool
-        GetResourceManager()->MarkResourceFrameReferenced(
-            record->cmdInfo->allocRecord->GetResourceID(), eFrameRef_Read);
+          cmdInfo->refsMerged = true;
+          cmdInfo->mergedFrameRefGen = frameRefGen;
+        }
 
-        for(size_t sub = 0; sub < record->bakedCommands->cmdInfo->subcmds.size(); sub++)
+        // the composed refs are sorted by ID, so finding the coherent maps this command buffer
+        // references is a binary search per map.
+        for(VkResourceRecord *map : maps)
         {
-          record->bakedCommands->cmdInfo->subcmds[sub]->bakedCommands->AddResourceReferences(
-              GetResourceManager());
-          record->bakedCommands->cmdInfo->subcmds[sub]->bakedCommands->AddReferencedIDs(refdIDs);
-          GetResourceManager()->MergeReferencedMemory(
-              record->bakedCommands->cmdInfo->subcmds[sub]->bakedCommands->cmdInfo->memFrameRefs);
-          GetResourceManager()->MarkResourceFrameReferenced(
-              record->bakedCommands->cmdInfo->subcmds[sub]->cmdInfo->allocRecord->GetResourceID(),
-              eFrameRef_Read);
-
-          record->bakedCommands->cmdInfo->subcmds[sub]->bakedCommands->AddRef();
+          ResourceId id = map->GetResourceID();
+          auto it = std::lower_bound(
+              cmdInfo->composedRefs.begin(), cmdInfo->composedRefs.end(), id,
+              [](const std::pair<ResourceId, FrameRefTransition> &ref, ResourceId mapId) {
+                return ref.first < mapId;
+              });
+          if(it != cmdInfo->composedRefs.end() && it->first == id)
+            refdMaps.insert(map);
         }
 
+        for(size_t sub = 0; sub < cmdInfo->subcmds.size(); sub++)
+          cmdInfo->subcmds[sub]->bakedCommands->AddRef();
+
         {
           SCOPED_LOCK(m_CmdBufferRecordsLock);
           m_CmdBufferRecords.push_back(record->bakedCommands);
@@ -915,12 +1020,6 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
     if(fence != VK_NULL_HANDLE)
       GetResourceManager()->MarkResourceFrameReferenced(GetResID(fence), eFrameRef_Read);
 
-    std::vector<VkResourceRecord *> maps;
-    {
-      SCOPED_LOCK(m_CoherentMapsLock);
-      maps = m_CoherentMaps;
-    }
-
     for(auto it = maps.begin(); it != maps.end(); ++it)
     {
       VkResourceRecord *record = *it;
@@ -930,7 +1029,7 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
       if(state.mapCoherent && state.mappedPtr && !state.mapFlushed)
       {
         // only need to flush memory that could affect this submitted batch of work
-        if(refdIDs.find(record->GetResourceID()) == refdIDs.end())
+        if(refdMaps.find(record) == refdMaps.end())
         {
           RDCDEBUG("Map of memory %llu not referenced in this queue - not flushing",
                    record->GetResourceID());
@@ -1022,7 +1121,7 @@ VkResult WrappedVulkan::vkQueueSubmit(VkQueue queue, uint32_t submitCount,
   if(present)
   {
     AdvanceFrame();
-    Present(LayerDisp(m_Instance), NULL);
+    Present(queue, LayerDisp(m_Instance), NULL);
   }
 
   return ret;
@@ -1028,8 +1028,8 @@ bool WrappedVulkan::Serialise_vkCreateBuffer(SerialiserType &ser, VkDevice devic
 
     VkBufferUsageFlags origusage = CreateInfo.usage;
 
-    // ensure we can always readback from buffers
-    CreateInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    // ensure we can always readback from buffers, and copy replay checkpoints back into them
+    CreateInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 
     // remap the queue family indices
     if(CreateInfo.sharingMode == VK_SHARING_MODE_EXCLUSIVE)
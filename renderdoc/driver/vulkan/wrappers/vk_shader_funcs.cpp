@@ -422,11 +422,34 @@ bool WrappedVulkan::Serialise_vkCreateGraphicsPipelines(
     pipelineCache = VK_NULL_HANDLE;
 
     VkGraphicsPipelineCreateInfo *unwrapped = UnwrapInfos(&CreateInfo, 1);
+
+    // the variant of the pipeline for subpass 0 of the load renderpass doesn't depend on the real
+    // pipeline, so compile it on another thread at the same time. It shares the unwrapped stages,
+    // so no temp memory can be used until both are finished.
+    VkGraphicsPipelineCreateInfo subpass0Info = *unwrapped;
+    subpass0Info.renderPass = Unwrap(
+        m_CreationInfo.m_RenderPass[GetResID(CreateInfo.renderPass)].loadRPs[CreateInfo.subpass]);
+    subpass0Info.subpass = 0;
+
+    VkPipeline subpass0pipe = VK_NULL_HANDLE;
+    VkResult subpass0ret = VK_SUCCESS;
+
+    Threading::ThreadHandle subpass0Thread = Threading::CreateThread([&]() {
+      subpass0ret = ObjDisp(device)->CreateGraphicsPipelines(
+          Unwrap(device), Unwrap(pipelineCache), 1, &subpass0Info, NULL, &subpass0pipe);
+    });
+
     VkResult ret = ObjDisp(device)->CreateGraphicsPipelines(Unwrap(device), Unwrap(pipelineCache),
                                                             1, unwrapped, NULL, &pipe);
 
+    Threading::JoinThread(subpass0Thread);
+    Threading::CloseThread(subpass0Thread);
+
     if(ret != VK_SUCCESS)
     {
+      if(subpass0pipe != VK_NULL_HANDLE)
+        ObjDisp(device)->DestroyPipeline(Unwrap(device), subpass0pipe, NULL);
+
       RDCERR("Failed on resource serialise-creation, VkResult: %s", ToStr(ret).c_str());
       return false;
     }
@@ -442,6 +465,10 @@ bool WrappedVulkan::Serialise_vkCreateGraphicsPipelines(
         // calls and there won't be a wrapped resource hanging around to destroy this one.
         ObjDisp(device)->DestroyPipeline(Unwrap(device), pipe, NULL);
 
+        // the duplicate already has its own subpass 0 pipeline
+        if(subpass0pipe != VK_NULL_HANDLE)
+          ObjDisp(device)->DestroyPipeline(Unwrap(device), subpass0pipe, NULL);
+
         // whenever the new ID is requested, return the old ID, via replacements.
         GetResourceManager()->ReplaceResource(Pipeline, GetResourceManager()->GetOriginalID(live));
       }
@@ -454,15 +481,9 @@ bool WrappedVulkan::Serialise_vkCreateGraphicsPipelines(
 
         pipeInfo.Init(GetResourceManager(), m_CreationInfo, &CreateInfo);
 
-        ResourceId renderPassID = GetResID(CreateInfo.renderPass);
-
-        CreateInfo.renderPass = m_CreationInfo.m_RenderPass[renderPassID].loadRPs[CreateInfo.subpass];
-        CreateInfo.subpass = 0;
+        RDCASSERTEQUAL(subpass0ret, VK_SUCCESS);
 
-        unwrapped = UnwrapInfos(&CreateInfo, 1);
-        ret = ObjDisp(device)->CreateGraphicsPipelines(Unwrap(device), Unwrap(pipelineCache), 1,
-                                                       unwrapped, NULL, &pipeInfo.subpass0pipe);
-        RDCASSERTEQUAL(ret, VK_SUCCESS);
+        pipeInfo.subpass0pipe = subpass0pipe;
 
         ResourceId subpass0id =
             GetResourceManager()->WrapResource(Unwrap(device), pipeInfo.subpass0pipe);
@@ -821,7 +821,7 @@ VkResult WrappedVulkan::vkQueuePresentKHR(VkQueue queue, const VkPresentInfoKHR
 
   VkResult vkr = ObjDisp(queue)->QueuePresentKHR(Unwrap(queue), &unwrappedInfo);
 
-  Present(LayerDisp(m_Instance), swapInfo.wndHandle);
+  Present(queue, LayerDisp(m_Instance), swapInfo.wndHandle);
 
   return vkr;
 }
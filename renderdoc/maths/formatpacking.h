@@ -26,6 +26,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
 #include "vec.h"
 
 inline Vec4f ConvertFromR10G10B10A2(uint32_t data)
@@ -114,15 +115,17 @@ inline Vec3f ConvertFromR11G11B10(uint32_t data)
 
         exponents[i] = 1;
 
-        // shift until hidden bit is set
-        while((mantissas[i] & 0x40) == 0)
+        // shift until hidden bit is set, just above the 6 or 5 bits of mantissa
+        const uint32_t hiddenBit = 1U << (23 - mantissaShift[i]);
+
+        while((mantissas[i] & hiddenBit) == 0)
         {
           mantissas[i] <<= 1;
           exponents[i]--;
         }
 
         // remove the hidden bit
-        mantissas[i] &= ~0x40;
+        mantissas[i] &= ~hiddenBit;
 
         retu[i] = (exponents[i] + (127 - 15)) << 23 | mantissas[i] << mantissaShift[i];
       }
@@ -132,6 +135,40 @@ inline Vec3f ConvertFromR11G11B10(uint32_t data)
   return ret;
 }
 
+// array version of the above for bulk data, giving identical results without branching so it can
+// be vectorised. Alpha is set to 1 in the output.
+inline void ConvertFromR11G11B10(const uint32_t *src, Vec4f *dst, size_t count)
+{
+  const uint32_t mantissaBits[3] = {6, 6, 5};
+  const uint32_t firstBit[3] = {0, 11, 22};
+
+  // denormals are 0.mantissa * 2^-14, so the mantissa scaled by 2^-20 or 2^-19, which is exact
+  const float denormScale[3] = {1.0f / 1048576.0f, 1.0f / 1048576.0f, 1.0f / 524288.0f};
+
+  for(size_t n = 0; n < count; n++)
+  {
+    float ret[3];
+
+    for(int i = 0; i < 3; i++)
+    {
+      uint32_t mantissa = (src[n] >> firstBit[i]) & ((1U << mantissaBits[i]) - 1);
+      uint32_t exponent = (src[n] >> (firstBit[i] + mantissaBits[i])) & 0x1f;
+
+      float denormF = float(mantissa) * denormScale[i];
+      uint32_t denorm;
+      memcpy(&denorm, &denormF, sizeof(denorm));
+
+      uint32_t infNan = 0x7f800000 | mantissa << (23 - mantissaBits[i]);
+      uint32_t normal = (exponent + (127 - 15)) << 23 | mantissa << (23 - mantissaBits[i]);
+
+      uint32_t bits = exponent == 0 ? denorm : (exponent == 0x1f ? infNan : normal);
+      memcpy(&ret[i], &bits, sizeof(bits));
+    }
+
+    dst[n] = Vec4f(ret[0], ret[1], ret[2], 1.0f);
+  }
+}
+
 /*
 inline uint32_t ConvertToR11G11B10(Vec3f data)
 {
@@ -186,4 +223,9 @@ inline Vec4f ConvertSRGBToLinear(Vec4f srgbF)
 struct ResourceFormat;
 float ConvertComponent(const ResourceFormat &fmt, const byte *data);
 
+// converts a row of texels in a regular, packed or depth/stencil format to float4s. Missing
+// channels are 0 with alpha as 1, and depth/stencil formats give depth in x and stencil / 255 in y
+void ConvertRowToFloat4(const ResourceFormat &fmt, const byte *data, uint32_t numTexels,
+                        Vec4f *out);
+
 #include "half_convert.h"
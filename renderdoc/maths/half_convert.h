@@ -34,6 +34,8 @@
 
 #pragma once
 
+#include <string.h>
+
 inline uint16_t ConvertToHalf(float comp)
 {
   int *alias = (int *)&comp;
@@ -130,3 +132,61 @@ inline float ConvertFromHalf(uint16_t comp)
     return nan.f;
   }
 }
+
+// array versions of the above, for converting bulk data such as texture rows. These give identical
+// results to the single value versions including for denormals, infinities and NaNs, but compute
+// every case and select between them instead of branching, so that the loops can be vectorised.
+inline void ConvertToHalf(const float *src, uint16_t *dst, size_t count)
+{
+  for(size_t n = 0; n < count; n++)
+  {
+    uint32_t i;
+    memcpy(&i, &src[n], sizeof(i));
+
+    uint32_t sign = (i >> 16) & 0x00008000;
+    int32_t exponent = int32_t((i >> 23) & 0x000000ff) - (127 - 15);
+    uint32_t mantissa = i & 0x007fffff;
+
+    // denormals, rounded to nearest even. The shift is clamped to stay valid for other values
+    int32_t t = 14 - exponent;
+    t = t < 14 ? 14 : (t > 24 ? 24 : t);
+    uint32_t denormMantissa = mantissa | 0x00800000;
+    denormMantissa = (denormMantissa + (1U << (t - 1)) - 1 + ((denormMantissa >> t) & 1)) >> t;
+    uint32_t denorm = exponent < -10 ? sign : (sign | denormMantissa);
+
+    // infinity, or NaN keeping as much of the payload as possible but never becoming infinity
+    uint32_t nanMantissa = mantissa >> 13;
+    uint32_t infNan = sign | 0x7c00 | nanMantissa | uint32_t(mantissa != 0 && nanMantissa == 0);
+
+    // normal values, rounded to nearest even. A mantissa overflow carries into the exponent
+    uint32_t roundedMantissa = (mantissa + 0x00000fff + ((mantissa >> 13) & 1)) >> 13;
+    uint32_t normal = (uint32_t(exponent) << 10) + roundedMantissa;
+    normal = sign | (exponent > 30 ? 0x7c00 : normal);
+
+    uint32_t ret = exponent <= 0 ? denorm : (exponent == 0xff - (127 - 15) ? infNan : normal);
+
+    dst[n] = uint16_t(ret & 0xffff);
+  }
+}
+
+inline void ConvertFromHalf(const uint16_t *src, float *dst, size_t count)
+{
+  for(size_t n = 0; n < count; n++)
+  {
+    uint32_t sign = uint32_t(src[n] & 0x8000) << 16;
+    uint32_t exponent = (src[n] & 0x7C00) >> 10;
+    uint32_t mantissa = src[n] & 0x03FF;
+
+    // subnormals scale the mantissa by 2^-24, which is exact. Zero is always positive
+    float subnormalF = float(mantissa) * (1.0f / 16777216.0f);
+    uint32_t subnormal;
+    memcpy(&subnormal, &subnormalF, sizeof(subnormal));
+    subnormal |= mantissa ? sign : 0;
+
+    uint32_t normal = sign | (exponent + 127 - 15) << 23 | (mantissa << 13);
+
+    uint32_t ret = exponent == 0 ? subnormal : (exponent == 0x1f ? 0x7F800001 : normal);
+
+    memcpy(&dst[n], &ret, sizeof(ret));
+  }
+}
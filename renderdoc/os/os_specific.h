@@ -130,6 +130,26 @@ public:
   data m_Data;
 };
 
+// lets one thread sleep until another has work for it. Wakes aren't counted - any number of wakes
+// before the next wait release that wait once. The layout is platform-specific, so it's only ever
+// handled by pointer.
+class Semaphore
+{
+public:
+  static Semaphore *Create();
+  void Destroy();
+
+  void Wake();
+  // returns after a wake or after timeoutMS, whichever comes first
+  void WaitForWake(uint32_t timeoutMS);
+
+  // no construction, copying or deletion outside of Create/Destroy
+  Semaphore() = delete;
+  ~Semaphore() = delete;
+  Semaphore &operator=(const Semaphore &other) = delete;
+  Semaphore(const Semaphore &other) = delete;
+};
+
 void Init();
 void Shutdown();
 uint64_t AllocateTLSSlot();
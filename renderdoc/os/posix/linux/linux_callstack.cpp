@@ -22,16 +22,187 @@
  * THE SOFTWARE.
  ******************************************************************************/
 
+#include <cxxabi.h>
+#include <elf.h>
 #include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <map>
+#include <memory>
 #include <vector>
+#include "3rdparty/miniz/miniz.h"
+#include "common/threading.h"
 #include "os/os_specific.h"
 
 void *renderdocBase = NULL;
 void *renderdocEnd = NULL;
 
+// cached list of readable+executable address ranges in the process, used to validate return
+// addresses when walking frame pointers. The snapshot is only replaced or freed while
+// execRangesUseLock is held for writing, which every walk holds for reading, so a walk never sees
+// memory that was unmapped after its snapshot was taken.
+struct ExecutableRange
+{
+  uint64_t base, end;
+  // file-backed mappings are only unmapped through dlclose, which is serialised against walks.
+  // Anonymous executable memory (JIT code) can be unmapped at any time.
+  bool fileBacked;
+
+  bool operator<(const ExecutableRange &o) const { return base < o.base; }
+};
+
+struct ExecutableRanges
+{
+  std::vector<ExecutableRange> ranges;
+
+  const ExecutableRange *Find(uint64_t addr) const
+  {
+    auto it = std::upper_bound(
+        ranges.begin(), ranges.end(), addr,
+        [](uint64_t a, const ExecutableRange &r) { return a < r.base; });
+    if(it == ranges.begin())
+      return NULL;
+    --it;
+    return addr < it->end ? &*it : NULL;
+  }
+};
+
+static ExecutableRanges *volatile execRanges = NULL;
+static Threading::CriticalSection execRangesLock;
+static Threading::RWLock execRangesUseLock;
+
+// dlclose can re-enter itself or dlopen from library destructors on the same thread, so the
+// write lock is only taken by the outermost call.
+static volatile uint64_t execRangesWriter = 0;
+static int32_t execRangesWriteDepth = 0;
+
+static pthread_key_t stackBoundsKey;
+
+void BeginCallstackModuleChange()
+{
+  uint64_t id = Threading::GetCurrentID();
+
+  if(execRangesWriter != id)
+  {
+    execRangesUseLock.WriteLock();
+    execRangesWriter = id;
+  }
+
+  execRangesWriteDepth++;
+
+  // no walk is running, so the old snapshot can be freed outright
+  delete execRanges;
+  execRanges = NULL;
+}
+
+void EndCallstackModuleChange()
+{
+  // drop anything a walk on this thread built in between (e.g. from a library destructor) since
+  // the module list may have changed under it
+  delete execRanges;
+  execRanges = NULL;
+
+  if(--execRangesWriteDepth == 0)
+  {
+    execRangesWriter = 0;
+    execRangesUseLock.WriteUnlock();
+  }
+}
+
+void InvalidateCallstackModuleCache()
+{
+  BeginCallstackModuleChange();
+  EndCallstackModuleChange();
+}
+
+// must be called with execRangesUseLock held for reading (or writing, on the writer thread)
+static const ExecutableRanges *GetExecutableRanges()
+{
+  ExecutableRanges *ret = execRanges;
+
+  if(ret)
+    return ret;
+
+  SCOPED_LOCK(execRangesLock);
+
+  // another thread may have built it while we waited for the lock
+  if(execRanges)
+    return execRanges;
+
+  ExecutableRanges *ranges = new ExecutableRanges;
+
+  FILE *f = FileIO::fopen("/proc/self/maps", "r");
+
+  if(f)
+  {
+    char line[512] = {0};
+    while(fgets(line, 511, f))
+    {
+      unsigned long base = 0, end = 0, offset = 0, inode = 0;
+      unsigned int devmajor = 0, devminor = 0;
+      char perms[8] = {0};
+      // we read the bytes before return addresses, so execute-only mappings are no use to us
+      if(sscanf(line, "%lx-%lx %7s %lx %x:%x %lu", &base, &end, perms, &offset, &devmajor,
+                &devminor, &inode) == 7 &&
+         perms[0] == 'r' && perms[2] == 'x')
+        ranges->ranges.push_back({(uint64_t)base, (uint64_t)end, inode != 0});
+    }
+
+    FileIO::fclose(f);
+  }
+
+  std::sort(ranges->ranges.begin(), ranges->ranges.end());
+
+  execRanges = ranges;
+
+  return ranges;
+}
+
+struct StackBounds
+{
+  uint64_t lo = 0, hi = 0;
+};
+
+static void FreeStackBounds(void *bounds)
+{
+  delete(StackBounds *)bounds;
+}
+
+static const StackBounds *GetThreadStackBounds()
+{
+  StackBounds *bounds = (StackBounds *)pthread_getspecific(stackBoundsKey);
+
+  if(bounds)
+    return bounds;
+
+  bounds = new StackBounds;
+
+  pthread_attr_t attr;
+  if(pthread_getattr_np(pthread_self(), &attr) == 0)
+  {
+    void *addr = NULL;
+    size_t size = 0;
+    if(pthread_attr_getstack(&attr, &addr, &size) == 0)
+    {
+      bounds->lo = (uint64_t)addr;
+      bounds->hi = (uint64_t)addr + size;
+    }
+    pthread_attr_destroy(&attr);
+  }
+
+  // freed by FreeStackBounds when the thread exits
+  pthread_setspecific(stackBoundsKey, bounds);
+
+  return bounds;
+}
+
 class LinuxCallstack : public Callstack::Stackwalk
 {
 public:
@@ -55,11 +226,133 @@ public:
 private:
   LinuxCallstack(const Callstack::Stackwalk &other);
 
+#if defined(__x86_64__)
+  // fetch the 7 bytes before a return address. Code in file-backed mappings can only go away
+  // through dlclose, which can't run while we hold execRangesUseLock, so it's read directly.
+  // Anonymous executable memory could be unmapped at any moment so it's read through the kernel,
+  // which fails cleanly instead of faulting.
+  static bool ReadCallSite(const ExecutableRanges *ranges, uint64_t ret, byte *bytes)
+  {
+    const ExecutableRange *hi = ranges->Find(ret - 1);
+    const ExecutableRange *lo = ranges->Find(ret - 7);
+
+    if(!hi || !lo)
+      return false;
+
+    if(hi->fileBacked && lo->fileBacked)
+    {
+      memcpy(bytes, (const byte *)(ret - 7), 7);
+      return true;
+    }
+
+    iovec local = {bytes, 7};
+    iovec remote = {(void *)(ret - 7), 7};
+    return process_vm_readv(getpid(), &local, 1, &remote, 1, 0) == 7;
+  }
+
+  // check that the instruction before a return address is a call. This catches most garbage values
+  // found when a frame in the chain doesn't maintain a frame pointer. bytes holds the 7 bytes
+  // immediately before the return address.
+  static bool IsAfterCall(const byte *bytes)
+  {
+    const byte *p = bytes + 7;
+
+    // call rel32
+    if(p[-5] == 0xE8)
+      return true;
+
+    // indirect call, FF /2 with the various ModRM encodings: register (2 bytes), [reg] (2),
+    // [reg+disp8] (3), SIB+disp8 (4), [reg+disp32] / [rip+disp32] (6), SIB+disp32 (7). REX
+    // prefixes don't change the distance from the ModRM byte to the return address.
+    for(int len : {2, 3, 4, 6, 7})
+    {
+      if(p[-len] == 0xFF && ((p[-len + 1] >> 3) & 7) == 2)
+        return true;
+    }
+
+    return false;
+  }
+
+  // Walk the chain of saved frame pointers. Every frame pointer must stay within this thread's
+  // stack and strictly increase, and every return address must land just after a call instruction
+  // in executable memory. Returns false if the chain broke before reaching the outermost frame,
+  // since then some frame didn't maintain a frame pointer and the result would be incomplete.
+  bool CollectFramePointers(void **addrs_ptr, int maxLevels, int &levels)
+  {
+    const StackBounds *bounds = GetThreadStackBounds();
+
+    if(bounds->lo == 0)
+      return false;
+
+    // if a module is being unloaded on another thread, don't wait for it - the unwinder can
+    // handle this one. On the unloading thread itself (e.g. from a library destructor) the write
+    // lock is already held so the snapshot is safe to use.
+    bool writer = (execRangesWriter == Threading::GetCurrentID());
+
+    if(!writer && !execRangesUseLock.TryReadlock())
+      return false;
+
+    bool ret = WalkFramePointers(bounds, GetExecutableRanges(), addrs_ptr, maxLevels, levels);
+
+    if(!writer)
+      execRangesUseLock.ReadUnlock();
+
+    return ret;
+  }
+
+  static bool WalkFramePointers(const StackBounds *bounds, const ExecutableRanges *ranges,
+                                void **addrs_ptr, int maxLevels, int &levels)
+  {
+    if(ranges->ranges.empty())
+      return false;
+
+    uint64_t fp = (uint64_t)__builtin_frame_address(0);
+
+    levels = 0;
+
+    while(levels < maxLevels)
+    {
+      // the outermost frame has a NULL frame pointer (set up by _start and clone)
+      if(fp == 0)
+        return true;
+
+      if(fp < bounds->lo || fp + 16 > bounds->hi || (fp & 7) != 0)
+        return false;
+
+      uint64_t next = ((uint64_t *)fp)[0];
+      uint64_t ret = ((uint64_t *)fp)[1];
+
+      if(ret == 0)
+        return true;
+
+      byte callSite[7];
+      if(!ranges->Find(ret) || !ReadCallSite(ranges, ret, callSite) || !IsAfterCall(callSite))
+        return false;
+
+      addrs_ptr[levels++] = (void *)ret;
+
+      if(next != 0 && next <= fp)
+        return false;
+
+      fp = next;
+    }
+
+    // ran out of space, the stack is truncated but valid
+    return true;
+  }
+#endif
+
   void Collect()
   {
     void *addrs_ptr[ARRAY_COUNT(addrs)];
 
-    numLevels = backtrace(addrs_ptr, ARRAY_COUNT(addrs));
+    numLevels = 0;
+
+#if defined(__x86_64__)
+    // try the fast frame pointer walk first, and only use the unwinder if it fails
+    if(!CollectFramePointers(addrs_ptr, ARRAY_COUNT(addrs), numLevels))
+#endif
+      numLevels = backtrace(addrs_ptr, ARRAY_COUNT(addrs));
 
     int offs = 0;
     // if we want to trim levels of the stack, we can do that here
@@ -82,6 +375,8 @@ namespace Callstack
 {
 void Init()
 {
+  pthread_key_create(&stackBoundsKey, &FreeStackBounds);
+
   // look for our own line
   FILE *f = FileIO::fopen("/proc/self/maps", "r");
 
@@ -148,6 +443,822 @@ struct LookupModule
   char path[2048];
 };
 
+// Symbol information for a single ELF module, parsed once in-process. Function names come from the
+// ELF symbol table and file/line information from the DWARF .debug_line program, each stored as a
+// sorted array of address ranges so that lookups are a binary search.
+class ElfSymbols
+{
+public:
+  ElfSymbols() {}
+  ~ElfSymbols() { UnmapFile(); }
+  bool Load(const char *path)
+  {
+    if(!MapFile(path))
+      return false;
+
+    if(m_Size < EI_NIDENT || memcmp(m_Data, ELFMAG, SELFMAG) != 0)
+    {
+      RDCWARN("%s is not an ELF file", path);
+      UnmapFile();
+      return false;
+    }
+
+    bool ret = false;
+
+    if(m_Data[EI_CLASS] == ELFCLASS64)
+      ret = Parse<Elf64_Ehdr, Elf64_Shdr, Elf64_Phdr, Elf64_Sym, Elf64_Chdr>();
+    else if(m_Data[EI_CLASS] == ELFCLASS32)
+      ret = Parse<Elf32_Ehdr, Elf32_Shdr, Elf32_Phdr, Elf32_Sym, Elf32_Chdr>();
+
+    // if there's no line information in the module itself, look for separate debug info by
+    // build-id in the standard location.
+    if(ret && m_Lines.empty() && !m_BuildID.empty())
+    {
+      std::string debugPath = "/usr/lib/debug/.build-id/" + m_BuildID.substr(0, 2) + "/" +
+                              m_BuildID.substr(2) + ".debug";
+
+      ElfSymbols debug;
+      if(FileIO::exists(debugPath.c_str()) && debug.Load(debugPath.c_str()))
+      {
+        m_Lines.swap(debug.m_Lines);
+        m_Files.swap(debug.m_Files);
+
+        if(m_Symbols.empty())
+        {
+          m_Symbols.swap(debug.m_Symbols);
+          m_Names.swap(debug.m_Names);
+        }
+      }
+    }
+
+    // we don't need the file contents any more
+    UnmapFile();
+
+    return ret;
+  }
+
+  // converts an offset into the file (as found from /proc/self/maps) into a virtual address in the
+  // ELF's address space.
+  uint64_t FileOffsetToAddress(uint64_t offset) const
+  {
+    for(const Segment &seg : m_Segments)
+      if(offset >= seg.offset && offset < seg.offset + seg.size)
+        return offset - seg.offset + seg.vaddr;
+
+    return offset;
+  }
+
+  void Resolve(uint64_t addr, Callstack::AddressDetails &ret) const
+  {
+    auto sym = std::upper_bound(m_Symbols.begin(), m_Symbols.end(), addr,
+                                [](uint64_t a, const Symbol &s) { return a < s.address; });
+
+    if(sym != m_Symbols.begin())
+    {
+      --sym;
+      if(sym->size == 0 || addr < sym->address + sym->size)
+        ret.function = Demangle(m_Names.data() + sym->name);
+    }
+
+    auto line = std::upper_bound(m_Lines.begin(), m_Lines.end(), addr,
+                                 [](uint64_t a, const LineRow &r) { return a < r.address; });
+
+    if(line != m_Lines.begin())
+    {
+      --line;
+
+      // rows that end a sequence don't cover anything after them
+      if(!line->endSequence && line->file < m_Files.size())
+      {
+        ret.filename = m_Files[line->file];
+        ret.line = line->line;
+      }
+    }
+  }
+
+private:
+  struct Segment
+  {
+    uint64_t offset, size, vaddr;
+  };
+
+  struct Symbol
+  {
+    uint64_t address, size;
+    size_t name;
+    bool operator<(const Symbol &o) const { return address < o.address; }
+  };
+
+  struct LineRow
+  {
+    uint64_t address;
+    uint32_t file;
+    uint32_t line : 31;
+    uint32_t endSequence : 1;
+    bool operator<(const LineRow &o) const { return address < o.address; }
+  };
+
+  struct Section
+  {
+    const byte *data = NULL;
+    size_t size = 0;
+    // storage if the section was compressed
+    std::vector<byte> decompressed;
+  };
+
+  const byte *m_Data = NULL;
+  size_t m_Size = 0;
+  std::string m_BuildID;
+
+  std::vector<Segment> m_Segments;
+  std::vector<Symbol> m_Symbols;
+  std::vector<char> m_Names;
+  std::vector<LineRow> m_Lines;
+  std::vector<std::string> m_Files;
+
+  static std::string Demangle(const char *name)
+  {
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(name, NULL, NULL, &status);
+    if(status == 0 && demangled)
+    {
+      std::string ret = demangled;
+      free(demangled);
+      return ret;
+    }
+    free(demangled);
+    return name;
+  }
+
+  // the file is only needed while parsing, so map it read-only rather than reading it all in
+  bool MapFile(const char *path)
+  {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+      return false;
+
+    struct stat st = {};
+    if(fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+      close(fd);
+      return false;
+    }
+
+    void *ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(ptr == MAP_FAILED)
+      return false;
+
+    m_Data = (const byte *)ptr;
+    m_Size = (size_t)st.st_size;
+
+    return true;
+  }
+
+  void UnmapFile()
+  {
+    if(m_Data)
+      munmap((void *)m_Data, m_Size);
+    m_Data = NULL;
+    m_Size = 0;
+  }
+
+  // true if [offset, offset+size) lies entirely within the file
+  bool InFile(uint64_t offset, uint64_t size) const
+  {
+    return offset <= m_Size && size <= m_Size - offset;
+  }
+
+  // returns the string at offset into a string table that's already been checked to lie within
+  // the file, or an empty string if it's out of bounds or not terminated within the table.
+  const char *TableString(uint64_t tableOffset, uint64_t tableSize, uint64_t offset) const
+  {
+    if(offset >= tableSize)
+      return "";
+
+    const char *ret = (const char *)m_Data + tableOffset + offset;
+    if(memchr(ret, 0, (size_t)(tableSize - offset)) == NULL)
+      return "";
+
+    return ret;
+  }
+
+  template <typename Chdr, typename Shdr>
+  bool GetSection(const Shdr &shdr, Section &ret)
+  {
+    if(shdr.sh_type == SHT_NOBITS || !InFile(shdr.sh_offset, shdr.sh_size))
+      return false;
+
+    ret.data = m_Data + shdr.sh_offset;
+    ret.size = (size_t)shdr.sh_size;
+
+    if(shdr.sh_flags & SHF_COMPRESSED)
+    {
+      if(ret.size < sizeof(Chdr))
+        return false;
+
+      const Chdr *chdr = (const Chdr *)ret.data;
+      if(chdr->ch_type != ELFCOMPRESS_ZLIB)
+        return false;
+
+      ret.decompressed.resize((size_t)chdr->ch_size);
+      mz_ulong destLen = (mz_ulong)chdr->ch_size;
+
+      int res = mz_uncompress(ret.decompressed.data(), &destLen, ret.data + sizeof(Chdr),
+                              (mz_ulong)(ret.size - sizeof(Chdr)));
+
+      if(res != MZ_OK)
+        return false;
+
+      ret.data = ret.decompressed.data();
+      ret.size = (size_t)destLen;
+    }
+
+    return true;
+  }
+
+  template <typename Ehdr, typename Shdr, typename Phdr, typename Sym, typename Chdr>
+  bool Parse()
+  {
+    const Ehdr *ehdr = (const Ehdr *)m_Data;
+
+    if(m_Size < sizeof(Ehdr) || !InFile(ehdr->e_shoff, uint64_t(ehdr->e_shnum) * sizeof(Shdr)) ||
+       !InFile(ehdr->e_phoff, uint64_t(ehdr->e_phnum) * sizeof(Phdr)) ||
+       ehdr->e_shstrndx >= ehdr->e_shnum)
+      return false;
+
+    const Phdr *phdrs = (const Phdr *)(m_Data + ehdr->e_phoff);
+    for(uint32_t i = 0; i < ehdr->e_phnum; i++)
+    {
+      if(phdrs[i].p_type == PT_LOAD)
+        m_Segments.push_back({phdrs[i].p_offset, phdrs[i].p_filesz, phdrs[i].p_vaddr});
+    }
+
+    const Shdr *shdrs = (const Shdr *)(m_Data + ehdr->e_shoff);
+    const Shdr &shstr = shdrs[ehdr->e_shstrndx];
+
+    if(shstr.sh_type == SHT_NOBITS || !InFile(shstr.sh_offset, shstr.sh_size))
+      return false;
+
+    const Shdr *symtab = NULL, *dynsym = NULL;
+    Section debugLine, debugLineStr, debugStr, debugInfo, debugAbbrev;
+
+    for(uint32_t i = 0; i < ehdr->e_shnum; i++)
+    {
+      const char *name = TableString(shstr.sh_offset, shstr.sh_size, shdrs[i].sh_name);
+
+      if(shdrs[i].sh_type == SHT_SYMTAB)
+        symtab = &shdrs[i];
+      else if(shdrs[i].sh_type == SHT_DYNSYM)
+        dynsym = &shdrs[i];
+      else if(!strcmp(name, ".debug_line"))
+        GetSection<Chdr>(shdrs[i], debugLine);
+      else if(!strcmp(name, ".debug_line_str"))
+        GetSection<Chdr>(shdrs[i], debugLineStr);
+      else if(!strcmp(name, ".debug_str"))
+        GetSection<Chdr>(shdrs[i], debugStr);
+      else if(!strcmp(name, ".debug_info"))
+        GetSection<Chdr>(shdrs[i], debugInfo);
+      else if(!strcmp(name, ".debug_abbrev"))
+        GetSection<Chdr>(shdrs[i], debugAbbrev);
+      else if(!strcmp(name, ".note.gnu.build-id"))
+        ReadBuildID(shdrs[i].sh_offset, shdrs[i].sh_size);
+    }
+
+    // prefer the full symbol table, but fall back to the dynamic symbols if we've been stripped
+    const Shdr *symsection = symtab ? symtab : dynsym;
+
+    if(symsection && symsection->sh_link < ehdr->e_shnum &&
+       InFile(symsection->sh_offset, symsection->sh_size) &&
+       InFile(shdrs[symsection->sh_link].sh_offset, shdrs[symsection->sh_link].sh_size))
+    {
+      const Shdr &strsection = shdrs[symsection->sh_link];
+
+      const Sym *syms = (const Sym *)(m_Data + symsection->sh_offset);
+      size_t numSyms = (size_t)(symsection->sh_size / sizeof(Sym));
+
+      for(size_t i = 0; i < numSyms; i++)
+      {
+        if(ELF64_ST_TYPE(syms[i].st_info) != STT_FUNC || syms[i].st_value == 0)
+          continue;
+
+        const char *name = TableString(strsection.sh_offset, strsection.sh_size, syms[i].st_name);
+        size_t len = strlen(name);
+
+        if(len == 0)
+          continue;
+
+        m_Symbols.push_back({syms[i].st_value, syms[i].st_size, m_Names.size()});
+        m_Names.insert(m_Names.end(), name, name + len + 1);
+      }
+
+      std::sort(m_Symbols.begin(), m_Symbols.end());
+    }
+
+    if(debugLine.data)
+    {
+      // before DWARF 5 the line table doesn't list the compilation directory, that comes from the
+      // compile unit that references it
+      std::map<uint64_t, std::string> compDirs;
+      if(debugInfo.data && debugAbbrev.data)
+        ReadCompDirs(debugInfo, debugAbbrev, debugLineStr, debugStr, compDirs);
+
+      ParseDebugLine(debugLine, debugLineStr, debugStr, compDirs,
+                     ehdr->e_ident[EI_CLASS] == ELFCLASS64);
+    }
+
+    return true;
+  }
+
+  void ReadBuildID(uint64_t offset, uint64_t size)
+  {
+    if(!InFile(offset, size) || size < sizeof(Elf64_Nhdr))
+      return;
+
+    // Elf32_Nhdr and Elf64_Nhdr are identical
+    const Elf64_Nhdr *note = (const Elf64_Nhdr *)(m_Data + offset);
+    uint64_t descOffset = sizeof(Elf64_Nhdr) + AlignUp4(uint64_t(note->n_namesz));
+
+    if(note->n_type != NT_GNU_BUILD_ID || descOffset > size || note->n_descsz > size - descOffset)
+      return;
+
+    const byte *desc = m_Data + offset + descOffset;
+
+    for(uint32_t i = 0; i < note->n_descsz; i++)
+      m_BuildID += StringFormat::Fmt("%02x", desc[i]);
+  }
+
+  // simple bounds-checked reader over a DWARF section
+  struct DwarfReader
+  {
+    const byte *cur, *end;
+
+    bool AtEnd() const { return cur >= end; }
+    template <typename T>
+    T Read()
+    {
+      T ret = T();
+      if(cur + sizeof(T) <= end)
+        memcpy(&ret, cur, sizeof(T));
+      cur += sizeof(T);
+      return ret;
+    }
+    uint64_t ReadULEB()
+    {
+      uint64_t ret = 0;
+      uint32_t shift = 0;
+      while(cur < end)
+      {
+        byte b = *cur++;
+        if(shift < 64)
+          ret |= uint64_t(b & 0x7f) << shift;
+        shift += 7;
+        if((b & 0x80) == 0)
+          break;
+      }
+      return ret;
+    }
+    int64_t ReadSLEB()
+    {
+      int64_t ret = 0;
+      uint32_t shift = 0;
+      byte b = 0;
+      while(cur < end)
+      {
+        b = *cur++;
+        if(shift < 64)
+          ret |= int64_t(b & 0x7f) << shift;
+        shift += 7;
+        if((b & 0x80) == 0)
+          break;
+      }
+      if(shift < 64 && (b & 0x40))
+        ret |= -(int64_t(1) << shift);
+      return ret;
+    }
+    const char *ReadString()
+    {
+      const char *ret = (const char *)cur;
+      while(cur < end && *cur)
+        cur++;
+      if(cur >= end)
+        return "";
+      cur++;
+      return ret;
+    }
+    uint64_t ReadOffset(bool dwarf64) { return dwarf64 ? Read<uint64_t>() : Read<uint32_t>(); }
+    uint64_t ReadAddress(uint8_t size)
+    {
+      if(size == 8)
+        return Read<uint64_t>();
+      if(size == 4)
+        return Read<uint32_t>();
+      cur += size;
+      return 0;
+    }
+  };
+
+  static const char *StringAt(const Section &sec, uint64_t offset)
+  {
+    if(offset >= sec.size)
+      return "";
+    return (const char *)sec.data + offset;
+  }
+
+  // reads an attribute value of the given form, returning a string or integer as appropriate.
+  // Values we have no use for (references, blocks, indexed strings) are skipped. Returns false if
+  // the form isn't known, since then the rest of the entry can't be read.
+  static bool ReadForm(DwarfReader &r, uint64_t form, bool dwarf64, uint16_t version,
+                       uint8_t addressSize, const Section &lineStr, const Section &str,
+                       const char *&strVal, uint64_t &intVal)
+  {
+    switch(form)
+    {
+      case 0x01: intVal = r.ReadAddress(addressSize); break;                       // addr
+      case 0x03: r.cur += r.Read<uint16_t>(); break;                               // block2
+      case 0x04: r.cur += r.Read<uint32_t>(); break;                               // block4
+      case 0x05: intVal = r.Read<uint16_t>(); break;                               // data2
+      case 0x06: intVal = r.Read<uint32_t>(); break;                               // data4
+      case 0x07: intVal = r.Read<uint64_t>(); break;                               // data8
+      case 0x08: strVal = r.ReadString(); break;                                   // string
+      case 0x09: r.cur += r.ReadULEB(); break;                                     // block
+      case 0x0a: r.cur += r.Read<uint8_t>(); break;                                // block1
+      case 0x0b: intVal = r.Read<uint8_t>(); break;                                // data1
+      case 0x0c: intVal = r.Read<uint8_t>(); break;                                // flag
+      case 0x0d: intVal = (uint64_t)r.ReadSLEB(); break;                           // sdata
+      case 0x0e: strVal = StringAt(str, r.ReadOffset(dwarf64)); break;             // strp
+      case 0x0f: intVal = r.ReadULEB(); break;                                     // udata
+      case 0x10:                                                                   // ref_addr
+        intVal = version <= 2 ? r.ReadAddress(addressSize) : r.ReadOffset(dwarf64);
+        break;
+      case 0x11: r.cur += 1; break;                                                // ref1
+      case 0x12: r.cur += 2; break;                                                // ref2
+      case 0x13: r.cur += 4; break;                                                // ref4
+      case 0x14: r.cur += 8; break;                                                // ref8
+      case 0x15: r.ReadULEB(); break;                                              // ref_udata
+      case 0x16:                                                                   // indirect
+        return ReadForm(r, r.ReadULEB(), dwarf64, version, addressSize, lineStr, str, strVal,
+                        intVal);
+      case 0x17: intVal = r.ReadOffset(dwarf64); break;                            // sec_offset
+      case 0x18: r.cur += r.ReadULEB(); break;                                     // exprloc
+      case 0x19: intVal = 1; break;                                                // flag_present
+      case 0x1a: r.ReadULEB(); break;                                              // strx
+      case 0x1b: r.ReadULEB(); break;                                              // addrx
+      case 0x1c: r.cur += 4; break;                                                // ref_sup4
+      case 0x1d: r.ReadOffset(dwarf64); break;                                     // strp_sup
+      case 0x1e: r.cur += 16; break;                                               // data16
+      case 0x1f: strVal = StringAt(lineStr, r.ReadOffset(dwarf64)); break;         // line_strp
+      case 0x20: r.cur += 8; break;                                                // ref_sig8
+      case 0x21: break;    // implicit_const, the value is in the abbreviation
+      case 0x22: r.ReadULEB(); break;                                              // loclistx
+      case 0x23: r.ReadULEB(); break;                                              // rnglistx
+      case 0x24: r.cur += 8; break;                                                // ref_sup8
+      case 0x25: r.cur += 1; break;                                                // strx1
+      case 0x26: r.cur += 2; break;                                                // strx2
+      case 0x27: r.cur += 3; break;                                                // strx3
+      case 0x28: r.cur += 4; break;                                                // strx4
+      case 0x29: r.cur += 1; break;                                                // addrx1
+      case 0x2a: r.cur += 2; break;                                                // addrx2
+      case 0x2b: r.cur += 3; break;                                                // addrx3
+      case 0x2c: r.cur += 4; break;                                                // addrx4
+      default: r.cur = r.end; return false;
+    }
+
+    return true;
+  }
+
+  // reads the DW_AT_comp_dir of each compile unit in .debug_info, keyed by its DW_AT_stmt_list
+  // offset into .debug_line. Only the unit's top-level entry is read, nothing below it.
+  static void ReadCompDirs(const Section &debugInfo, const Section &debugAbbrev,
+                           const Section &lineStr, const Section &str,
+                           std::map<uint64_t, std::string> &compDirs)
+  {
+    DwarfReader unitReader = {debugInfo.data, debugInfo.data + debugInfo.size};
+
+    while(!unitReader.AtEnd())
+    {
+      bool dwarf64 = false;
+      uint64_t unitLength = unitReader.Read<uint32_t>();
+      if(unitLength == 0xffffffff)
+      {
+        dwarf64 = true;
+        unitLength = unitReader.Read<uint64_t>();
+      }
+
+      if(unitReader.cur + unitLength > unitReader.end || unitLength == 0)
+        break;
+
+      DwarfReader r = {unitReader.cur, unitReader.cur + unitLength};
+      unitReader.cur += unitLength;
+
+      uint16_t version = r.Read<uint16_t>();
+      if(version < 2 || version > 5)
+        continue;
+
+      uint8_t addressSize = 0;
+      uint64_t abbrevOffset = 0;
+      if(version >= 5)
+      {
+        uint8_t unitType = r.Read<uint8_t>();
+        addressSize = r.Read<uint8_t>();
+        abbrevOffset = r.ReadOffset(dwarf64);
+
+        // DW_UT_skeleton and DW_UT_split_compile have a DWO id, type units have no line table
+        if(unitType == 0x04 || unitType == 0x05)
+          r.Read<uint64_t>();
+        else if(unitType != 0x01 && unitType != 0x03)
+          continue;
+      }
+      else
+      {
+        abbrevOffset = r.ReadOffset(dwarf64);
+        addressSize = r.Read<uint8_t>();
+      }
+
+      uint64_t code = r.ReadULEB();
+      if(code == 0 || abbrevOffset >= debugAbbrev.size)
+        continue;
+
+      // find the abbreviation used by the unit's entry
+      DwarfReader a = {debugAbbrev.data + abbrevOffset, debugAbbrev.data + debugAbbrev.size};
+      bool found = false;
+      while(!a.AtEnd())
+      {
+        uint64_t abbrevCode = a.ReadULEB();
+        if(abbrevCode == 0)
+          break;
+
+        a.ReadULEB();         // tag
+        a.Read<uint8_t>();    // has children
+
+        if(abbrevCode == code)
+        {
+          found = true;
+          break;
+        }
+
+        while(!a.AtEnd())
+        {
+          uint64_t attr = a.ReadULEB();
+          uint64_t form = a.ReadULEB();
+          if(form == 0x21)    // implicit_const
+            a.ReadSLEB();
+          if(attr == 0 && form == 0)
+            break;
+        }
+      }
+
+      if(!found)
+        continue;
+
+      const char *compDir = NULL;
+      uint64_t stmtList = ~0ULL;
+
+      while(!a.AtEnd() && !r.AtEnd())
+      {
+        uint64_t attr = a.ReadULEB();
+        uint64_t form = a.ReadULEB();
+        if(form == 0x21)    // implicit_const
+          a.ReadSLEB();
+        if(attr == 0 && form == 0)
+          break;
+
+        const char *strVal = NULL;
+        uint64_t intVal = 0;
+        if(!ReadForm(r, form, dwarf64, version, addressSize, lineStr, str, strVal, intVal))
+          break;
+
+        // DW_AT_stmt_list
+        if(attr == 0x10)
+          stmtList = intVal;
+        // DW_AT_comp_dir
+        else if(attr == 0x1b && strVal)
+          compDir = strVal;
+      }
+
+      if(compDir && stmtList != ~0ULL)
+        compDirs[stmtList] = compDir;
+    }
+  }
+
+  void ParseDebugLine(const Section &debugLine, const Section &lineStr, const Section &str,
+                      const std::map<uint64_t, std::string> &compDirs, bool elf64)
+  {
+    DwarfReader unitReader = {debugLine.data, debugLine.data + debugLine.size};
+
+    while(!unitReader.AtEnd())
+    {
+      uint64_t unitOffset = uint64_t(unitReader.cur - debugLine.data);
+      bool dwarf64 = false;
+      uint64_t unitLength = unitReader.Read<uint32_t>();
+      if(unitLength == 0xffffffff)
+      {
+        dwarf64 = true;
+        unitLength = unitReader.Read<uint64_t>();
+      }
+
+      if(unitReader.cur + unitLength > unitReader.end || unitLength == 0)
+        break;
+
+      DwarfReader r = {unitReader.cur, unitReader.cur + unitLength};
+      unitReader.cur += unitLength;
+
+      uint16_t version = r.Read<uint16_t>();
+      if(version < 2 || version > 5)
+        continue;
+
+      uint8_t addressSize = elf64 ? 8 : 4;
+      if(version >= 5)
+      {
+        addressSize = r.Read<uint8_t>();
+        r.Read<uint8_t>();    // segment selector size
+      }
+
+      uint64_t headerLength = r.ReadOffset(dwarf64);
+      const byte *program = r.cur + headerLength;
+
+      uint8_t minInstLength = r.Read<uint8_t>();
+      if(version >= 4)
+        r.Read<uint8_t>();    // maximum operations per instruction
+      r.Read<uint8_t>();    // default is_stmt
+      int8_t lineBase = r.Read<int8_t>();
+      uint8_t lineRange = r.Read<uint8_t>();
+      uint8_t opcodeBase = r.Read<uint8_t>();
+
+      if(lineRange == 0 || opcodeBase == 0)
+        continue;
+
+      std::vector<uint8_t> opcodeLengths(opcodeBase);
+      for(uint8_t i = 1; i < opcodeBase; i++)
+        opcodeLengths[i] = r.Read<uint8_t>();
+
+      std::vector<std::string> dirs;
+      // file indices in this unit, mapped to indices in m_Files
+      std::vector<uint32_t> files;
+
+      auto addFile = [this, &dirs, &files](const char *name, uint64_t dir) {
+        std::string path = name;
+        if(path[0] != '/' && dir < dirs.size() && !dirs[dir].empty())
+          path = dirs[dir] + "/" + path;
+        files.push_back((uint32_t)m_Files.size());
+        m_Files.push_back(path);
+      };
+
+      if(version < 5)
+      {
+        // directory 0 is the compilation directory which isn't listed, and the other directories
+        // may be relative to it
+        auto compDir = compDirs.find(unitOffset);
+        dirs.push_back(compDir != compDirs.end() ? compDir->second : std::string());
+        while(!r.AtEnd())
+        {
+          const char *dir = r.ReadString();
+          if(dir[0] == 0)
+            break;
+          if(dir[0] != '/' && !dirs[0].empty())
+            dirs.push_back(dirs[0] + "/" + dir);
+          else
+            dirs.push_back(dir);
+        }
+
+        // file 0 is invalid before DWARF 5, files are 1-based
+        files.push_back(~0U);
+        while(!r.AtEnd())
+        {
+          const char *name = r.ReadString();
+          if(name[0] == 0)
+            break;
+          uint64_t dir = r.ReadULEB();
+          r.ReadULEB();    // modification time
+          r.ReadULEB();    // length
+          addFile(name, dir);
+        }
+      }
+      else
+      {
+        for(int pass = 0; pass < 2; pass++)
+        {
+          uint8_t formatCount = r.Read<uint8_t>();
+          std::vector<std::pair<uint64_t, uint64_t>> formats;
+          for(uint8_t i = 0; i < formatCount; i++)
+          {
+            uint64_t contentType = r.ReadULEB();
+            uint64_t form = r.ReadULEB();
+            formats.push_back({contentType, form});
+          }
+
+          uint64_t count = r.ReadULEB();
+          for(uint64_t i = 0; i < count && !r.AtEnd(); i++)
+          {
+            const char *path = "";
+            uint64_t dir = 0;
+            for(const std::pair<uint64_t, uint64_t> &fmt : formats)
+            {
+              const char *strVal = NULL;
+              uint64_t intVal = 0;
+              ReadForm(r, fmt.second, dwarf64, version, addressSize, lineStr, str, strVal,
+                       intVal);
+
+              // DW_LNCT_path
+              if(fmt.first == 1 && strVal)
+                path = strVal;
+              // DW_LNCT_directory_index
+              else if(fmt.first == 2)
+                dir = intVal;
+            }
+
+            if(pass == 0)
+              dirs.push_back(path);
+            else
+              addFile(path, dir);
+          }
+        }
+      }
+
+      r.cur = program;
+
+      // line number state machine
+      uint64_t address = 0;
+      uint64_t file = 1;
+      int64_t line = 1;
+
+      auto emitRow = [this, &address, &file, &line, &files](bool endSequence) {
+        LineRow row;
+        row.address = address;
+        row.file = file < files.size() ? files[(size_t)file] : ~0U;
+        row.line = uint32_t(line) & 0x7fffffff;
+        row.endSequence = endSequence ? 1 : 0;
+        m_Lines.push_back(row);
+      };
+
+      while(!r.AtEnd())
+      {
+        uint8_t op = r.Read<uint8_t>();
+
+        if(op >= opcodeBase)
+        {
+          uint8_t adjusted = op - opcodeBase;
+          address += (adjusted / lineRange) * minInstLength;
+          line += lineBase + (adjusted % lineRange);
+          emitRow(false);
+          continue;
+        }
+
+        switch(op)
+        {
+          case 0:    // extended opcode
+          {
+            uint64_t len = r.ReadULEB();
+            const byte *next = r.cur + len;
+            uint8_t subop = len > 0 ? r.Read<uint8_t>() : 0;
+            if(subop == 1)    // DW_LNE_end_sequence
+            {
+              emitRow(true);
+              address = 0;
+              file = 1;
+              line = 1;
+            }
+            else if(subop == 2)    // DW_LNE_set_address
+            {
+              address = r.ReadAddress(uint8_t(len - 1));
+            }
+            else if(subop == 3 && version < 5)    // DW_LNE_define_file
+            {
+              const char *name = r.ReadString();
+              uint64_t dir = r.ReadULEB();
+              addFile(name, dir);
+            }
+            r.cur = next;
+            break;
+          }
+          case 1: emitRow(false); break;                                   // DW_LNS_copy
+          case 2: address += r.ReadULEB() * minInstLength; break;          // DW_LNS_advance_pc
+          case 3: line += r.ReadSLEB(); break;                             // DW_LNS_advance_line
+          case 4: file = r.ReadULEB(); break;                              // DW_LNS_set_file
+          case 8:                                                          // DW_LNS_const_add_pc
+            address += ((255 - opcodeBase) / lineRange) * minInstLength;
+            break;
+          case 9: address += r.Read<uint16_t>(); break;    // DW_LNS_fixed_advance_pc
+          default:
+            // skip any other standard opcodes by their declared number of LEB operands
+            for(uint8_t i = 0; i < opcodeLengths[op]; i++)
+              r.ReadULEB();
+            break;
+        }
+      }
+    }
+
+    // sequences can be in any order, sort by address. Keep end-of-sequence rows before any row
+    // starting at the same address so they don't hide the start of the next sequence
+    std::stable_sort(m_Lines.begin(), m_Lines.end(), [](const LineRow &a, const LineRow &b) {
+      if(a.address != b.address)
+        return a.address < b.address;
+      return a.endSequence > b.endSequence;
+    });
+  }
+};
+
 class LinuxResolver : public Callstack::StackResolver
 {
 public:
@@ -177,48 +1288,27 @@ private:
     {
       if(addr >= m_Modules[i].base && addr < m_Modules[i].end)
       {
-        uint64_t relative = addr - m_Modules[i].base + m_Modules[i].offset;
-        std::string cmd =
-            StringFormat::Fmt("addr2line -fCe \"%s\" 0x%llx", m_Modules[i].path, relative);
-
-        FILE *f = ::popen(cmd.c_str(), "r");
-
-        char result[2048] = {0};
-        fread(result, 1, 2047, f);
-
-        fclose(f);
-
-        char *line2 = strchr(result, '\n');
-        if(line2)
-        {
-          *line2 = 0;
-          line2++;
-        }
-
-        ret.function = result;
-
-        if(line2)
+        // each module is only parsed once, the first time an address inside it is resolved. The
+        // same file may be mapped in several places, so key on the path.
+        auto sym = m_Symbols.find(m_Modules[i].path);
+        if(sym == m_Symbols.end())
         {
-          char *linenum = line2 + strlen(line2) - 1;
-          while(linenum > line2 && *linenum != ':')
-            linenum--;
+          std::unique_ptr<ElfSymbols> &symbols = m_Symbols[m_Modules[i].path];
 
-          ret.line = 0;
-
-          if(*linenum == ':')
+          symbols.reset(new ElfSymbols);
+          if(!symbols->Load(m_Modules[i].path))
           {
-            *linenum = 0;
-            linenum++;
-
-            while(*linenum >= '0' && *linenum <= '9')
-            {
-              ret.line *= 10;
-              ret.line += (uint32_t(*linenum) - uint32_t('0'));
-              linenum++;
-            }
+            RDCWARN("Couldn't load symbols from %s", m_Modules[i].path);
+            symbols.reset();
           }
 
-          ret.filename = line2;
+          sym = m_Symbols.find(m_Modules[i].path);
+        }
+
+        if(sym->second)
+        {
+          uint64_t relative = addr - m_Modules[i].base + m_Modules[i].offset;
+          sym->second->Resolve(sym->second->FileOffsetToAddress(relative), ret);
         }
 
         break;
@@ -227,6 +1317,7 @@ private:
   }
 
   std::vector<LookupModule> m_Modules;
+  std::map<std::string, std::unique_ptr<ElfSymbols>> m_Symbols;
   std::map<uint64_t, Callstack::AddressDetails> m_Cache;
 };
 
@@ -316,3 +1407,229 @@ StackResolver *MakeResolver(byte *moduleDB, size_t DBSize, RENDERDOC_ProgressCal
   return new LinuxResolver(modules);
 }
 };
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+
+// builds a minimal 64-bit ELF with a symbol table, a DWARF 4 line table and a compile unit giving
+// the compilation directory, which the line table doesn't list itself before DWARF 5.
+static std::vector<byte> MakeTestELF()
+{
+  std::vector<byte> shstrtab, symtab, strtab, debugLine, debugInfo, debugAbbrev;
+
+  auto append = [](std::vector<byte> &vec, const void *data, size_t size) {
+    vec.insert(vec.end(), (const byte *)data, (const byte *)data + size);
+  };
+  auto appendStr = [&append](std::vector<byte> &vec, const char *str) {
+    append(vec, str, strlen(str) + 1);
+  };
+  auto appendByte = [](std::vector<byte> &vec, byte b) { vec.push_back(b); };
+  auto appendU32 = [&append](std::vector<byte> &vec, uint32_t v) { append(vec, &v, 4); };
+  auto appendU64 = [&append](std::vector<byte> &vec, uint64_t v) { append(vec, &v, 8); };
+
+  appendByte(shstrtab, 0);
+  const char *sectionNames[] = {".shstrtab",  ".symtab",     ".strtab",
+                                ".debug_line", ".debug_info", ".debug_abbrev"};
+  uint32_t nameOffsets[6];
+  for(int i = 0; i < 6; i++)
+  {
+    nameOffsets[i] = (uint32_t)shstrtab.size();
+    appendStr(shstrtab, sectionNames[i]);
+  }
+
+  appendByte(strtab, 0);
+  appendStr(strtab, "test_function");
+
+  Elf64_Sym sym = {};
+  append(symtab, &sym, sizeof(sym));
+  sym.st_name = 1;
+  sym.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+  sym.st_value = 0x1000;
+  sym.st_size = 0x40;
+  append(symtab, &sym, sizeof(sym));
+
+  // abbreviation 1: DW_TAG_compile_unit, no children, name/comp_dir as strings, stmt_list
+  const byte abbrev[] = {1, 0x11, 0, 0x03, 0x08, 0x1b, 0x08, 0x10, 0x17, 0, 0, 0};
+  append(debugAbbrev, abbrev, sizeof(abbrev));
+
+  appendU32(debugInfo, 0);    // unit length, patched below
+  appendByte(debugInfo, 4);
+  appendByte(debugInfo, 0);    // version
+  appendU32(debugInfo, 0);     // abbrev offset
+  appendByte(debugInfo, 8);    // address size
+  appendByte(debugInfo, 1);    // abbreviation code
+  appendStr(debugInfo, "src/test.cpp");
+  appendStr(debugInfo, "/build/dir");
+  appendU32(debugInfo, 0);    // stmt_list
+  uint32_t infoLength = uint32_t(debugInfo.size() - 4);
+  memcpy(debugInfo.data(), &infoLength, 4);
+
+  appendU32(debugLine, 0);    // unit length, patched below
+  appendByte(debugLine, 4);
+  appendByte(debugLine, 0);    // version
+  appendU32(debugLine, 0);     // header length, patched below
+  size_t headerStart = debugLine.size();
+  const byte lineParams[] = {1, 1, 1, byte(-5), 14, 13, 0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1};
+  append(debugLine, lineParams, sizeof(lineParams));
+  appendStr(debugLine, "src");
+  appendByte(debugLine, 0);
+  // test.cpp in directory 1 (src), main.cpp in directory 0 (the compilation directory)
+  appendStr(debugLine, "test.cpp");
+  appendByte(debugLine, 1);
+  appendByte(debugLine, 0);
+  appendByte(debugLine, 0);
+  appendStr(debugLine, "main.cpp");
+  appendByte(debugLine, 0);
+  appendByte(debugLine, 0);
+  appendByte(debugLine, 0);
+  appendByte(debugLine, 0);
+  uint32_t headerLength = uint32_t(debugLine.size() - headerStart);
+  memcpy(debugLine.data() + 6, &headerLength, 4);
+
+  // set_address 0x1000, line 10, copy
+  const byte setAddress[] = {0, 9, 2};
+  append(debugLine, setAddress, sizeof(setAddress));
+  appendU64(debugLine, 0x1000);
+  const byte program[] = {
+      3, 9, 1,          // advance_line 9, copy
+      2, 0x10, 4, 2,    // advance_pc 16, set_file 2
+      3, 10, 1,         // advance_line 10, copy
+      2, 0x30, 0, 1, 1,    // advance_pc 48, end_sequence
+  };
+  append(debugLine, program, sizeof(program));
+  uint32_t lineLength = uint32_t(debugLine.size() - 4);
+  memcpy(debugLine.data(), &lineLength, 4);
+
+  std::vector<byte> elf(sizeof(Elf64_Ehdr));
+
+  const std::vector<byte> *contents[] = {&shstrtab,  &symtab,    &strtab,
+                                         &debugLine, &debugInfo, &debugAbbrev};
+  const uint32_t types[] = {SHT_STRTAB,   SHT_SYMTAB,   SHT_STRTAB,
+                            SHT_PROGBITS, SHT_PROGBITS, SHT_PROGBITS};
+
+  Elf64_Shdr shdrs[7] = {};
+  for(int i = 0; i < 6; i++)
+  {
+    shdrs[i + 1].sh_name = nameOffsets[i];
+    shdrs[i + 1].sh_type = types[i];
+    shdrs[i + 1].sh_offset = elf.size();
+    shdrs[i + 1].sh_size = contents[i]->size();
+    elf.insert(elf.end(), contents[i]->begin(), contents[i]->end());
+  }
+  shdrs[2].sh_link = 3;
+  shdrs[2].sh_entsize = sizeof(Elf64_Sym);
+
+  while(elf.size() % 8)
+    elf.push_back(0);
+
+  Elf64_Ehdr ehdr = {};
+  memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+  ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+  ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+  ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+  ehdr.e_type = ET_DYN;
+  ehdr.e_machine = EM_X86_64;
+  ehdr.e_version = EV_CURRENT;
+  ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+  ehdr.e_shentsize = sizeof(Elf64_Shdr);
+  ehdr.e_shoff = elf.size();
+  ehdr.e_shnum = 7;
+  ehdr.e_shstrndx = 1;
+  memcpy(elf.data(), &ehdr, sizeof(ehdr));
+
+  append(elf, shdrs, sizeof(shdrs));
+
+  return elf;
+}
+
+static bool LoadTestELF(const std::vector<byte> &elf, Callstack::ElfSymbols &symbols)
+{
+  std::string path = FileIO::GetTempFolderFilename() + "renderdoc_elf_test.so";
+
+  FILE *f = FileIO::fopen(path.c_str(), "wb");
+  if(!f)
+    return false;
+  FileIO::fwrite(elf.data(), 1, elf.size(), f);
+  FileIO::fclose(f);
+
+  bool ret = symbols.Load(path.c_str());
+
+  FileIO::Delete(path.c_str());
+
+  return ret;
+}
+
+TEST_CASE("Test ELF symbol and line resolution", "[callstack]")
+{
+  std::vector<byte> elf = MakeTestELF();
+
+  SECTION("Functions and lines resolve")
+  {
+    Callstack::ElfSymbols symbols;
+    REQUIRE(LoadTestELF(elf, symbols));
+
+    Callstack::AddressDetails details;
+    symbols.Resolve(0x1008, details);
+    CHECK(details.function == "test_function");
+    CHECK(details.filename == "/build/dir/src/test.cpp");
+    CHECK(details.line == 10);
+
+    details = Callstack::AddressDetails();
+    symbols.Resolve(0x1020, details);
+    CHECK(details.function == "test_function");
+    CHECK(details.filename == "/build/dir/main.cpp");
+    CHECK(details.line == 20);
+
+    // past the end of the function and the line sequence
+    details = Callstack::AddressDetails();
+    symbols.Resolve(0x1050, details);
+    CHECK(details.function == "");
+    CHECK(details.filename == "");
+  };
+
+  SECTION("Out of bounds offsets are rejected")
+  {
+    Elf64_Ehdr *ehdr = (Elf64_Ehdr *)elf.data();
+    Elf64_Shdr *shdrs = (Elf64_Shdr *)(elf.data() + ehdr->e_shoff);
+
+    SECTION("Section name table offset")
+    {
+      shdrs[1].sh_offset = 0x7fffffff;
+
+      Callstack::ElfSymbols symbols;
+      CHECK_FALSE(LoadTestELF(elf, symbols));
+    };
+
+    SECTION("Section and symbol names")
+    {
+      shdrs[4].sh_name = 0x7fffffff;
+      Elf64_Sym *syms = (Elf64_Sym *)(elf.data() + shdrs[2].sh_offset);
+      syms[1].st_name = 0x7fffffff;
+
+      Callstack::ElfSymbols symbols;
+      REQUIRE(LoadTestELF(elf, symbols));
+
+      // the line table is no longer found by name, and the symbol is dropped
+      Callstack::AddressDetails details;
+      symbols.Resolve(0x1008, details);
+      CHECK(details.function == "");
+      CHECK(details.filename == "");
+    };
+
+    SECTION("String table offset")
+    {
+      shdrs[3].sh_offset = 0x7fffffff;
+
+      Callstack::ElfSymbols symbols;
+      REQUIRE(LoadTestELF(elf, symbols));
+
+      Callstack::AddressDetails details;
+      symbols.Resolve(0x1008, details);
+      CHECK(details.function == "");
+      CHECK(details.filename == "/build/dir/src/test.cpp");
+    };
+  };
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -41,10 +41,16 @@ static std::vector<FunctionHook> functionHooks;
 
 void *intercept_dlopen(const char *filename, int flag, void *ret);
 void plthook_lib(void *handle);
+void InvalidateCallstackModuleCache();
+void BeginCallstackModuleChange();
+void EndCallstackModuleChange();
 
 typedef void *(*DLOPENPROC)(const char *, int);
 DLOPENPROC realdlopen = NULL;
 
+typedef int (*DLCLOSEPROC)(void *);
+DLCLOSEPROC realdlclose = NULL;
+
 static volatile int32_t tlsbusyflag = 0;
 
 __attribute__((visibility("default"))) void *dlopen(const char *filename, int flag)
@@ -58,6 +64,8 @@ __attribute__((visibility("default"))) void *dlopen(const char *filename, int fl
     if(filename && ret && (flag & RTLD_DEEPBIND))
       plthook_lib(ret);
 
+    InvalidateCallstackModuleCache();
+
     return ret;
   }
 
@@ -66,6 +74,10 @@ __attribute__((visibility("default"))) void *dlopen(const char *filename, int fl
   void *ret = realdlopen(filename, flag);
   Atomic::Dec32(&tlsbusyflag);
 
+  // the set of mapped modules may have changed
+  if(ret)
+    InvalidateCallstackModuleCache();
+
   if(filename && ret)
   {
     SCOPED_LOCK(libLock);
@@ -75,6 +87,20 @@ __attribute__((visibility("default"))) void *dlopen(const char *filename, int fl
   return ret;
 }
 
+__attribute__((visibility("default"))) int dlclose(void *handle)
+{
+  if(!realdlclose)
+    realdlclose = (DLCLOSEPROC)dlsym(RTLD_NEXT, "dlclose");
+
+  // hold off callstack walks until the module is gone and the cached module list is dropped, so
+  // none can read code that's being unmapped
+  BeginCallstackModuleChange();
+  int ret = realdlclose(handle);
+  EndCallstackModuleChange();
+
+  return ret;
+}
+
 void plthook_lib(void *handle)
 {
   plthook_t *plthook = NULL;
@@ -85,6 +111,7 @@ void plthook_lib(void *handle)
     return;
 
   plthook_replace(plthook, "dlopen", (void *)dlopen, NULL);
+  plthook_replace(plthook, "dlclose", (void *)dlclose, NULL);
 
   for(FunctionHook &hook : functionHooks)
   {
@@ -156,6 +156,63 @@ void RWLock::ReadUnlock()
   pthread_rwlock_unlock(&m_Data.rwlock);
 }
 
+struct PosixSemaphore
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  bool woken;
+};
+
+Semaphore *Semaphore::Create()
+{
+  PosixSemaphore *sem = new PosixSemaphore;
+  pthread_mutex_init(&sem->lock, NULL);
+  pthread_cond_init(&sem->cond, NULL);
+  sem->woken = false;
+  return (Semaphore *)sem;
+}
+
+void Semaphore::Destroy()
+{
+  PosixSemaphore *sem = (PosixSemaphore *)this;
+  pthread_cond_destroy(&sem->cond);
+  pthread_mutex_destroy(&sem->lock);
+  delete sem;
+}
+
+void Semaphore::Wake()
+{
+  PosixSemaphore *sem = (PosixSemaphore *)this;
+  pthread_mutex_lock(&sem->lock);
+  sem->woken = true;
+  pthread_cond_signal(&sem->cond);
+  pthread_mutex_unlock(&sem->lock);
+}
+
+void Semaphore::WaitForWake(uint32_t timeoutMS)
+{
+  PosixSemaphore *sem = (PosixSemaphore *)this;
+
+  timespec deadline = {};
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeoutMS / 1000;
+  deadline.tv_nsec += (timeoutMS % 1000) * 1000000;
+  if(deadline.tv_nsec >= 1000000000)
+  {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+
+  pthread_mutex_lock(&sem->lock);
+  while(!sem->woken)
+  {
+    if(pthread_cond_timedwait(&sem->cond, &sem->lock, &deadline) != 0)
+      break;
+  }
+  sem->woken = false;
+  pthread_mutex_unlock(&sem->lock);
+}
+
 struct ThreadInitData
 {
   std::function<void()> entryFunc;
@@ -251,6 +251,27 @@ void SetTLSValue(uint64_t slot, void *value)
   slots->data[(size_t)slot - 1] = value;
 }
 
+// an auto-reset event has exactly the semantics we want, so the handle is the semaphore
+Semaphore *Semaphore::Create()
+{
+  return (Semaphore *)CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+void Semaphore::Destroy()
+{
+  CloseHandle((HANDLE)this);
+}
+
+void Semaphore::Wake()
+{
+  SetEvent((HANDLE)this);
+}
+
+void Semaphore::WaitForWake(uint32_t timeoutMS)
+{
+  WaitForSingleObject((HANDLE)this, timeoutMS);
+}
+
 ThreadHandle CreateThread(std::function<void()> entryFunc)
 {
   ThreadInitData *initData = new ThreadInitData;
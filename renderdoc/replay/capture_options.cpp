@@ -182,4 +182,5 @@ CaptureOptions::CaptureOptions()
   refAllResources = false;
   captureAllCmdLists = false;
   debugOutputMute = true;
+  combineMultiFrameCaptures = false;
 }
@@ -111,6 +111,7 @@ void DoSerialise(SerialiserType &ser, CaptureOptions &el)
   SERIALISE_MEMBER(refAllResources);
   SERIALISE_MEMBER(captureAllCmdLists);
   SERIALISE_MEMBER(debugOutputMute);
+  SERIALISE_MEMBER(combineMultiFrameCaptures);
 
   SIZE_CHECK(20);
 }
@@ -861,6 +862,17 @@ void DoSerialise(SerialiserType &ser, EventUsage &el)
   SIZE_CHECK(16);
 }
 
+template <typename SerialiserType>
+void DoSerialise(SerialiserType &ser, ResourceEventUsage &el)
+{
+  SERIALISE_MEMBER(resourceId);
+  SERIALISE_MEMBER(eventId);
+  SERIALISE_MEMBER(usage);
+  SERIALISE_MEMBER(view);
+
+  SIZE_CHECK(24);
+}
+
 template <typename SerialiserType>
 void DoSerialise(SerialiserType &ser, CounterResult &el)
 {
@@ -2237,6 +2249,7 @@ INSTANTIATE_SERIALISE_TYPE(Uuid)
 INSTANTIATE_SERIALISE_TYPE(CounterDescription)
 INSTANTIATE_SERIALISE_TYPE(PixelModification)
 INSTANTIATE_SERIALISE_TYPE(EventUsage)
+INSTANTIATE_SERIALISE_TYPE(ResourceEventUsage)
 INSTANTIATE_SERIALISE_TYPE(CounterResult)
 INSTANTIATE_SERIALISE_TYPE(CounterValue)
 INSTANTIATE_SERIALISE_TYPE(D3D11Pipe::Layout)
@@ -27,6 +27,7 @@
 #include <string.h>
 #include <time.h>
 #include "common/dds_readwrite.h"
+#include "common/threading.h"
 #include "driver/ihv/amd/amd_isa.h"
 #include "driver/ihv/amd/amd_rgp.h"
 #include "jpeg-compressor/jpgd.h"
@@ -169,6 +170,37 @@ static void fileWriteFunc(void *context, void *data, int size)
   FileIO::fwrite(data, 1, size, (FILE *)context);
 }
 
+// pixel conversions when saving textures are done in batches of rows spread over a few threads
+static const int32_t SaveTextureThreads = 4;
+static const uint32_t SaveTexturePixelsPerBatch = 64 * 1024;
+
+// calls func(startRow, endRow) for batches of rows, in parallel. Each row must be independent
+static void ForEachRowBatch(uint32_t width, uint32_t height,
+                            std::function<void(uint32_t, uint32_t)> func)
+{
+  uint32_t rowsPerBatch = RDCMAX(1U, SaveTexturePixelsPerBatch / RDCMAX(1U, width));
+  int32_t numBatches = int32_t((height + rowsPerBatch - 1) / rowsPerBatch);
+
+  Threading::ParallelFor(numBatches, SaveTextureThreads, [&](int32_t batch) {
+    uint32_t startRow = uint32_t(batch) * rowsPerBatch;
+    func(startRow, RDCMIN(height, startRow + rowsPerBatch));
+  });
+}
+
+// splat one channel across the others and set alpha to all 1s
+template <typename T>
+static void ExtractChannel(T *data, uint32_t numPixels, uint32_t compCount, uint32_t channel)
+{
+  for(uint32_t p = 0; p < numPixels; p++)
+  {
+    T *pixel = data + p * compCount;
+    T val = pixel[channel];
+
+    for(uint32_t c = 0; c < compCount; c++)
+      pixel[c] = (c == 3) ? T(~T(0)) : val;
+  }
+}
+
 ReplayController::ReplayController()
 {
   m_ThreadID = Threading::GetCurrentID();
@@ -600,14 +632,64 @@ ShaderReflection *ReplayController::GetShader(ResourceId shader, ShaderEntryPoin
   return m_pDevice->GetShader(m_pDevice->GetLiveID(shader), entry);
 }
 
+void ReplayController::CacheUsage(ResourceId id)
+{
+  if(m_Usage.Contains(id))
+    return;
+
+  ResourceId liveId = m_pDevice->GetLiveID(id);
+  if(liveId == ResourceId())
+    m_Usage.Add(id, std::vector<EventUsage>());
+  else
+    m_Usage.Add(id, m_pDevice->GetUsage(liveId));
+}
+
 rdcarray<EventUsage> ReplayController::GetUsage(ResourceId id)
 {
   CHECK_REPLAY_THREAD();
 
-  id = m_pDevice->GetLiveID(id);
-  if(id == ResourceId())
-    return rdcarray<EventUsage>();
-  return m_pDevice->GetUsage(id);
+  rdcarray<EventUsage> ret;
+
+  CacheUsage(id);
+  m_Usage.GetUsage(id, 0, ~0U, ret);
+
+  return ret;
+}
+
+rdcarray<ResourceEventUsage> ReplayController::GetUsages(const rdcarray<ResourceId> &ids)
+{
+  CHECK_REPLAY_THREAD();
+
+  rdcarray<ResourceEventUsage> ret;
+
+  for(ResourceId id : ids)
+  {
+    CacheUsage(id);
+    m_Usage.GetUsage(id, 0, ~0U, ret);
+  }
+
+  return ret;
+}
+
+rdcarray<ResourceEventUsage> ReplayController::GetEventUsage(uint32_t startEventId,
+                                                             uint32_t endEventId)
+{
+  CHECK_REPLAY_THREAD();
+
+  // the reverse lookup needs every resource in the index, which is only fetched once.
+  if(!m_AllUsageCached)
+  {
+    for(const ResourceDescription &desc : m_Resources)
+      CacheUsage(desc.resourceId);
+
+    m_AllUsageCached = true;
+  }
+
+  rdcarray<ResourceEventUsage> ret;
+
+  m_Usage.GetEventUsage(startEventId, endEventId, ret);
+
+  return ret;
 }
 
 MeshFormat ReplayController::GetPostVSData(uint32_t instID, uint32_t viewID, MeshDataStage stage)
@@ -1056,16 +1138,8 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
       uint32_t xoffs = gridx * sliceWidth;
 
       for(uint32_t y = 0; y < sliceHeight; y++)
-      {
-        for(uint32_t x = 0; x < sliceWidth; x++)
-        {
-          uint32_t *srcpix = (uint32_t *)&subdata[i][(y * sliceWidth + x) * pixelStride + 0];
-          uint32_t *dstpix =
-              (uint32_t *)&combinedData[((y + yoffs) * td.width + x + xoffs) * pixelStride + 0];
-
-          memcpy(dstpix, srcpix, pixelStride);
-        }
-      }
+        memcpy(&combinedData[((y + yoffs) * td.width + xoffs) * pixelStride],
+               &subdata[i][y * sliceWidth * pixelStride], sliceWidth * pixelStride);
 
       delete[] subdata[i];
     }
@@ -1115,16 +1189,8 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
       uint32_t xoffs = gridx[i] * sliceWidth;
 
       for(uint32_t y = 0; y < sliceHeight; y++)
-      {
-        for(uint32_t x = 0; x < sliceWidth; x++)
-        {
-          uint32_t *srcpix = (uint32_t *)&subdata[i][(y * sliceWidth + x) * pixelStride + 0];
-          uint32_t *dstpix =
-              (uint32_t *)&combinedData[((y + yoffs) * td.width + x + xoffs) * pixelStride + 0];
-
-          memcpy(dstpix, srcpix, pixelStride);
-        }
-      }
+        memcpy(&combinedData[((y + yoffs) * td.width + xoffs) * pixelStride],
+               &subdata[i][y * sliceWidth * pixelStride], sliceWidth * pixelStride);
 
       delete[] subdata[i];
     }
@@ -1143,40 +1209,16 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
      (uint32_t)sd.channelExtract < td.format.compCount)
   {
     uint32_t pixelStride = td.format.compCount * td.format.compByteWidth;
-    uint32_t compWidth = td.format.compByteWidth;
-    uint32_t compCount = td.format.compCount;
 
-    uint32_t val = 0;
-    uint32_t max = ~0U;
+    ForEachRowBatch(td.width, td.height, [&](uint32_t startRow, uint32_t endRow) {
+      byte *pixels = subdata[0] + startRow * td.width * pixelStride;
+      uint32_t numPixels = (endRow - startRow) * td.width;
 
-    for(uint32_t y = 0; y < td.height; y++)
-    {
-      for(uint32_t x = 0; x < td.width; x++)
-      {
-        memcpy(&val, &subdata[0][(y * td.width + x) * pixelStride + sd.channelExtract * compWidth],
-               td.format.compByteWidth);
-
-        switch(compCount)
-        {
-          case 4:
-            memcpy(&subdata[0][(y * td.width + x) * pixelStride + 3 * compWidth], &max,
-                   td.format.compByteWidth);
-          // deliberate fallthrough
-          case 3:
-            memcpy(&subdata[0][(y * td.width + x) * pixelStride + 2 * compWidth], &val,
-                   td.format.compByteWidth);
-          // deliberate fallthrough
-          case 2:
-            memcpy(&subdata[0][(y * td.width + x) * pixelStride + 1 * compWidth], &val,
-                   td.format.compByteWidth);
-          // deliberate fallthrough
-          case 1:
-            memcpy(&subdata[0][(y * td.width + x) * pixelStride + 0 * compWidth], &val,
-                   td.format.compByteWidth);
-            break;
-        }
-      }
-    }
+      if(td.format.compByteWidth == 1)
+        ExtractChannel(pixels, numPixels, td.format.compCount, sd.channelExtract);
+      else
+        ExtractChannel((uint32_t *)pixels, numPixels, td.format.compCount, sd.channelExtract);
+    });
   }
 
   // handle formats that don't support alpha
@@ -1184,46 +1226,55 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
   {
     byte *nonalpha = new byte[td.width * td.height * 3];
 
-    for(uint32_t y = 0; y < td.height; y++)
+    // the background colours are constant, so gamma correct them once up front
+    Vec4f solidCol = Vec4f(sd.alphaCol.x, sd.alphaCol.y, sd.alphaCol.z);
+    Vec4f lightCol = RenderDoc::Inst().LightCheckerboardColor();
+    Vec4f darkCol = RenderDoc::Inst().DarkCheckerboardColor();
+
+    for(Vec4f *col : {&solidCol, &lightCol, &darkCol})
     {
-      for(uint32_t x = 0; x < td.width; x++)
-      {
-        byte r = subdata[0][(y * td.width + x) * 4 + 0];
-        byte g = subdata[0][(y * td.width + x) * 4 + 1];
-        byte b = subdata[0][(y * td.width + x) * 4 + 2];
-        byte a = subdata[0][(y * td.width + x) * 4 + 3];
+      col->x = powf(col->x, 1.0f / 2.2f);
+      col->y = powf(col->y, 1.0f / 2.2f);
+      col->z = powf(col->z, 1.0f / 2.2f);
+    }
 
-        if(sd.alpha != AlphaMapping::Discard)
+    ForEachRowBatch(td.width, td.height, [&](uint32_t startRow, uint32_t endRow) {
+      for(uint32_t y = startRow; y < endRow; y++)
+      {
+        for(uint32_t x = 0; x < td.width; x++)
         {
-          Vec4f col = Vec4f(sd.alphaCol.x, sd.alphaCol.y, sd.alphaCol.z);
-          if(sd.alpha == AlphaMapping::BlendToCheckerboard)
+          byte r = subdata[0][(y * td.width + x) * 4 + 0];
+          byte g = subdata[0][(y * td.width + x) * 4 + 1];
+          byte b = subdata[0][(y * td.width + x) * 4 + 2];
+          byte a = subdata[0][(y * td.width + x) * 4 + 3];
+
+          if(sd.alpha != AlphaMapping::Discard)
           {
-            bool lightSquare = ((x / 64) % 2) == ((y / 64) % 2);
-            col = lightSquare ? RenderDoc::Inst().LightCheckerboardColor()
-                              : RenderDoc::Inst().DarkCheckerboardColor();
+            Vec4f col = solidCol;
+            if(sd.alpha == AlphaMapping::BlendToCheckerboard)
+            {
+              bool lightSquare = ((x / 64) % 2) == ((y / 64) % 2);
+              col = lightSquare ? lightCol : darkCol;
+            }
+
+            FloatVector pixel = FloatVector(float(r) / 255.0f, float(g) / 255.0f,
+                                            float(b) / 255.0f, float(a) / 255.0f);
+
+            pixel.x = pixel.x * pixel.w + col.x * (1.0f - pixel.w);
+            pixel.y = pixel.y * pixel.w + col.y * (1.0f - pixel.w);
+            pixel.z = pixel.z * pixel.w + col.z * (1.0f - pixel.w);
+
+            r = byte(pixel.x * 255.0f);
+            g = byte(pixel.y * 255.0f);
+            b = byte(pixel.z * 255.0f);
           }
 
-          col.x = powf(col.x, 1.0f / 2.2f);
-          col.y = powf(col.y, 1.0f / 2.2f);
-          col.z = powf(col.z, 1.0f / 2.2f);
-
-          FloatVector pixel = FloatVector(float(r) / 255.0f, float(g) / 255.0f, float(b) / 255.0f,
-                                          float(a) / 255.0f);
-
-          pixel.x = pixel.x * pixel.w + col.x * (1.0f - pixel.w);
-          pixel.y = pixel.y * pixel.w + col.y * (1.0f - pixel.w);
-          pixel.z = pixel.z * pixel.w + col.z * (1.0f - pixel.w);
-
-          r = byte(pixel.x * 255.0f);
-          g = byte(pixel.y * 255.0f);
-          b = byte(pixel.z * 255.0f);
+          nonalpha[(y * td.width + x) * 3 + 0] = r;
+          nonalpha[(y * td.width + x) * 3 + 1] = g;
+          nonalpha[(y * td.width + x) * 3 + 2] = b;
         }
-
-        nonalpha[(y * td.width + x) * 3 + 0] = r;
-        nonalpha[(y * td.width + x) * 3 + 1] = g;
-        nonalpha[(y * td.width + x) * 3 + 2] = b;
       }
-    }
+    });
 
     delete[] subdata[0];
 
@@ -1239,22 +1290,21 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
   {
     byte *rg0 = new byte[td.width * td.height * 3];
 
-    for(uint32_t y = 0; y < td.height; y++)
-    {
-      for(uint32_t x = 0; x < td.width; x++)
+    ForEachRowBatch(td.width, td.height, [&](uint32_t startRow, uint32_t endRow) {
+      for(uint32_t p = startRow * td.width; p < endRow * td.width; p++)
       {
-        byte r = subdata[0][(y * td.width + x) * 2 + 0];
-        byte g = subdata[0][(y * td.width + x) * 2 + 1];
+        byte r = subdata[0][p * 2 + 0];
+        byte g = subdata[0][p * 2 + 1];
 
-        rg0[(y * td.width + x) * 3 + 0] = r;
-        rg0[(y * td.width + x) * 3 + 1] = g;
-        rg0[(y * td.width + x) * 3 + 2] = 0;
+        rg0[p * 3 + 0] = r;
+        rg0[p * 3 + 1] = g;
+        rg0[p * 3 + 2] = 0;
 
         // if we're greyscaling the image, then keep the greyscale here.
         if(sd.channelExtract >= 0)
-          rg0[(y * td.width + x) * 3 + 2] = r;
+          rg0[p * 3 + 2] = r;
       }
-    }
+    });
 
     delete[] subdata[0];
 
@@ -1366,8 +1416,6 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
         abgr[3] = new float[td.width * td.height];
       }
 
-      byte *srcData = subdata[0];
-
       ResourceFormat saveFmt = td.format;
       if(saveFmt.compType == CompType::Typeless)
         saveFmt.compType = sd.typeHint;
@@ -1376,108 +1424,71 @@ bool ReplayController::SaveTexture(const TextureSave &saveData, const char *path
 
       uint32_t pixStride = saveFmt.compCount * saveFmt.compByteWidth;
 
-      // 24-bit depth still has a stride of 4 bytes.
-      if(saveFmt.compType == CompType::Depth && pixStride == 3)
+      // 24-bit depth still has a stride of 4 bytes, as do the packed formats
+      if((saveFmt.compType == CompType::Depth && pixStride == 3) || saveFmt.Special())
         pixStride = 4;
 
-      for(uint32_t y = 0; y < td.height; y++)
-      {
-        for(uint32_t x = 0; x < td.width; x++)
-        {
-          float r = 0.0f;
-          float g = 0.0f;
-          float b = 0.0f;
-          float a = 1.0f;
-
-          if(saveFmt.type == ResourceFormatType::R10G10B10A2)
-          {
-            uint32_t *u32 = (uint32_t *)srcData;
+      ForEachRowBatch(td.width, td.height, [&](uint32_t startRow, uint32_t endRow) {
+        std::vector<Vec4f> row(td.width);
 
-            Vec4f vec = ConvertFromR10G10B10A2(*u32);
-
-            r = vec.x;
-            g = vec.y;
-            b = vec.z;
-            a = vec.w;
-
-            srcData += 4;
-          }
-          else if(saveFmt.type == ResourceFormatType::R11G11B10)
-          {
-            uint32_t *u32 = (uint32_t *)srcData;
-
-            Vec3f vec = ConvertFromR11G11B10(*u32);
-
-            r = vec.x;
-            g = vec.y;
-            b = vec.z;
-            a = 1.0f;
-
-            srcData += 4;
-          }
-          else
-          {
-            if(saveFmt.compCount >= 1)
-              r = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 0);
-            if(saveFmt.compCount >= 2)
-              g = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 1);
-            if(saveFmt.compCount >= 3)
-              b = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 2);
-            if(saveFmt.compCount >= 4)
-              a = ConvertComponent(saveFmt, srcData + saveFmt.compByteWidth * 3);
-
-            srcData += pixStride;
-          }
-
-          if(saveFmt.BGRAOrder())
-            std::swap(r, b);
-
-          // HDR can't represent negative values
-          if(sd.destType == FileType::HDR)
-          {
-            r = RDCMAX(r, 0.0f);
-            g = RDCMAX(g, 0.0f);
-            b = RDCMAX(b, 0.0f);
-            a = RDCMAX(a, 0.0f);
-          }
-
-          if(sd.channelExtract == 0)
-          {
-            g = b = r;
-            a = 1.0f;
-          }
-          if(sd.channelExtract == 1)
-          {
-            r = b = g;
-            a = 1.0f;
-          }
-          if(sd.channelExtract == 2)
-          {
-            r = g = b;
-            a = 1.0f;
-          }
-          if(sd.channelExtract == 3)
-          {
-            r = g = b = a;
-            a = 1.0f;
-          }
+        for(uint32_t y = startRow; y < endRow; y++)
+        {
+          ConvertRowToFloat4(saveFmt, subdata[0] + y * td.width * pixStride, td.width, row.data());
 
-          if(fldata)
+          for(uint32_t x = 0; x < td.width; x++)
           {
-            fldata[(y * td.width + x) * 4 + 0] = r;
-            fldata[(y * td.width + x) * 4 + 1] = g;
-            fldata[(y * td.width + x) * 4 + 2] = b;
-            fldata[(y * td.width + x) * 4 + 3] = a;
-          }
-          else
-          {
-            abgr[0][(y * td.width + x)] = a;
-            abgr[1][(y * td.width + x)] = b;
-            abgr[2][(y * td.width + x)] = g;
-            abgr[3][(y * td.width + x)] = r;
+            float r = row[x].x;
+            float g = row[x].y;
+            float b = row[x].z;
+            float a = row[x].w;
+
+            // HDR can't represent negative values
+            if(sd.destType == FileType::HDR)
+            {
+              r = RDCMAX(r, 0.0f);
+              g = RDCMAX(g, 0.0f);
+              b = RDCMAX(b, 0.0f);
+              a = RDCMAX(a, 0.0f);
+            }
+
+            if(sd.channelExtract == 0)
+            {
+              g = b = r;
+              a = 1.0f;
+            }
+            if(sd.channelExtract == 1)
+            {
+              r = b = g;
+              a = 1.0f;
+            }
+            if(sd.channelExtract == 2)
+            {
+              r = g = b;
+              a = 1.0f;
+            }
+            if(sd.channelExtract == 3)
+            {
+              r = g = b = a;
+              a = 1.0f;
+            }
+
+            if(fldata)
+            {
+              fldata[(y * td.width + x) * 4 + 0] = r;
+              fldata[(y * td.width + x) * 4 + 1] = g;
+              fldata[(y * td.width + x) * 4 + 2] = b;
+              fldata[(y * td.width + x) * 4 + 3] = a;
+            }
+            else
+            {
+              abgr[0][(y * td.width + x)] = a;
+              abgr[1][(y * td.width + x)] = b;
+              abgr[2][(y * td.width + x)] = g;
+              abgr[3][(y * td.width + x)] = r;
+            }
           }
         }
-      }
+      });
 
       if(sd.destType == FileType::HDR)
       {
@@ -1585,15 +1596,15 @@ rdcarray<PixelModification> ReplayController::PixelHistory(ResourceId target, ui
   if(id == ResourceId())
     return ret;
 
-  std::vector<EventUsage> usage = m_pDevice->GetUsage(id);
+  CacheUsage(target);
+
+  rdcarray<EventUsage> usage;
+  m_Usage.GetUsage(target, 0, m_EventID, usage);
 
   std::vector<EventUsage> events;
 
   for(size_t i = 0; i < usage.size(); i++)
   {
-    if(usage[i].eventId > m_EventID)
-      continue;
-
     switch(usage[i].usage)
     {
       case ResourceUsage::VertexBuffer:
@@ -195,6 +195,8 @@ public:
   MeshFormat GetPostVSData(uint32_t instID, uint32_t viewID, MeshDataStage stage);
 
   rdcarray<EventUsage> GetUsage(ResourceId id);
+  rdcarray<ResourceEventUsage> GetUsages(const rdcarray<ResourceId> &ids);
+  rdcarray<ResourceEventUsage> GetEventUsage(uint32_t startEventId, uint32_t endEventId);
 
   bytebuf GetBufferData(ResourceId buff, uint64_t offset, uint64_t len);
   bytebuf GetTextureData(ResourceId buff, uint32_t arrayIdx, uint32_t mip);
@@ -222,6 +224,8 @@ private:
 
   void FetchPipelineState(uint32_t eventId);
 
+  void CacheUsage(ResourceId id);
+
   DrawcallDescription *GetDrawcallByEID(uint32_t eventId);
   bool ContainsMarker(const rdcarray<DrawcallDescription> &draws);
   bool PassEquivalent(const DrawcallDescription &a, const DrawcallDescription &b);
@@ -252,6 +256,9 @@ private:
   rdcarray<BufferDescription> m_Buffers;
   rdcarray<TextureDescription> m_Textures;
 
+  ResourceUsageIndex m_Usage;
+  bool m_AllUsageCached = false;
+
   IReplayDriver *m_pDevice;
 
   std::set<ResourceId> m_TargetResources;
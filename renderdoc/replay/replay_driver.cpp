@@ -23,6 +23,8 @@
  ******************************************************************************/
 
 #include "replay_driver.h"
+#include <algorithm>
+#include "3rdparty/zstd/xxhash.h"
 #include "maths/formatpacking.h"
 #include "serialise/serialiser.h"
 
@@ -170,9 +172,23 @@ void PatchLineStripIndexBuffer(const DrawcallDescription *draw, uint8_t *idx8, u
 {
   const uint32_t restart = 0xffffffff;
 
-#define IDX_VALUE(offs)        \
-  (idx16 ? idx16[index + offs] \
-         : (idx32 ? idx32[index + offs] : (idx8 ? idx8[index + offs] : index + offs)))
+  // widen once up front rather than checking the index size for every value read
+  std::vector<uint32_t> indices(draw->numIndices);
+
+  if(idx16)
+    WidenIndices((const byte *)idx16, 2, draw->numIndices, indices.data());
+  else if(idx32)
+    WidenIndices((const byte *)idx32, 4, draw->numIndices, indices.data());
+  else if(idx8)
+    WidenIndices(idx8, 1, draw->numIndices, indices.data());
+  else
+    for(uint32_t i = 0; i < draw->numIndices; i++)
+      indices[i] = i;
+
+  // every topology emits at most 5 indices per input index
+  patchedIndices.reserve(patchedIndices.size() + size_t(draw->numIndices) * 5);
+
+#define IDX_VALUE(offs) indices[index + offs]
 
   switch(draw->topology)
   {
@@ -259,6 +275,197 @@ void PatchLineStripIndexBuffer(const DrawcallDescription *draw, uint8_t *idx8, u
 #undef IDX_VALUE
 }
 
+void WidenIndices(const byte *data, uint32_t indexByteWidth, uint32_t count, uint32_t *out)
+{
+  // keep each width as a separate tight loop so that the compiler vectorises it
+  if(indexByteWidth == 1)
+  {
+    for(uint32_t i = 0; i < count; i++)
+      out[i] = data[i];
+  }
+  else if(indexByteWidth == 2)
+  {
+    const uint16_t *data16 = (const uint16_t *)data;
+    for(uint32_t i = 0; i < count; i++)
+      out[i] = data16[i];
+  }
+  else
+  {
+    memcpy(out, data, count * sizeof(uint32_t));
+  }
+}
+
+static void RadixSortIndices(std::vector<uint32_t> &indices)
+{
+  const uint32_t digitBits = 11;
+  const uint32_t digitMask = (1U << digitBits) - 1;
+
+  const size_t count = indices.size();
+  std::vector<uint32_t> scratch(count);
+
+  uint32_t *src = indices.data();
+  uint32_t *dst = scratch.data();
+
+  for(uint32_t shift = 0; shift < 32; shift += digitBits)
+  {
+    uint32_t offsets[digitMask + 1] = {};
+    for(size_t i = 0; i < count; i++)
+      offsets[(src[i] >> shift) & digitMask]++;
+
+    // nothing would move if every index has the same digit, which is common for the top digit
+    if(offsets[(src[0] >> shift) & digitMask] == count)
+      continue;
+
+    uint32_t offs = 0;
+    for(uint32_t d = 0; d <= digitMask; d++)
+    {
+      uint32_t num = offsets[d];
+      offsets[d] = offs;
+      offs += num;
+    }
+
+    for(size_t i = 0; i < count; i++)
+      dst[offsets[(src[i] >> shift) & digitMask]++] = src[i];
+
+    std::swap(src, dst);
+  }
+
+  if(src != indices.data())
+    indices.swap(scratch);
+}
+
+void SortUniqueIndices(std::vector<uint32_t> &indices)
+{
+  if(indices.empty())
+    return;
+
+  uint32_t minIndex = indices[0], maxIndex = indices[0];
+  for(uint32_t idx : indices)
+  {
+    minIndex = RDCMIN(minIndex, idx);
+    maxIndex = RDCMAX(maxIndex, idx);
+  }
+
+  uint64_t range = uint64_t(maxIndex - minIndex) + 1;
+
+  // when the indices are dense enough that a bitmap is no bigger than the list itself, mark each
+  // one and read them back out in order.
+  if(range <= uint64_t(indices.size()) * 32)
+  {
+    std::vector<uint64_t> bitmap(size_t((range + 63) / 64), 0);
+    for(uint32_t idx : indices)
+      bitmap[(idx - minIndex) / 64] |= 1ULL << ((idx - minIndex) % 64);
+
+    indices.clear();
+
+    for(size_t w = 0; w < bitmap.size(); w++)
+    {
+      uint64_t word = bitmap[w];
+      for(uint32_t b = 0; word; b++, word >>= 1)
+      {
+        if(word & 1)
+          indices.push_back(minIndex + uint32_t(w * 64 + b));
+      }
+    }
+
+    return;
+  }
+
+  if(indices.size() < 256)
+    std::sort(indices.begin(), indices.end());
+  else
+    RadixSortIndices(indices);
+
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+}
+
+static inline uint32_t ApplyBaseVertex(uint32_t idx, int32_t baseVertex)
+{
+  // clamp to 0, don't allow the index to become negative
+  if(baseVertex < 0)
+    return idx < uint32_t(-baseVertex) ? 0 : idx - uint32_t(-baseVertex);
+
+  return idx + uint32_t(baseVertex);
+}
+
+void GetUniqueIndices(const byte *data, uint32_t indexByteWidth, uint32_t count,
+                      int32_t baseVertex, uint32_t maxIndex, std::vector<uint32_t> &uniqueIndices)
+{
+  uniqueIndices.resize(count);
+  WidenIndices(data, indexByteWidth, count, uniqueIndices.data());
+
+  if(baseVertex != 0 || maxIndex != ~0U)
+  {
+    for(uint32_t &idx : uniqueIndices)
+      idx = RDCMIN(maxIndex, ApplyBaseVertex(idx, baseVertex));
+  }
+
+  SortUniqueIndices(uniqueIndices);
+}
+
+// looks up an index's position in a sorted unique list. A dense table covers the start of the
+// list, sized to not be much bigger than the list itself. Anything past it is binary searched -
+// indices can have sparse outliers or be invalid like 0xcccccccc, and we don't want a table with
+// billions of entries.
+struct UniqueIndexLookup
+{
+  UniqueIndexLookup(const std::vector<uint32_t> &uniqueIndices) : unique(uniqueIndices)
+  {
+    if(unique.empty())
+      return;
+
+    base = unique.front();
+
+    uint64_t range = uint64_t(unique.back() - base) + 1;
+    dense.resize(size_t(RDCMIN(range, uint64_t(unique.size()) * 4)), 0);
+
+    for(size_t i = 0; i < unique.size() && unique[i] - base < dense.size(); i++)
+      dense[unique[i] - base] = uint32_t(i);
+  }
+
+  uint32_t operator()(uint32_t idx) const
+  {
+    // indices below the base wrap around and are searched, and won't be found
+    if(idx - base < dense.size())
+      return dense[idx - base];
+
+    auto it = std::lower_bound(unique.begin(), unique.end(), idx);
+    return it != unique.end() && *it == idx ? uint32_t(it - unique.begin()) : 0;
+  }
+
+  const std::vector<uint32_t> &unique;
+  uint32_t base = 0;
+  std::vector<uint32_t> dense;
+};
+
+template <typename IndexType>
+static void RemapIndices(IndexType *idx, uint32_t count, const UniqueIndexLookup &lookup,
+                         int32_t baseVertex, IndexType restart)
+{
+  for(uint32_t i = 0; i < count; i++)
+  {
+    // preserve primitive restart indices
+    if(restart && idx[i] == restart)
+      continue;
+
+    idx[i] = IndexType(lookup(ApplyBaseVertex(idx[i], baseVertex)));
+  }
+}
+
+void RemapIndices(byte *data, uint32_t indexByteWidth, uint32_t count,
+                  const std::vector<uint32_t> &uniqueIndices, int32_t baseVertex,
+                  uint32_t restartIndex)
+{
+  UniqueIndexLookup lookup(uniqueIndices);
+
+  if(indexByteWidth == 1)
+    RemapIndices(data, count, lookup, baseVertex, uint8_t(restartIndex & 0xff));
+  else if(indexByteWidth == 2)
+    RemapIndices((uint16_t *)data, count, lookup, baseVertex, uint16_t(restartIndex & 0xffff));
+  else
+    RemapIndices((uint32_t *)data, count, lookup, baseVertex, restartIndex);
+}
+
 void StandardFillCBufferVariable(uint32_t dataOffset, const bytebuf &data, ShaderVariable &outvar,
                                  uint32_t matStride)
 {
@@ -596,6 +803,266 @@ FloatVector HighlightCache::InterpretVertex(const byte *data, uint32_t vert,
   return ret;
 }
 
+void ResourceUsageIndex::Add(ResourceId id, const std::vector<EventUsage> &usage)
+{
+  if(Contains(id))
+    return;
+
+  // drivers record usage in event order, but sort to be sure. Uses within one event keep their
+  // recorded order.
+  std::vector<uint32_t> order;
+  order.reserve(usage.size());
+  for(uint32_t i = 0; i < (uint32_t)usage.size(); i++)
+    order.push_back(i);
+
+  std::stable_sort(order.begin(), order.end(), [&usage](uint32_t a, uint32_t b) {
+    return usage[a].eventId < usage[b].eventId;
+  });
+
+  uint32_t begin = (uint32_t)m_EventIDs.size();
+
+  for(uint32_t i : order)
+  {
+    m_Resources.push_back(id);
+    m_EventIDs.push_back(usage[i].eventId);
+    m_Usages.push_back(usage[i].usage);
+    m_Views.push_back(usage[i].view);
+  }
+
+  m_Ranges[id] = make_rdcpair(begin, (uint32_t)m_EventIDs.size());
+
+  if(!usage.empty())
+    m_ByEventDirty = true;
+}
+
+void ResourceUsageIndex::Clear()
+{
+  m_Resources.clear();
+  m_EventIDs.clear();
+  m_Usages.clear();
+  m_Views.clear();
+  m_Ranges.clear();
+  m_ByEvent.clear();
+  m_ByEventDirty = false;
+}
+
+rdcpair<uint32_t, uint32_t> ResourceUsageIndex::FindRange(ResourceId id, uint32_t startEventId,
+                                                          uint32_t endEventId) const
+{
+  auto it = m_Ranges.find(id);
+  if(it == m_Ranges.end() || startEventId > endEventId)
+    return make_rdcpair(0U, 0U);
+
+  const uint32_t *eids = m_EventIDs.data();
+
+  uint32_t begin =
+      uint32_t(std::lower_bound(eids + it->second.first, eids + it->second.second, startEventId) -
+               eids);
+  uint32_t end =
+      uint32_t(std::upper_bound(eids + begin, eids + it->second.second, endEventId) - eids);
+
+  return make_rdcpair(begin, end);
+}
+
+void ResourceUsageIndex::GetUsage(ResourceId id, uint32_t startEventId, uint32_t endEventId,
+                                  rdcarray<EventUsage> &out) const
+{
+  rdcpair<uint32_t, uint32_t> range = FindRange(id, startEventId, endEventId);
+
+  out.reserve(out.size() + range.second - range.first);
+  for(uint32_t i = range.first; i < range.second; i++)
+    out.push_back(EventUsage(m_EventIDs[i], m_Usages[i], m_Views[i]));
+}
+
+void ResourceUsageIndex::GetUsage(ResourceId id, uint32_t startEventId, uint32_t endEventId,
+                                  rdcarray<ResourceEventUsage> &out) const
+{
+  rdcpair<uint32_t, uint32_t> range = FindRange(id, startEventId, endEventId);
+
+  out.reserve(out.size() + range.second - range.first);
+  for(uint32_t i = range.first; i < range.second; i++)
+    out.push_back(ResourceEventUsage(id, EventUsage(m_EventIDs[i], m_Usages[i], m_Views[i])));
+}
+
+void ResourceUsageIndex::GetEventUsage(uint32_t startEventId, uint32_t endEventId,
+                                       rdcarray<ResourceEventUsage> &out)
+{
+  if(m_ByEventDirty)
+  {
+    m_ByEvent.resize(m_EventIDs.size());
+    for(uint32_t i = 0; i < (uint32_t)m_ByEvent.size(); i++)
+      m_ByEvent[i] = i;
+
+    const std::vector<uint32_t> &eids = m_EventIDs;
+    std::stable_sort(m_ByEvent.begin(), m_ByEvent.end(),
+                     [&eids](uint32_t a, uint32_t b) { return eids[a] < eids[b]; });
+
+    m_ByEventDirty = false;
+  }
+
+  if(startEventId > endEventId)
+    return;
+
+  const std::vector<uint32_t> &eids = m_EventIDs;
+
+  auto begin = std::lower_bound(m_ByEvent.begin(), m_ByEvent.end(), startEventId,
+                                [&eids](uint32_t idx, uint32_t e) { return eids[idx] < e; });
+  auto end = std::upper_bound(begin, m_ByEvent.end(), endEventId,
+                              [&eids](uint32_t e, uint32_t idx) { return e < eids[idx]; });
+
+  out.reserve(out.size() + (end - begin));
+  for(auto it = begin; it != end; ++it)
+    out.push_back(ResourceEventUsage(
+        m_Resources[*it], EventUsage(m_EventIDs[*it], m_Usages[*it], m_Views[*it])));
+}
+
+struct DiskCacheHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint64_t length;
+  uint64_t checksum;
+};
+
+static const uint32_t DiskCacheMagic = MAKE_FOURCC('R', 'D', 'D', 'C');
+
+ReplayDiskCache::ReplayDiskCache(const char *folder, uint32_t version, uint64_t maxBytes)
+    : m_Folder(FileIO::GetAppFolderFilename(folder)),
+      m_Version(version),
+      m_MaxBytes(maxBytes),
+      // check the size on the first store, in case a previous session left it over the limit
+      m_UncheckedBytes(maxBytes)
+{
+}
+
+std::string ReplayDiskCache::GetFilename(uint64_t key) const
+{
+  return m_Folder + StringFormat::Fmt("/%016llx.bin", key);
+}
+
+bool ReplayDiskCache::Load(uint64_t key, bytebuf &data) const
+{
+  if(m_MaxBytes == 0)
+    return false;
+
+  std::string filename = GetFilename(key);
+
+  FILE *f = FileIO::fopen(filename.c_str(), "rb");
+
+  if(!f)
+    return false;
+
+  DiskCacheHeader header = {};
+
+  bool ret = FileIO::fread(&header, 1, sizeof(header), f) == sizeof(header) &&
+             header.magic == DiskCacheMagic && header.version == m_Version && header.key == key;
+
+  if(ret)
+  {
+    FileIO::fseek64(f, 0, SEEK_END);
+    ret = FileIO::ftell64(f) == sizeof(header) + header.length;
+    FileIO::fseek64(f, sizeof(header), SEEK_SET);
+  }
+
+  if(ret)
+  {
+    data.resize((size_t)header.length);
+    ret = FileIO::fread(data.data(), 1, data.size(), f) == data.size() &&
+          XXH64(data.data(), data.size(), 0) == header.checksum;
+  }
+
+  FileIO::fclose(f);
+
+  if(!ret)
+  {
+    RDCWARN("Discarding invalid or out of date cache entry %s", filename.c_str());
+    FileIO::Delete(filename.c_str());
+    data.clear();
+  }
+
+  return ret;
+}
+
+void ReplayDiskCache::Store(uint64_t key, const bytebuf &data)
+{
+  // don't let a single huge entry flush out everything else
+  if(m_MaxBytes == 0 || data.size() > m_MaxBytes / 4)
+    return;
+
+  std::string filename = GetFilename(key);
+
+  // write to a temporary file and move it into place, so other processes never see partial data
+  std::string tmpname =
+      StringFormat::Fmt("%s.%u.tmp", filename.c_str(), Process::GetCurrentPID());
+
+  FileIO::CreateParentDirectory(filename);
+
+  FILE *f = FileIO::fopen(tmpname.c_str(), "wb");
+
+  if(!f)
+  {
+    RDCWARN("Couldn't open %s to write cache entry: %s", tmpname.c_str(),
+            FileIO::ErrorString().c_str());
+    return;
+  }
+
+  DiskCacheHeader header = {
+      DiskCacheMagic, m_Version, key, data.size(), XXH64(data.data(), data.size(), 0),
+  };
+
+  bool success = FileIO::fwrite(&header, 1, sizeof(header), f) == sizeof(header) &&
+                 FileIO::fwrite(data.data(), 1, data.size(), f) == data.size();
+
+  FileIO::fclose(f);
+
+  if(!success || !FileIO::Move(tmpname.c_str(), filename.c_str(), true))
+  {
+    RDCWARN("Couldn't write cache entry %s", filename.c_str());
+    FileIO::Delete(tmpname.c_str());
+    return;
+  }
+
+  m_UncheckedBytes += sizeof(header) + data.size();
+
+  if(m_UncheckedBytes >= m_MaxBytes / 8)
+    Trim();
+}
+
+void ReplayDiskCache::Trim()
+{
+  m_UncheckedBytes = 0;
+
+  std::vector<PathEntry> files = FileIO::GetFilesInDirectory(m_Folder.c_str());
+
+  const PathProperty skipFlags = PathProperty::Directory | PathProperty::ErrorUnknown |
+                                 PathProperty::ErrorAccessDenied | PathProperty::ErrorInvalidPath;
+
+  uint64_t total = 0;
+  for(const PathEntry &file : files)
+    if(!(file.flags & skipFlags))
+      total += file.size;
+
+  if(total <= m_MaxBytes)
+    return;
+
+  // delete the oldest entries until we're well under the limit, so we don't trim on every store
+  std::sort(files.begin(), files.end(),
+            [](const PathEntry &a, const PathEntry &b) { return a.lastmod < b.lastmod; });
+
+  for(const PathEntry &file : files)
+  {
+    if(total <= m_MaxBytes / 4 * 3)
+      break;
+
+    if(file.flags & skipFlags)
+      continue;
+
+    FileIO::Delete((m_Folder + "/" + file.filename.c_str()).c_str());
+    total -= file.size;
+  }
+}
+
 uint64_t inthash(uint64_t val, uint64_t seed)
 {
   return (seed << 5) + seed + val; /* hash * 33 + c */
@@ -1061,3 +1528,243 @@ const Vec4f colorRamp[22] = {
     Vec4f(1.000000f, 0.376471f, 0.752941f, 1.0f), Vec4f(1.000000f, 0.627451f, 1.000000f, 1.0f),
     Vec4f(1.000000f, 0.878431f, 1.000000f, 1.0f), Vec4f(1.000000f, 1.000000f, 1.000000f, 1.0f),
 };
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include <map>
+#include <set>
+#include "3rdparty/catch/catch.hpp"
+#include "common/timing.h"
+#include "core/resource_manager.h"
+
+TEST_CASE("Test resource usage index", "[replay]")
+{
+  ResourceUsageIndex index;
+
+  ResourceId a = ResourceIDGen::GetNewUniqueID();
+  ResourceId b = ResourceIDGen::GetNewUniqueID();
+  ResourceId c = ResourceIDGen::GetNewUniqueID();
+
+  index.Add(a, {EventUsage(10, ResourceUsage::VS_Resource), EventUsage(30, ResourceUsage::CopySrc),
+                EventUsage(20, ResourceUsage::ColorTarget)});
+  index.Add(b, {EventUsage(20, ResourceUsage::CopyDst), EventUsage(40, ResourceUsage::PS_Resource)});
+  index.Add(c, {});
+
+  CHECK(index.Contains(a));
+  CHECK(index.Contains(c));
+  CHECK_FALSE(index.Contains(ResourceIDGen::GetNewUniqueID()));
+
+  SECTION("Resource queries")
+  {
+    rdcarray<EventUsage> usage;
+    index.GetUsage(a, 0, ~0U, usage);
+
+    REQUIRE(usage.size() == 3);
+    CHECK(usage[0].eventId == 10);
+    CHECK(usage[1].eventId == 20);
+    CHECK(usage[1].usage == ResourceUsage::ColorTarget);
+    CHECK(usage[2].eventId == 30);
+
+    usage.clear();
+    index.GetUsage(a, 15, 30, usage);
+
+    REQUIRE(usage.size() == 2);
+    CHECK(usage[0].eventId == 20);
+    CHECK(usage[1].eventId == 30);
+
+    usage.clear();
+    index.GetUsage(c, 0, ~0U, usage);
+    CHECK(usage.empty());
+  };
+
+  SECTION("Event queries")
+  {
+    rdcarray<ResourceEventUsage> usage;
+    index.GetEventUsage(20, 20, usage);
+
+    REQUIRE(usage.size() == 2);
+    CHECK(usage[0].resourceId == a);
+    CHECK(usage[0].usage == ResourceUsage::ColorTarget);
+    CHECK(usage[1].resourceId == b);
+    CHECK(usage[1].usage == ResourceUsage::CopyDst);
+
+    usage.clear();
+    index.GetEventUsage(25, 100, usage);
+
+    REQUIRE(usage.size() == 2);
+    CHECK(usage[0].eventId == 30);
+    CHECK(usage[1].eventId == 40);
+
+    // adding a resource later is picked up by the next query
+    index.Add(c, {EventUsage(35, ResourceUsage::Indirect)});
+    ResourceId d = ResourceIDGen::GetNewUniqueID();
+    index.Add(d, {EventUsage(35, ResourceUsage::Indirect)});
+
+    usage.clear();
+    index.GetEventUsage(25, 100, usage);
+
+    REQUIRE(usage.size() == 3);
+    CHECK(usage[1].resourceId == d);
+  };
+}
+
+TEST_CASE("Test replay disk cache", "[replay]")
+{
+  bytebuf data;
+  for(int i = 0; i < 1000; i++)
+    data.push_back(byte(i * 7));
+
+  ReplayDiskCache cache("unittest_disk_cache", 1, 1024 * 1024);
+
+  bytebuf loaded;
+  CHECK_FALSE(cache.Load(0x1234, loaded));
+
+  cache.Store(0x1234, data);
+
+  CHECK(cache.Load(0x1234, loaded));
+  CHECK(loaded == data);
+
+  // a different key or version misses
+  CHECK_FALSE(cache.Load(0x1235, loaded));
+
+  ReplayDiskCache newVersion("unittest_disk_cache", 2, 1024 * 1024);
+  CHECK_FALSE(newVersion.Load(0x1234, loaded));
+
+  // the out of date entry was deleted
+  CHECK_FALSE(cache.Load(0x1234, loaded));
+
+  // a disabled cache never stores anything
+  ReplayDiskCache disabled("unittest_disk_cache", 1, 0);
+  disabled.Store(0x1234, data);
+  CHECK_FALSE(cache.Load(0x1234, loaded));
+}
+
+static uint32_t TestRandom(uint32_t &state)
+{
+  state = state * 1664525U + 1013904223U;
+  return state >> 8;
+}
+
+TEST_CASE("Test index processing kernels", "[replay]")
+{
+  uint32_t seed = 1234;
+
+  SECTION("Widening")
+  {
+    byte idx8[] = {0, 1, 200, 255};
+    uint16_t idx16[] = {0, 1, 60000, 65535};
+    uint32_t out[4] = {};
+
+    WidenIndices(idx8, 1, 4, out);
+    CHECK(out[2] == 200);
+    CHECK(out[3] == 255);
+
+    WidenIndices((const byte *)idx16, 2, 4, out);
+    CHECK(out[2] == 60000);
+    CHECK(out[3] == 65535);
+  };
+
+  SECTION("Sort and unique")
+  {
+    // dense values take the bitmap path, small and large sparse ones use a comparison or radix sort
+    uint32_t counts[] = {1000, 100, 100000};
+    uint32_t ranges[] = {500, 0x7fffffff, 0xffffff};
+
+    for(size_t t = 0; t < ARRAY_COUNT(counts); t++)
+    {
+      std::vector<uint32_t> indices;
+      std::set<uint32_t> expected;
+      for(uint32_t i = 0; i < counts[t]; i++)
+      {
+        indices.push_back(TestRandom(seed) % ranges[t] + 17);
+        expected.insert(indices.back());
+      }
+
+      SortUniqueIndices(indices);
+
+      CHECK(indices == std::vector<uint32_t>(expected.begin(), expected.end()));
+    }
+  };
+
+  SECTION("Unique gather and remap")
+  {
+    uint16_t idx16[] = {10, 12, 0xffff, 11, 3, 12, 10};
+    std::vector<uint32_t> unique;
+
+    // baseVertex of -5 clamps 3 to 0, and maxIndex clamps the restart index to 100
+    GetUniqueIndices((const byte *)idx16, 2, ARRAY_COUNT(idx16), -5, 100, unique);
+
+    CHECK(unique == std::vector<uint32_t>({0, 5, 6, 7, 100}));
+
+    RemapIndices((byte *)idx16, 2, ARRAY_COUNT(idx16), unique, -5, ~0U);
+
+    CHECK(idx16[0] == 1);
+    CHECK(idx16[1] == 3);
+    CHECK(idx16[2] == 0xffff);
+    CHECK(idx16[3] == 2);
+    CHECK(idx16[4] == 0);
+    CHECK(idx16[5] == 3);
+    CHECK(idx16[6] == 1);
+
+    // sparse values use a search instead of a table, and anything missing maps to 0
+    uint32_t idx32[] = {0xcccccccc, 7, 0x10000000, 12345};
+    unique = {7, 12345, 0xcccccccc};
+
+    RemapIndices((byte *)idx32, 4, ARRAY_COUNT(idx32), unique, 0, 0);
+
+    CHECK(idx32[0] == 2);
+    CHECK(idx32[1] == 0);
+    CHECK(idx32[2] == 0);
+    CHECK(idx32[3] == 1);
+  };
+}
+
+// not run by default, pass "[benchmark]" to run
+TEST_CASE("Benchmark index processing kernels", "[.][benchmark]")
+{
+  uint32_t seed = 1234;
+
+  // a large mesh with each vertex referenced by several triangles, and some sparse outliers
+  const uint32_t numIndices = 12 * 1000 * 1000;
+  std::vector<uint32_t> source(numIndices);
+  for(uint32_t i = 0; i < numIndices; i++)
+    source[i] = (i % 97 == 0) ? TestRandom(seed) : (i / 6 + TestRandom(seed) % 64);
+
+  std::vector<uint32_t> indices;
+
+  PerformanceTimer timer;
+  GetUniqueIndices((const byte *)source.data(), 4, numIndices, 0, ~0U, indices);
+  double uniqueTime = timer.GetMilliseconds();
+
+  std::vector<uint32_t> remapped = source;
+  timer.Restart();
+  RemapIndices((byte *)remapped.data(), 4, numIndices, indices, 0, ~0U);
+  double remapTime = timer.GetMilliseconds();
+
+  WARN(numIndices << " indices, " << indices.size() << " unique: gather " << uniqueTime
+                  << "ms, remap " << remapTime << "ms");
+
+  // the previous sorted insert + std::map approach, on a slice so it finishes in reasonable time
+  const uint32_t sliceSize = numIndices / 50;
+  std::vector<uint32_t> slow;
+
+  timer.Restart();
+  for(uint32_t i = 0; i < sliceSize; i++)
+  {
+    auto it = std::lower_bound(slow.begin(), slow.end(), source[i]);
+    if(it == slow.end() || *it != source[i])
+      slow.insert(it, source[i]);
+  }
+  std::map<uint32_t, size_t> indexRemap;
+  for(size_t i = 0; i < slow.size(); i++)
+    indexRemap[slow[i]] = i;
+  for(uint32_t i = 0; i < sliceSize; i++)
+    remapped[i] = uint32_t(indexRemap[source[i]]);
+  double slowTime = timer.GetMilliseconds();
+
+  WARN("previous approach on " << sliceSize << " indices: " << slowTime << "ms");
+
+  CHECK(std::is_sorted(indices.begin(), indices.end()));
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
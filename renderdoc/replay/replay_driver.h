@@ -241,6 +241,23 @@ void SetupDrawcallPointers(std::vector<DrawcallDescription *> &drawcallTable,
 void PatchLineStripIndexBuffer(const DrawcallDescription *draw, uint8_t *idx8, uint16_t *idx16,
                                uint32_t *idx32, std::vector<uint32_t> &patchedIndices);
 
+// index buffer processing for post-transform fetch. Index buffers are 1, 2 or 4 bytes per index.
+
+// widens indices to 32-bit
+void WidenIndices(const byte *data, uint32_t indexByteWidth, uint32_t count, uint32_t *out);
+// sorts and removes duplicates, using a bitmap for dense values or a radix sort otherwise
+void SortUniqueIndices(std::vector<uint32_t> &indices);
+// gathers the sorted unique indices referenced by an index buffer. baseVertex is applied first
+// (clamping at 0) and then each index is clamped to maxIndex.
+void GetUniqueIndices(const byte *data, uint32_t indexByteWidth, uint32_t count,
+                      int32_t baseVertex, uint32_t maxIndex, std::vector<uint32_t> &uniqueIndices);
+// rewrites an index buffer in place so that each index, after applying baseVertex, points to its
+// position in the sorted unique list. Indices not in the list become 0. Restart indices are left
+// untouched, unless restartIndex truncated to the index width is 0 in which case there are none.
+void RemapIndices(byte *data, uint32_t indexByteWidth, uint32_t count,
+                  const std::vector<uint32_t> &uniqueIndices, int32_t baseVertex,
+                  uint32_t restartIndex);
+
 uint64_t CalcMeshOutputSize(uint64_t curSize, uint64_t requiredOutput);
 
 void StandardFillCBufferVariable(uint32_t dataOffset, const bytebuf &data, ShaderVariable &outvar,
@@ -276,4 +293,80 @@ struct HighlightCache
                               const byte *end, bool useidx, bool &valid);
 };
 
+// column-wise store of resource usage, filled in a resource at a time and kept grouped by resource
+// and sorted by event, with a secondary ordering by event to find what a range of events touched.
+struct ResourceUsageIndex
+{
+  bool Contains(ResourceId id) const { return m_Ranges.find(id) != m_Ranges.end(); }
+  // adds the usage for a resource that isn't in the index yet
+  void Add(ResourceId id, const std::vector<EventUsage> &usage);
+  void Clear();
+
+  // appends the uses of a resource in [startEventId, endEventId] to the output, in event order
+  void GetUsage(ResourceId id, uint32_t startEventId, uint32_t endEventId,
+                rdcarray<EventUsage> &out) const;
+  void GetUsage(ResourceId id, uint32_t startEventId, uint32_t endEventId,
+                rdcarray<ResourceEventUsage> &out) const;
+  // appends the uses of every resource in [startEventId, endEventId] to the output, in event order
+  void GetEventUsage(uint32_t startEventId, uint32_t endEventId,
+                     rdcarray<ResourceEventUsage> &out);
+
+private:
+  rdcpair<uint32_t, uint32_t> FindRange(ResourceId id, uint32_t startEventId,
+                                        uint32_t endEventId) const;
+
+  std::vector<ResourceId> m_Resources;
+  std::vector<uint32_t> m_EventIDs;
+  std::vector<ResourceUsage> m_Usages;
+  std::vector<ResourceId> m_Views;
+
+  // the [begin, end) entries for each resource
+  std::map<ResourceId, rdcpair<uint32_t, uint32_t>> m_Ranges;
+
+  // entry indices sorted by event, rebuilt on the next event query after anything is added
+  std::vector<uint32_t> m_ByEvent;
+  bool m_ByEventDirty = false;
+};
+
+// bounded cache of blobs on disk, keyed by a hash of whatever was used to produce them. Each entry
+// is a file in a folder under the app folder, so entries live between sessions and are shared by
+// replay processes. When the folder grows past the size limit the oldest entries are deleted.
+class ReplayDiskCache
+{
+public:
+  // entries written with a different version are ignored. A maximum size of 0 disables the cache
+  ReplayDiskCache(const char *folder, uint32_t version, uint64_t maxBytes);
+
+  bool IsEnabled() const { return m_MaxBytes > 0; }
+  bool Load(uint64_t key, bytebuf &data) const;
+  void Store(uint64_t key, const bytebuf &data);
+
+private:
+  std::string GetFilename(uint64_t key) const;
+  void Trim();
+
+  std::string m_Folder;
+  uint32_t m_Version;
+  uint64_t m_MaxBytes;
+
+  // bytes written since we last checked how big the folder is
+  uint64_t m_UncheckedBytes;
+};
+
+// CPU equivalents of IReplayDriver::GetMinMax and GetHistogram, working on texture data as
+// returned by GetTextureData for the given slice and mip. These don't need a GPU, so can be used on
+// remote or headless replays, or when the texture data is already on hand.
+bool CalcTextureMinMax(const TextureDescription &tex, uint32_t sliceFace, uint32_t mip,
+                       CompType typeHint, const bytebuf &data, float *minval, float *maxval);
+bool CalcTextureHistogram(const TextureDescription &tex, uint32_t sliceFace, uint32_t mip,
+                          CompType typeHint, const bytebuf &data, float minval, float maxval,
+                          const bool channels[4], std::vector<uint32_t> &histogram);
+
+// as above, but fetching the texture data from the driver first
+bool CalcTextureMinMax(IRemoteDriver *driver, ResourceId texid, uint32_t sliceFace, uint32_t mip,
+                       uint32_t sample, CompType typeHint, float *minval, float *maxval);
+bool CalcTextureHistogram(IRemoteDriver *driver, ResourceId texid, uint32_t sliceFace,
+                          uint32_t mip, uint32_t sample, CompType typeHint, float minval,
+                          float maxval, const bool channels[4], std::vector<uint32_t> &histogram);
+
 extern const Vec4f colorRamp[22];
\ No newline at end of file
@@ -0,0 +1,974 @@
+/******************************************************************************
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017-2019 Baldur Karlsson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ ******************************************************************************/
+
+#include <limits>
+#include <type_traits>
+#include "common/threading.h"
+#include "maths/formatpacking.h"
+#include "replay_driver.h"
+
+// CPU implementations of GetMinMax and GetHistogram, for when there's no GPU to run the usual
+// compute shaders on. They work on the bytes returned by GetTextureData. Each row of texels is
+// decoded to float4 (or uint4/int4 for integer formats) with a loop specialised for the format,
+// then the rows are reduced in parallel.
+//
+// Results match the GPU implementations: integer formats return their min/max as raw bits in the
+// float array (as in PixelValue), depth/stencil formats return depth in red and stencil / 255 in
+// green, and missing channels read as 0 with alpha as 1.
+
+static const int32_t TextureStatsThreads = 4;
+
+// roughly how many texels each parallel job handles
+static const uint32_t TextureStatsTexelsPerJob = 64 * 1024;
+
+static const uint32_t HistogramNumBuckets = 256;
+
+enum class TexelKind
+{
+  Float,
+  UInt,
+  SInt,
+};
+
+static TexelKind GetTexelKind(const ResourceFormat &fmt)
+{
+  if(fmt.type == ResourceFormatType::Regular || fmt.type == ResourceFormatType::R10G10B10A2)
+  {
+    if(fmt.compType == CompType::UInt)
+      return TexelKind::UInt;
+    if(fmt.compType == CompType::SInt)
+      return TexelKind::SInt;
+  }
+
+  return TexelKind::Float;
+}
+
+static uint32_t GetTexelByteSize(const ResourceFormat &fmt)
+{
+  switch(fmt.type)
+  {
+    case ResourceFormatType::Regular:
+      // 24-bit depth is padded to 4 bytes
+      if(fmt.compType == CompType::Depth && fmt.compByteWidth == 3)
+        return 4;
+      return fmt.compCount * fmt.compByteWidth;
+    case ResourceFormatType::R10G10B10A2:
+    case ResourceFormatType::R11G11B10:
+    case ResourceFormatType::R9G9B9E5:
+    case ResourceFormatType::D24S8: return 4;
+    case ResourceFormatType::R5G6B5:
+    case ResourceFormatType::R5G5B5A1:
+    case ResourceFormatType::R4G4B4A4: return 2;
+    case ResourceFormatType::R4G4:
+    case ResourceFormatType::S8: return 1;
+    case ResourceFormatType::D32S8: return 8;
+    default: break;
+  }
+
+  // block compressed, YUV and D16S8 (which has no consistent layout between APIs) aren't supported
+  return 0;
+}
+
+static Vec3f ConvertFromR9G9B9E5(uint32_t data)
+{
+  // the shared exponent has a bias of 15, and the mantissas have no implicit 1
+  float scale = powf(2.0f, float(int32_t(data >> 27) - 15 - 9));
+
+  return Vec3f(float(data & 0x1ff) * scale, float((data >> 9) & 0x1ff) * scale,
+               float((data >> 18) & 0x1ff) * scale);
+}
+
+template <typename T>
+static void DecodeUNormRow(const T *src, uint32_t width, uint32_t compCount, float *dst)
+{
+  // divide rather than multiplying by the reciprocal, to give identical results to ConvertComponent
+  const float maxval = float(T(~T(0)));
+
+  for(uint32_t x = 0; x < width; x++)
+    for(uint32_t c = 0; c < compCount; c++)
+      dst[x * 4 + c] = float(src[x * compCount + c]) / maxval;
+}
+
+template <typename T>
+static void DecodeSNormRow(const T *src, uint32_t width, uint32_t compCount, float *dst)
+{
+  // the most negative value is -1 as well as the next one
+  const float maxval = float((1 << (sizeof(T) * 8 - 1)) - 1);
+
+  for(uint32_t x = 0; x < width; x++)
+    for(uint32_t c = 0; c < compCount; c++)
+      dst[x * 4 + c] = RDCMAX(-1.0f, float(src[x * compCount + c]) / maxval);
+}
+
+template <typename SrcType, typename DstType>
+static void DecodeCastRow(const SrcType *src, uint32_t width, uint32_t compCount, DstType *dst)
+{
+  for(uint32_t x = 0; x < width; x++)
+    for(uint32_t c = 0; c < compCount; c++)
+      dst[x * 4 + c] = DstType(src[x * compCount + c]);
+}
+
+// decodes a row of integer texels into 4 32-bit values each
+template <typename DstType>
+static void DecodeIntRow(const ResourceFormat &fmt, const byte *src, uint32_t width, DstType *dst)
+{
+  const bool sint = std::is_signed<DstType>::value;
+
+  if(fmt.type == ResourceFormatType::R10G10B10A2)
+  {
+    const uint32_t *u32 = (const uint32_t *)src;
+    for(uint32_t x = 0; x < width; x++)
+    {
+      dst[x * 4 + 0] = DstType((u32[x] >> 0) & 0x3ff);
+      dst[x * 4 + 1] = DstType((u32[x] >> 10) & 0x3ff);
+      dst[x * 4 + 2] = DstType((u32[x] >> 20) & 0x3ff);
+      dst[x * 4 + 3] = DstType((u32[x] >> 30) & 0x3);
+    }
+    return;
+  }
+
+  for(uint32_t x = 0; x < width; x++)
+  {
+    dst[x * 4 + 0] = dst[x * 4 + 1] = dst[x * 4 + 2] = 0;
+    dst[x * 4 + 3] = 1;
+  }
+
+  if(fmt.compByteWidth == 1)
+  {
+    if(sint)
+      DecodeCastRow((const int8_t *)src, width, fmt.compCount, dst);
+    else
+      DecodeCastRow((const uint8_t *)src, width, fmt.compCount, dst);
+  }
+  else if(fmt.compByteWidth == 2)
+  {
+    if(sint)
+      DecodeCastRow((const int16_t *)src, width, fmt.compCount, dst);
+    else
+      DecodeCastRow((const uint16_t *)src, width, fmt.compCount, dst);
+  }
+  else if(fmt.compByteWidth == 4)
+  {
+    DecodeCastRow((const DstType *)src, width, fmt.compCount, dst);
+  }
+  else if(fmt.compByteWidth == 8)
+  {
+    // we just downcast, as ConvertComponent does
+    if(sint)
+      DecodeCastRow((const int64_t *)src, width, fmt.compCount, dst);
+    else
+      DecodeCastRow((const uint64_t *)src, width, fmt.compCount, dst);
+  }
+}
+
+void ConvertRowToFloat4(const ResourceFormat &fmt, const byte *src, uint32_t numTexels, Vec4f *dst)
+{
+  const uint16_t *u16 = (const uint16_t *)src;
+  const uint32_t *u32 = (const uint32_t *)src;
+
+  switch(fmt.type)
+  {
+    case ResourceFormatType::R10G10B10A2:
+      if(fmt.compType == CompType::SNorm)
+      {
+        for(uint32_t x = 0; x < numTexels; x++)
+          dst[x] = ConvertFromR10G10B10A2SNorm(u32[x]);
+      }
+      else
+      {
+        for(uint32_t x = 0; x < numTexels; x++)
+          dst[x] = ConvertFromR10G10B10A2(u32[x]);
+      }
+      break;
+    case ResourceFormatType::R11G11B10: ConvertFromR11G11B10(u32, dst, numTexels); break;
+    case ResourceFormatType::R9G9B9E5:
+      for(uint32_t x = 0; x < numTexels; x++)
+      {
+        Vec3f v = ConvertFromR9G9B9E5(u32[x]);
+        dst[x] = Vec4f(v.x, v.y, v.z, 1.0f);
+      }
+      break;
+    case ResourceFormatType::R5G6B5:
+      for(uint32_t x = 0; x < numTexels; x++)
+      {
+        Vec3f v = ConvertFromB5G6R5(u16[x]);
+        dst[x] = Vec4f(v.x, v.y, v.z, 1.0f);
+      }
+      break;
+    case ResourceFormatType::R5G5B5A1:
+      for(uint32_t x = 0; x < numTexels; x++)
+        dst[x] = ConvertFromB5G5R5A1(u16[x]);
+      break;
+    case ResourceFormatType::R4G4B4A4:
+      for(uint32_t x = 0; x < numTexels; x++)
+        dst[x] = ConvertFromB4G4R4A4(u16[x]);
+      break;
+    case ResourceFormatType::R4G4:
+      for(uint32_t x = 0; x < numTexels; x++)
+        dst[x] = Vec4f(float(src[x] & 0xf) / 15.0f, float(src[x] >> 4) / 15.0f, 0.0f, 1.0f);
+      break;
+    case ResourceFormatType::D24S8:
+      for(uint32_t x = 0; x < numTexels; x++)
+        dst[x] = Vec4f(float(u32[x] & 0xffffff) / 16777215.0f, float(u32[x] >> 24) / 255.0f, 0.0f,
+                       1.0f);
+      break;
+    case ResourceFormatType::D32S8:
+      for(uint32_t x = 0; x < numTexels; x++)
+      {
+        float depth;
+        memcpy(&depth, src + x * 8, sizeof(depth));
+        dst[x] = Vec4f(depth, float(src[x * 8 + 4]) / 255.0f, 0.0f, 1.0f);
+      }
+      break;
+    case ResourceFormatType::S8:
+      for(uint32_t x = 0; x < numTexels; x++)
+        dst[x] = Vec4f(0.0f, float(src[x]) / 255.0f, 0.0f, 1.0f);
+      break;
+    case ResourceFormatType::Regular:
+    {
+      float *out = &dst[0].x;
+
+      for(uint32_t x = 0; x < numTexels; x++)
+        dst[x] = Vec4f(0.0f, 0.0f, 0.0f, 1.0f);
+
+      const uint32_t count = fmt.compCount;
+      const uint32_t compWidth = fmt.compByteWidth;
+
+      // typeless data is interpreted the same way as when saving textures
+      ResourceFormat typed = fmt;
+      if(typed.compType == CompType::Typeless)
+        typed.compType = compWidth == 4 ? CompType::Float : CompType::UNorm;
+
+      const CompType compType = typed.compType;
+      const bool isUInt = (compType == CompType::UInt || compType == CompType::UScaled);
+      const bool isSInt = (compType == CompType::SInt || compType == CompType::SScaled);
+
+      if(compWidth == 1 && compType == CompType::UNormSRGB)
+      {
+        for(uint32_t x = 0; x < numTexels; x++)
+          for(uint32_t c = 0; c < count; c++)
+            out[x * 4 + c] = (c == 3) ? float(src[x * count + c]) / 255.0f
+                                      : ConvertFromSRGB8(src[x * count + c]);
+      }
+      else if(compWidth == 1 && compType == CompType::UNorm)
+      {
+        DecodeUNormRow(src, numTexels, count, out);
+      }
+      else if(compWidth == 1 && compType == CompType::SNorm)
+      {
+        DecodeSNormRow((const int8_t *)src, numTexels, count, out);
+      }
+      else if(compWidth == 1 && isUInt)
+      {
+        DecodeCastRow(src, numTexels, count, out);
+      }
+      else if(compWidth == 1 && isSInt)
+      {
+        DecodeCastRow((const int8_t *)src, numTexels, count, out);
+      }
+      else if(compWidth == 2 && compType == CompType::Float && count == 4)
+      {
+        ConvertFromHalf(u16, out, numTexels * 4);
+      }
+      else if(compWidth == 2 && compType == CompType::Float)
+      {
+        // convert in chunks then spread the components out
+        float converted[256];
+        const uint32_t chunkTexels = 256 / count;
+
+        for(uint32_t base = 0; base < numTexels; base += chunkTexels)
+        {
+          const uint32_t chunk = RDCMIN(chunkTexels, numTexels - base);
+
+          ConvertFromHalf(u16 + base * count, converted, chunk * count);
+
+          for(uint32_t x = 0; x < chunk; x++)
+            for(uint32_t c = 0; c < count; c++)
+              out[(base + x) * 4 + c] = converted[x * count + c];
+        }
+      }
+      else if(compWidth == 2 && (compType == CompType::UNorm || compType == CompType::Depth))
+      {
+        DecodeUNormRow(u16, numTexels, count, out);
+      }
+      else if(compWidth == 2 && compType == CompType::SNorm)
+      {
+        DecodeSNormRow((const int16_t *)src, numTexels, count, out);
+      }
+      else if(compWidth == 2 && isUInt)
+      {
+        DecodeCastRow(u16, numTexels, count, out);
+      }
+      else if(compWidth == 2 && isSInt)
+      {
+        DecodeCastRow((const int16_t *)src, numTexels, count, out);
+      }
+      else if(compWidth == 4 && (compType == CompType::Float || compType == CompType::Depth))
+      {
+        DecodeCastRow((const float *)src, numTexels, count, out);
+      }
+      else if(compWidth == 4 && isUInt)
+      {
+        DecodeCastRow(u32, numTexels, count, out);
+      }
+      else if(compWidth == 4 && isSInt)
+      {
+        DecodeCastRow((const int32_t *)src, numTexels, count, out);
+      }
+      else
+      {
+        // anything else (doubles, 24-bit depth) goes through the generic path
+        const uint32_t stride = GetTexelByteSize(typed);
+        for(uint32_t x = 0; x < numTexels; x++)
+          for(uint32_t c = 0; c < count; c++)
+            out[x * 4 + c] = ConvertComponent(typed, src + x * stride + c * compWidth);
+      }
+      break;
+    }
+    default: break;
+  }
+
+  if(fmt.BGRAOrder())
+  {
+    for(uint32_t x = 0; x < numTexels; x++)
+      std::swap(dst[x].x, dst[x].z);
+  }
+}
+
+// the texels of one 2D subresource, split into rows
+struct TextureStatsSource
+{
+  ResourceFormat fmt;
+  TexelKind kind;
+  const byte *data;
+  uint32_t width, height, rowPitch;
+
+  uint32_t RowsPerJob() const { return RDCMAX(1U, TextureStatsTexelsPerJob / width); }
+  int32_t NumJobs() const { return int32_t((height + RowsPerJob() - 1) / RowsPerJob()); }
+  // calls func(job, row, width) for each decoded row, spread across several threads. Rows are
+  // grouped into NumJobs() jobs so results can be accumulated per-job without locking
+  template <typename TexelType, typename Func>
+  void ForEachRow(Func func) const;
+};
+
+static bool GetStatsSource(const TextureDescription &tex, uint32_t sliceFace, uint32_t mip,
+                           CompType typeHint, const bytebuf &data, TextureStatsSource &src)
+{
+  src.fmt = tex.format;
+
+  // reinterpret typeless data as the hinted type, the same as the GPU path creating a typed view
+  if(typeHint != CompType::Typeless && src.fmt.type == ResourceFormatType::Regular &&
+     src.fmt.compType != CompType::Depth)
+    src.fmt.compType = typeHint;
+
+  src.kind = GetTexelKind(src.fmt);
+
+  uint32_t texelSize = GetTexelByteSize(src.fmt);
+
+  if(texelSize == 0)
+  {
+    RDCWARN("Can't compute texture statistics on the CPU for format %s",
+            src.fmt.Name().c_str());
+    return false;
+  }
+
+  src.width = RDCMAX(1U, tex.width >> mip);
+  src.height = RDCMAX(1U, tex.height >> mip);
+  src.rowPitch = src.width * texelSize;
+
+  uint64_t sliceSize = uint64_t(src.rowPitch) * src.height;
+
+  // 3D textures return every depth slice, select the one we want
+  uint64_t offset = 0;
+  if(tex.depth > 1)
+    offset = sliceSize * RDCMIN(sliceFace, RDCMAX(1U, tex.depth >> mip) - 1);
+
+  if(offset + sliceSize > data.size())
+  {
+    RDCWARN("Texture data is %llu bytes, expected at least %llu", (uint64_t)data.size(),
+            offset + sliceSize);
+    return false;
+  }
+
+  src.data = data.data() + offset;
+
+  return true;
+}
+
+template <typename TexelType, typename Func>
+void TextureStatsSource::ForEachRow(Func func) const
+{
+  const uint32_t rowsPerJob = RowsPerJob();
+
+  Threading::ParallelFor(NumJobs(), TextureStatsThreads, [&](int32_t job) {
+    std::vector<TexelType> row(width);
+
+    uint32_t endRow = RDCMIN(height, uint32_t(job + 1) * rowsPerJob);
+
+    for(uint32_t y = uint32_t(job) * rowsPerJob; y < endRow; y++)
+    {
+      const byte *rowData = data + uint64_t(y) * rowPitch;
+
+      if(kind == TexelKind::Float)
+        ConvertRowToFloat4(fmt, rowData, width, (Vec4f *)row.data());
+      else if(kind == TexelKind::UInt)
+        DecodeIntRow(fmt, rowData, width, (uint32_t *)row.data());
+      else
+        DecodeIntRow(fmt, rowData, width, (int32_t *)row.data());
+
+      func(job, row.data(), width);
+    }
+  });
+}
+
+// a decoded texel, with the same layout as a Vec4f so float and integer paths can share code
+template <typename T>
+struct Texel
+{
+  T v[4];
+};
+
+RDCCOMPILE_ASSERT(sizeof(Texel<float>) == sizeof(Vec4f), "Texel must match decoded row layout");
+
+template <typename T>
+struct MinMax4
+{
+  T mins[4];
+  T maxs[4];
+};
+
+template <typename T>
+static void CalcMinMax(const TextureStatsSource &src, float *minval, float *maxval)
+{
+  std::vector<MinMax4<T>> results(src.NumJobs());
+
+  for(MinMax4<T> &r : results)
+  {
+    for(int c = 0; c < 4; c++)
+    {
+      r.mins[c] = std::numeric_limits<T>::max();
+      r.maxs[c] = std::numeric_limits<T>::lowest();
+    }
+  }
+
+  src.ForEachRow<Texel<T>>([&results](int32_t job, const Texel<T> *row, uint32_t width) {
+    // accumulate into locals so the compiler can keep them in registers
+    MinMax4<T> local = results[job];
+
+    for(uint32_t x = 0; x < width; x++)
+    {
+      for(int c = 0; c < 4; c++)
+      {
+        local.mins[c] = row[x].v[c] < local.mins[c] ? row[x].v[c] : local.mins[c];
+        local.maxs[c] = row[x].v[c] > local.maxs[c] ? row[x].v[c] : local.maxs[c];
+      }
+    }
+
+    results[job] = local;
+  });
+
+  MinMax4<T> total = results[0];
+  for(size_t j = 1; j < results.size(); j++)
+  {
+    for(int c = 0; c < 4; c++)
+    {
+      total.mins[c] = RDCMIN(total.mins[c], results[j].mins[c]);
+      total.maxs[c] = RDCMAX(total.maxs[c], results[j].maxs[c]);
+    }
+  }
+
+  memcpy(minval, total.mins, sizeof(total.mins));
+  memcpy(maxval, total.maxs, sizeof(total.maxs));
+}
+
+bool CalcTextureMinMax(const TextureDescription &tex, uint32_t sliceFace, uint32_t mip,
+                       CompType typeHint, const bytebuf &data, float *minval, float *maxval)
+{
+  TextureStatsSource src;
+  if(!GetStatsSource(tex, sliceFace, mip, typeHint, data, src))
+    return false;
+
+  if(src.kind == TexelKind::UInt)
+    CalcMinMax<uint32_t>(src, minval, maxval);
+  else if(src.kind == TexelKind::SInt)
+    CalcMinMax<int32_t>(src, minval, maxval);
+  else
+    CalcMinMax<float>(src, minval, maxval);
+
+  return true;
+}
+
+template <typename T>
+static void CalcHistogram(const TextureStatsSource &src, float minval, float maxval,
+                          const bool channels[4], std::vector<uint32_t> &histogram)
+{
+  std::vector<std::vector<uint32_t>> results(src.NumJobs());
+
+  const float divisor = float(channels[0]) + float(channels[1]) + float(channels[2]) +
+                        float(channels[3]);
+
+  histogram.assign(HistogramNumBuckets, 0);
+
+  if(divisor == 0.0f)
+    return;
+
+  const float range = maxval - minval;
+
+  src.ForEachRow<Texel<T>>([&](int32_t job, const Texel<T> *row, uint32_t width) {
+    std::vector<uint32_t> &buckets = results[job];
+    if(buckets.empty())
+      buckets.resize(HistogramNumBuckets);
+
+    for(uint32_t x = 0; x < width; x++)
+    {
+      // sum in the texel type first, as the shaders do
+      T sum = T(0);
+      for(int c = 0; c < 4; c++)
+        if(channels[c])
+          sum += row[x].v[c];
+
+      float bucket = (float(sum) / divisor - minval) / range * float(HistogramNumBuckets);
+
+      // this also rejects NaNs
+      if(bucket >= 0.0f && bucket < float(HistogramNumBuckets))
+        buckets[uint32_t(bucket)]++;
+    }
+  });
+
+  for(size_t j = 0; j < results.size(); j++)
+    for(size_t b = 0; b < results[j].size(); b++)
+      histogram[b] += results[j][b];
+}
+
+bool CalcTextureHistogram(const TextureDescription &tex, uint32_t sliceFace, uint32_t mip,
+                          CompType typeHint, const bytebuf &data, float minval, float maxval,
+                          const bool channels[4], std::vector<uint32_t> &histogram)
+{
+  TextureStatsSource src;
+  if(!GetStatsSource(tex, sliceFace, mip, typeHint, data, src))
+    return false;
+
+  if(src.kind == TexelKind::UInt)
+    CalcHistogram<uint32_t>(src, minval, maxval, channels, histogram);
+  else if(src.kind == TexelKind::SInt)
+    CalcHistogram<int32_t>(src, minval, maxval, channels, histogram);
+  else
+    CalcHistogram<float>(src, minval, maxval, channels, histogram);
+
+  return true;
+}
+
+static bool GetStatsData(IRemoteDriver *driver, ResourceId texid, uint32_t sliceFace,
+                         uint32_t mip, uint32_t sample, CompType typeHint,
+                         TextureDescription &tex, bytebuf &data)
+{
+  tex = driver->GetTexture(texid);
+
+  GetTextureDataParams params;
+  params.typeHint = typeHint;
+  // a sample of ~0U means the samples are averaged
+  params.resolve = (sample == ~0U);
+
+  uint32_t arrayIdx = sliceFace;
+
+  // 3D textures return every depth slice together
+  if(tex.depth > 1)
+    arrayIdx = 0;
+  // individual samples are returned as extra array slices
+  else if(tex.msSamp > 1 && !params.resolve)
+    arrayIdx = sliceFace * tex.msSamp + RDCMIN(sample, tex.msSamp - 1);
+
+  driver->GetTextureData(texid, arrayIdx, mip, params, data);
+
+  return !data.empty();
+}
+
+bool CalcTextureMinMax(IRemoteDriver *driver, ResourceId texid, uint32_t sliceFace, uint32_t mip,
+                       uint32_t sample, CompType typeHint, float *minval, float *maxval)
+{
+  TextureDescription tex;
+  bytebuf data;
+
+  if(!GetStatsData(driver, texid, sliceFace, mip, sample, typeHint, tex, data))
+    return false;
+
+  return CalcTextureMinMax(tex, sliceFace, mip, typeHint, data, minval, maxval);
+}
+
+bool CalcTextureHistogram(IRemoteDriver *driver, ResourceId texid, uint32_t sliceFace,
+                          uint32_t mip, uint32_t sample, CompType typeHint, float minval,
+                          float maxval, const bool channels[4], std::vector<uint32_t> &histogram)
+{
+  TextureDescription tex;
+  bytebuf data;
+
+  if(!GetStatsData(driver, texid, sliceFace, mip, sample, typeHint, tex, data))
+    return false;
+
+  return CalcTextureHistogram(tex, sliceFace, mip, typeHint, data, minval, maxval, channels,
+                              histogram);
+}
+
+#if ENABLED(ENABLE_UNIT_TESTS)
+
+#include "3rdparty/catch/catch.hpp"
+#include "common/timing.h"
+
+TEST_CASE("Test CPU texture min/max and histogram", "[replay]")
+{
+  TextureDescription tex;
+  tex.width = 300;
+  tex.height = 200;
+  tex.depth = 1;
+  tex.msSamp = 1;
+  tex.format.type = ResourceFormatType::Regular;
+  tex.format.compCount = 4;
+  tex.format.compByteWidth = 1;
+  tex.format.compType = CompType::UNorm;
+
+  const bool allChannels[4] = {true, true, true, true};
+  const bool redChannel[4] = {true, false, false, false};
+
+  float minval[4], maxval[4];
+  std::vector<uint32_t> histogram;
+
+  SECTION("RGBA8 UNorm")
+  {
+    bytebuf data;
+    data.resize(tex.width * tex.height * 4);
+    for(uint32_t y = 0; y < tex.height; y++)
+    {
+      for(uint32_t x = 0; x < tex.width; x++)
+      {
+        byte *texel = &data[(y * tex.width + x) * 4];
+        texel[0] = byte(x % 200 + 20);
+        texel[1] = byte(y);
+        texel[2] = 51;
+        texel[3] = 255;
+      }
+    }
+
+    REQUIRE(CalcTextureMinMax(tex, 0, 0, CompType::Typeless, data, minval, maxval));
+    CHECK(minval[0] == 20.0f / 255.0f);
+    CHECK(maxval[0] == 219.0f / 255.0f);
+    CHECK(minval[1] == 0.0f);
+    CHECK(maxval[1] == 199.0f / 255.0f);
+    CHECK(minval[2] == 0.2f);
+    CHECK(maxval[2] == 0.2f);
+    CHECK(minval[3] == 1.0f);
+
+    // BGRA swaps the first and third channels
+    tex.format.SetBGRAOrder(true);
+    REQUIRE(CalcTextureMinMax(tex, 0, 0, CompType::Typeless, data, minval, maxval));
+    CHECK(minval[0] == 0.2f);
+    CHECK(maxval[2] == 219.0f / 255.0f);
+    tex.format.SetBGRAOrder(false);
+
+    // every texel lands in a bucket, and only red values of 20 are in the first one
+    REQUIRE(CalcTextureHistogram(tex, 0, 0, CompType::Typeless, data, 20.0f / 255.0f,
+                                 220.0f / 255.0f, redChannel, histogram));
+    REQUIRE(histogram.size() == 256);
+
+    uint32_t total = 0;
+    for(uint32_t count : histogram)
+      total += count;
+    CHECK(total == tex.width * tex.height);
+    CHECK(histogram[0] == 2 * tex.height);
+
+    // anything outside the range isn't counted
+    REQUIRE(CalcTextureHistogram(tex, 0, 0, CompType::Typeless, data, 0.5f, 1.0f, allChannels,
+                                 histogram));
+    total = 0;
+    for(uint32_t count : histogram)
+      total += count;
+    CHECK(total < tex.width * tex.height);
+  }
+
+  SECTION("Integer formats return raw bits")
+  {
+    tex.format.compCount = 2;
+    tex.format.compByteWidth = 2;
+    tex.format.compType = CompType::SInt;
+
+    bytebuf data;
+
+    data.resize(tex.width * tex.height * 4);
+    int16_t *texels = (int16_t *)data.data();
+    for(uint32_t i = 0; i < tex.width * tex.height; i++)
+    {
+      texels[i * 2 + 0] = int16_t(int32_t(i % 1000) - 500);
+      texels[i * 2 + 1] = int16_t(i % 7);
+    }
+
+    REQUIRE(CalcTextureMinMax(tex, 0, 0, CompType::Typeless, data, minval, maxval));
+
+    int32_t mins[4], maxs[4];
+    memcpy(mins, minval, sizeof(mins));
+    memcpy(maxs, maxval, sizeof(maxs));
+    CHECK(mins[0] == -500);
+    CHECK(maxs[0] == 499);
+    CHECK(mins[1] == 0);
+    CHECK(maxs[1] == 6);
+    CHECK(mins[3] == 1);
+  }
+
+  SECTION("Half float 3D texture")
+  {
+    tex.depth = 4;
+    tex.format.compCount = 1;
+    tex.format.compByteWidth = 2;
+    tex.format.compType = CompType::Float;
+
+    bytebuf data;
+
+    data.resize(tex.width * tex.height * tex.depth * 2);
+    uint16_t *texels = (uint16_t *)data.data();
+    for(uint32_t z = 0; z < tex.depth; z++)
+      for(uint32_t i = 0; i < tex.width * tex.height; i++)
+        texels[z * tex.width * tex.height + i] = ConvertToHalf(float(z) - 0.5f * float(i & 1));
+
+    REQUIRE(CalcTextureMinMax(tex, 2, 0, CompType::Typeless, data, minval, maxval));
+    CHECK(minval[0] == 1.5f);
+    CHECK(maxval[0] == 2.0f);
+
+    // half the texels are in the top bucket
+    REQUIRE(CalcTextureHistogram(tex, 2, 0, CompType::Typeless, data, 1.0f, 2.001f, redChannel,
+                                 histogram));
+    CHECK(histogram[255] == tex.width * tex.height / 2);
+  }
+
+  SECTION("Packed and depth formats")
+  {
+    bytebuf data;
+    data.resize(tex.width * tex.height * 4);
+    uint32_t *texels = (uint32_t *)data.data();
+
+    tex.format.type = ResourceFormatType::D24S8;
+    tex.format.compType = CompType::Depth;
+
+    for(uint32_t i = 0; i < tex.width * tex.height; i++)
+      texels[i] = (i % 0x1000000) | (uint32_t(i % 128) << 24);
+
+    REQUIRE(CalcTextureMinMax(tex, 0, 0, CompType::Typeless, data, minval, maxval));
+    CHECK(minval[0] == 0.0f);
+    CHECK(maxval[0] == float(tex.width * tex.height - 1) / 16777215.0f);
+    CHECK(maxval[1] == 127.0f / 255.0f);
+
+    tex.format.type = ResourceFormatType::R10G10B10A2;
+    tex.format.compType = CompType::UNorm;
+
+    for(uint32_t i = 0; i < tex.width * tex.height; i++)
+      texels[i] = 1023 | (uint32_t(i % 512) << 10) | (3U << 30);
+
+    REQUIRE(CalcTextureMinMax(tex, 0, 0, CompType::Typeless, data, minval, maxval));
+    CHECK(minval[0] == 1.0f);
+    CHECK(minval[1] == 0.0f);
+    CHECK(maxval[1] == 511.0f / 1023.0f);
+    CHECK(minval[2] == 0.0f);
+    CHECK(maxval[3] == 1.0f);
+  }
+
+  SECTION("Row conversion matches per-component conversion")
+  {
+    bytebuf data;
+    data.resize(1024 * 8);
+    for(size_t i = 0; i < data.size(); i++)
+      data[i] = byte((i * 2654435761U) >> 13);
+
+    std::vector<Vec4f> row(1024);
+
+    for(CompType compType : {CompType::UNorm, CompType::SNorm, CompType::UInt, CompType::SInt,
+                             CompType::UScaled, CompType::Float, CompType::UNormSRGB})
+    {
+      for(uint32_t compByteWidth : {1U, 2U, 4U})
+      {
+        if((compType == CompType::Float && compByteWidth == 1) ||
+           ((compType == CompType::UNorm || compType == CompType::SNorm ||
+             compType == CompType::UNormSRGB) &&
+            compByteWidth == 4) ||
+           (compType == CompType::UNormSRGB && compByteWidth != 1))
+          continue;
+
+        ResourceFormat fmt;
+        fmt.type = ResourceFormatType::Regular;
+        fmt.compType = compType;
+        fmt.compByteWidth = compByteWidth;
+        fmt.compCount = 3;
+
+        ConvertRowToFloat4(fmt, data.data(), 1024, row.data());
+
+        uint32_t mismatches = 0;
+
+        for(uint32_t x = 0; x < 1024; x++)
+        {
+          for(uint32_t c = 0; c < 3; c++)
+          {
+            float ref = ConvertComponent(fmt, data.data() + (x * 3 + c) * compByteWidth);
+            float val = (&row[x].x)[c];
+
+            // compare bits so NaNs match and -0 is distinct from 0
+            if(memcmp(&ref, &val, sizeof(float)) != 0)
+              mismatches++;
+          }
+
+          if(row[x].w != 1.0f)
+            mismatches++;
+        }
+
+        INFO("format " << fmt.Name().c_str());
+        CHECK(mismatches == 0);
+      }
+    }
+  }
+
+  SECTION("Unsupported formats and short data fail")
+  {
+    bytebuf data;
+    data.resize(16);
+    CHECK_FALSE(CalcTextureMinMax(tex, 0, 0, CompType::Typeless, data, minval, maxval));
+
+    tex.format.type = ResourceFormatType::BC1;
+    data.resize(tex.width * tex.height * 4);
+    CHECK_FALSE(CalcTextureMinMax(tex, 0, 0, CompType::Typeless, data, minval, maxval));
+  }
+};
+
+TEST_CASE("Test bulk format conversion matches single values", "[format]")
+{
+  SECTION("Half to float")
+  {
+    // every possible half
+    std::vector<uint16_t> halves(0x10000);
+    for(uint32_t i = 0; i < 0x10000; i++)
+      halves[i] = uint16_t(i);
+
+    std::vector<float> floats(halves.size());
+    ConvertFromHalf(halves.data(), floats.data(), halves.size());
+
+    uint32_t mismatches = 0;
+    for(size_t i = 0; i < halves.size(); i++)
+    {
+      float ref = ConvertFromHalf(halves[i]);
+      if(memcmp(&ref, &floats[i], sizeof(float)) != 0)
+        mismatches++;
+    }
+
+    CHECK(mismatches == 0);
+  }
+
+  SECTION("Float to half")
+  {
+    // a spread of bit patterns covering every exponent, plus the edges around rounding
+    std::vector<float> floats;
+    for(uint32_t exponent = 0; exponent < 256; exponent++)
+    {
+      for(uint32_t m = 0; m < 512; m++)
+      {
+        uint32_t mantissa = (m * 2654435761U) & 0x7fffff;
+        if(m < 8)
+          mantissa = 0x7fffff >> m;
+        else if(m < 16)
+          mantissa = (0x1000 << (m & 3)) - (m & 4 ? 1 : 0);
+
+        for(uint32_t sign = 0; sign < 2; sign++)
+        {
+          uint32_t bits = (sign << 31) | (exponent << 23) | mantissa;
+          float f;
+          memcpy(&f, &bits, sizeof(f));
+          floats.push_back(f);
+        }
+      }
+    }
+
+    std::vector<uint16_t> halves(floats.size());
+    ConvertToHalf(floats.data(), halves.data(), floats.size());
+
+    uint32_t mismatches = 0;
+    for(size_t i = 0; i < floats.size(); i++)
+      if(ConvertToHalf(floats[i]) != halves[i])
+        mismatches++;
+
+    CHECK(mismatches == 0);
+  }
+
+  SECTION("R11G11B10")
+  {
+    // every value of each channel, with the others varying
+    std::vector<uint32_t> packed(0x800);
+    for(uint32_t i = 0; i < 0x800; i++)
+      packed[i] = i | ((0x7ff - i) << 11) | ((i & 0x3ff) << 22);
+
+    std::vector<Vec4f> unpacked(packed.size());
+    ConvertFromR11G11B10(packed.data(), unpacked.data(), packed.size());
+
+    uint32_t mismatches = 0;
+    for(size_t i = 0; i < packed.size(); i++)
+    {
+      Vec3f ref = ConvertFromR11G11B10(packed[i]);
+      if(memcmp(&ref, &unpacked[i], sizeof(Vec3f)) != 0 || unpacked[i].w != 1.0f)
+        mismatches++;
+    }
+
+    CHECK(mismatches == 0);
+
+    // denormals of the 5-bit mantissa blue channel
+    CHECK(ConvertFromR11G11B10(1U << 22).z == 1.0f / 524288.0f);
+    CHECK(ConvertFromR11G11B10(3U << 22).z == 3.0f / 524288.0f);
+    CHECK(ConvertFromR11G11B10(3U).x == 3.0f / 1048576.0f);
+  }
+};
+
+TEST_CASE("Benchmark bulk half conversion", "[.][benchmark]")
+{
+  const size_t count = 16 * 1024 * 1024;
+
+  std::vector<uint16_t> halves(count);
+  for(size_t i = 0; i < count; i++)
+    halves[i] = uint16_t((i * 2654435761U) >> 7);
+
+  std::vector<float> floats(count);
+
+  PerformanceTimer timer;
+  for(size_t i = 0; i < count; i++)
+    floats[i] = ConvertFromHalf(halves[i]);
+  double scalarFromTime = timer.GetMilliseconds();
+
+  timer.Restart();
+  ConvertFromHalf(halves.data(), floats.data(), count);
+  double bulkFromTime = timer.GetMilliseconds();
+
+  timer.Restart();
+  for(size_t i = 0; i < count; i++)
+    halves[i] = ConvertToHalf(floats[i]);
+  double scalarToTime = timer.GetMilliseconds();
+
+  timer.Restart();
+  ConvertToHalf(floats.data(), halves.data(), count);
+  double bulkToTime = timer.GetMilliseconds();
+
+  WARN(count << " halves to float: " << scalarFromTime << "ms single, " << bulkFromTime
+             << "ms bulk. To half: " << scalarToTime << "ms single, " << bulkToTime << "ms bulk");
+}
+
+#endif    // ENABLED(ENABLE_UNIT_TESTS)
@@ -110,6 +110,55 @@ TEST_CASE("Test LZ4 compression/decompression", "[streamio][lz4]")
   delete[] randomData;
 };
 
+TEST_CASE("Test LZ4 compression of large unaligned writes", "[streamio][lz4]")
+{
+  StreamWriter buf(StreamWriter::DefaultScratchSize);
+
+  // repeating data with a period that doesn't line up with the compression pages, so that matches
+  // have to reach back into the previous page
+  const size_t size = 3 * 1024 * 1024 + 17;
+  byte *data = new byte[size];
+
+  for(size_t i = 0; i < size; i++)
+    data[i] = byte((i % 1000) & 0xff) ^ byte((i / 4000) & 0xff);
+
+  {
+    StreamWriter writer(new LZ4Compressor(&buf, Ownership::Nothing), Ownership::Stream);
+
+    writer.Write(data, 100);
+    writer.Write(data + 100, size - 200);
+    writer.Write(data + size - 100, 100);
+    writer.Write(data, 1024 * 1024);
+
+    CHECK(buf.GetOffset() < size / 8);
+
+    writer.Finish();
+
+    CHECK_FALSE(writer.IsErrored());
+  }
+
+  {
+    StreamReader reader(
+        new LZ4Decompressor(new StreamReader(buf.GetData(), buf.GetOffset()), Ownership::Stream),
+        size + 1024 * 1024, Ownership::Stream);
+
+    byte *readData = new byte[size];
+
+    reader.Read(readData, size);
+    CHECK_FALSE(memcmp(readData, data, size));
+
+    reader.Read(readData, 1024 * 1024);
+    CHECK_FALSE(memcmp(readData, data, 1024 * 1024));
+
+    CHECK_FALSE(reader.IsErrored());
+    CHECK(reader.AtEnd());
+
+    delete[] readData;
+  }
+
+  delete[] data;
+};
+
 TEST_CASE("Test ZSTD compression/decompression", "[streamio][zstd]")
 {
   StreamWriter buf(StreamWriter::DefaultScratchSize);
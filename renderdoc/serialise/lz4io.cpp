@@ -23,9 +23,16 @@
  ******************************************************************************/
 
 #include "lz4io.h"
+#include "common/threading.h"
 
 static const uint64_t lz4BlockSize = 64 * 1024;
 
+// writes at least this large compress their whole pages on worker threads, in groups of
+// lz4ParallelPages pages at a time to bound the memory needed for the compressed output.
+static const uint64_t lz4ParallelBytes = 8 * lz4BlockSize;
+static const uint64_t lz4ParallelPages = 64;
+static const int32_t lz4ParallelThreads = 4;
+
 LZ4Compressor::LZ4Compressor(StreamWriter *write, Ownership own) : Compressor(write, own)
 {
   m_Page[0] = AllocAlignedBuffer(lz4BlockSize);
@@ -86,6 +93,36 @@ bool LZ4Compressor::Write(const void *data, uint64_t numBytes)
 
     bool success = true;
 
+    // for large writes, compress all but the last page directly from the source data in parallel.
+    // The last page is kept back so that the stream carries on from it as history, exactly as if
+    // every page had gone through FlushPage0().
+    if(numBytes >= lz4ParallelBytes)
+    {
+      success &= FlushPage0();
+
+      if(!success)
+        return success;
+
+      uint64_t numPages = (numBytes - 1) / lz4BlockSize;
+
+      success &= CompressPages(src, numPages);
+
+      if(!success)
+        return success;
+
+      src += numPages * lz4BlockSize;
+      numBytes -= numPages * lz4BlockSize;
+
+      // the pages were compressed with their own streams, so re-point ours at the last one.
+      memcpy(m_Page[1], src - lz4BlockSize, (size_t)lz4BlockSize);
+      LZ4_loadDict(&m_LZ4Comp, (const char *)m_Page[1], (int)lz4BlockSize);
+
+      memcpy(m_Page[0], src, (size_t)numBytes);
+      m_PageOffset = numBytes;
+
+      return success;
+    }
+
     while(success && numBytes > 0)
     {
       // flush and swap pages
@@ -152,6 +189,62 @@ bool LZ4Compressor::FlushPage0()
   return success;
 }
 
+bool LZ4Compressor::CompressPages(const byte *src, uint64_t numPages)
+{
+  // if we encountered a stream error this will be NULL
+  if(!m_CompressBuffer)
+    return false;
+
+  const int32_t compressBound = LZ4_COMPRESSBOUND(lz4BlockSize);
+
+  std::vector<byte> compressed;
+  std::vector<int32_t> compSizes;
+  compressed.resize(size_t(RDCMIN(numPages, lz4ParallelPages) * compressBound));
+  compSizes.resize(size_t(RDCMIN(numPages, lz4ParallelPages)));
+
+  bool success = true;
+
+  for(uint64_t first = 0; success && first < numPages; first += lz4ParallelPages)
+  {
+    const int32_t count = (int32_t)RDCMIN(numPages - first, lz4ParallelPages);
+    const byte *pages = src + first * lz4BlockSize;
+
+    // each page is compressed with the page before it as a dictionary, which is the same history
+    // the decompressor has when it reaches that page. The first page's history is the page that
+    // was last flushed.
+    Threading::ParallelFor(count, lz4ParallelThreads, [&](int32_t i) {
+      const byte *page = pages + i * lz4BlockSize;
+      const byte *dict = (first == 0 && i == 0) ? m_Page[1] : page - lz4BlockSize;
+
+      LZ4_stream_t stream;
+      LZ4_resetStream(&stream);
+      LZ4_loadDict(&stream, (const char *)dict, (int)lz4BlockSize);
+
+      compSizes[i] = LZ4_compress_fast_continue(&stream, (const char *)page,
+                                                (char *)compressed.data() + i * compressBound,
+                                                (int)lz4BlockSize, compressBound, 1);
+    });
+
+    for(int32_t i = 0; success && i < count; i++)
+    {
+      if(compSizes[i] < 0)
+      {
+        RDCERR("Error compressing: %i", compSizes[i]);
+        FreeAlignedBuffer(m_Page[0]);
+        FreeAlignedBuffer(m_Page[1]);
+        FreeAlignedBuffer(m_CompressBuffer);
+        m_Page[0] = m_Page[1] = m_CompressBuffer = NULL;
+        return false;
+      }
+
+      success &= m_Write->Write(compSizes[i]);
+      success &= m_Write->Write(compressed.data() + i * compressBound, compSizes[i]);
+    }
+  }
+
+  return success;
+}
+
 LZ4Decompressor::LZ4Decompressor(StreamReader *read, Ownership own) : Decompressor(read, own)
 {
   m_Page[0] = AllocAlignedBuffer(lz4BlockSize);
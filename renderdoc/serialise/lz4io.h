@@ -38,6 +38,7 @@ public:
 
 private:
   bool FlushPage0();
+  bool CompressPages(const byte *src, uint64_t numPages);
 
   byte *m_Page[2];
   byte *m_CompressBuffer;
@@ -29,6 +29,7 @@
 #include "api/replay/version.h"
 #include "common/dds_readwrite.h"
 #include "lz4io.h"
+#include "serialiser.h"
 #include "zstdio.h"
 
 // not provided by tinyexr, just do by hand
@@ -229,6 +230,8 @@ RDCFile::~RDCFile()
 
   if(m_Thumb.pixels)
     delete[] m_Thumb.pixels;
+
+  SAFE_DELETE(m_CallstackTable);
 }
 
 void RDCFile::Open(const char *path)
@@ -319,7 +322,7 @@ void RDCFile::Init(StreamReader &reader)
 
   m_SerVer = header.version;
 
-  if(m_SerVer != SERIALISE_VERSION && m_SerVer != V1_0_VERSION)
+  if(m_SerVer != SERIALISE_VERSION && m_SerVer != V1_1_VERSION && m_SerVer != V1_0_VERSION)
   {
     if(header.version < V1_0_VERSION)
     {
@@ -783,6 +786,30 @@ int RDCFile::SectionIndex(const char *name) const
   return -1;
 }
 
+bool RDCFile::ReadCallstackTable(CallstackTable &table) const
+{
+  int index = SectionIndex(SectionType::CallstackTable);
+
+  if(index < 0)
+    return false;
+
+  StreamReader *reader = ReadSection(index);
+
+  bool ret = !reader->IsErrored() && table.Read(*reader);
+
+  delete reader;
+
+  return ret;
+}
+
+CallstackTable *RDCFile::GetCallstackTable()
+{
+  if(!m_CallstackTable)
+    m_CallstackTable = new CallstackTable();
+
+  return m_CallstackTable;
+}
+
 StreamReader *RDCFile::ReadSection(int index) const
 {
   if(m_Error != ContainerError::NoError)
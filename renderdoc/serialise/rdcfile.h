@@ -61,12 +61,14 @@ public:
   // version number of overall file format or chunk organisation. If the contents/meaning/order of
   // chunks have changed this does not need to be bumped, there are version numbers within each
   // API that interprets the stream that can be bumped.
-  static const uint32_t SERIALISE_VERSION = 0x00000101;
+  static const uint32_t SERIALISE_VERSION = 0x00000102;
 
   // this must never be changed - files before this were in the v0.x series and didn't have embedded
   // version numbers
   static const uint32_t V1_0_VERSION = 0x00000100;
   static const uint32_t V1_1_VERSION = 0x00000101;
+  // chunk headers can contain an index into the callstack table section instead of the callstack
+  static const uint32_t V1_2_VERSION = 0x00000102;
 
   ~RDCFile();
 
@@ -96,6 +98,13 @@ public:
   StreamReader *ReadSection(int index) const;
   StreamWriter *WriteSection(const SectionProperties &props);
 
+  // reads the callstack table section, if present. Returns false if there is no table.
+  bool ReadCallstackTable(CallstackTable &table) const;
+
+  // the table that callstack indices in chunks written to this file refer to. It's written out as
+  // its own section when the capture is finished.
+  CallstackTable *GetCallstackTable();
+
   // Only valid if GetDriver returns RDCDriver::Image, passes over the underlying FILE * for use
   // loading the image directly, since the RDC container isn't there to read from a section.
   FILE *StealImageFileHandle(std::string &filename);
@@ -111,6 +120,8 @@ private:
 
   uint32_t m_SerVer = 0;
 
+  CallstackTable *m_CallstackTable = NULL;
+
   RDCDriver m_Driver = RDCDriver::Unknown;
   std::string m_DriverName;
   uint64_t m_MachineIdent = 0;
@@ -80,7 +80,19 @@ uint32_t Serialiser<SerialiserMode::Reading>::BeginChunk(uint32_t, uint64_t)
 
     m_ChunkMetadata.chunkID = chunkID;
 
-    if(c & ChunkCallstack)
+    if(c & ChunkCallstackIndex)
+    {
+      uint32_t callstackIndex = 0;
+      m_Read->Read(callstackIndex);
+
+      m_ChunkMetadata.flags |= SDChunkFlags::HasCallstack;
+
+      // if we don't have the table, leave the callstack empty
+      if(m_CallstackTable && m_CallstackTable->Count() > 0 &&
+         !m_CallstackTable->Get(callstackIndex, m_ChunkMetadata.callstack))
+        RDCWARN("Chunk references invalid callstack %u", callstackIndex);
+    }
+    else if(c & ChunkCallstack)
     {
       uint32_t numFrames = 0;
       m_Read->Read(numFrames);
@@ -285,31 +297,44 @@ uint32_t Serialiser<SerialiserMode::Writing>::BeginChunk(uint32_t chunkID, uint6
 
       m_ChunkMetadata.chunkID = chunkID;
 
-      /////////////////
+      uint32_t callstackIndex = 0;
 
-      m_Write->Write(c);
-
-      if(c & ChunkCallstack)
+      // freshly collected callstacks are interned into the capture's callstack table, and only
+      // the index is written. Callstacks that were specified up-front are written inline.
+      if((c & ChunkCallstack) && m_ChunkMetadata.callstack.empty())
       {
-        if(m_ChunkMetadata.callstack.empty())
-        {
-          bool collect = RenderDoc::Inst().GetCaptureOptions().captureCallstacks;
+        bool collect = RenderDoc::Inst().GetCaptureOptions().captureCallstacks;
 
-          if(RenderDoc::Inst().GetCaptureOptions().captureCallstacksOnlyDraws)
-            collect = collect && m_DrawChunk;
+        if(RenderDoc::Inst().GetCaptureOptions().captureCallstacksOnlyDraws)
+          collect = collect && m_DrawChunk;
 
-          if(collect)
+        if(collect)
+        {
+          Callstack::Stackwalk *stack = Callstack::Collect();
+          if(stack && stack->NumLevels() > 0)
           {
-            Callstack::Stackwalk *stack = Callstack::Collect();
-            if(stack && stack->NumLevels() > 0)
-            {
-              m_ChunkMetadata.callstack.assign(stack->GetAddrs(), stack->NumLevels());
-            }
-
-            SAFE_DELETE(stack);
+            CallstackTable &table =
+                m_CallstackTable ? *m_CallstackTable : RenderDoc::Inst().GetCallstackTable();
+            callstackIndex = table.Intern(stack->GetAddrs(), stack->NumLevels());
+            c |= ChunkCallstackIndex;
           }
+
+          SAFE_DELETE(stack);
         }
+      }
+
+      /////////////////
+
+      m_Write->Write(c);
 
+      if(c & ChunkCallstackIndex)
+      {
+        m_ChunkMetadata.flags |= SDChunkFlags::HasCallstack;
+
+        m_Write->Write(callstackIndex);
+      }
+      else if(c & ChunkCallstack)
+      {
         m_ChunkMetadata.flags |= SDChunkFlags::HasCallstack;
 
         uint32_t numFrames = (uint32_t)m_ChunkMetadata.callstack.size();
@@ -520,6 +545,156 @@ void Serialiser<SerialiserMode::Writing>::WriteStructuredFile(const SDFile &file
   scratchWriter.m_StructuredFile = &scratchWriter.m_StructData;
 }
 
+void Chunk::Write(Serialiser<SerialiserMode::Writing> &ser)
+{
+  uint32_t c = 0;
+  if(m_Length >= sizeof(uint32_t) * 2)
+    memcpy(&c, m_Data, sizeof(c));
+
+  CallstackTable *table = ser.GetCallstackTable();
+
+  // chunks recorded outside of this serialiser refer to the process-wide callstack table, so the
+  // index that follows the chunk ID has to be remapped into the destination table.
+  if(table && (c & Serialiser<SerialiserMode::Writing>::ChunkCallstackIndex))
+  {
+    uint32_t callstackIndex = 0;
+    memcpy(&callstackIndex, m_Data + sizeof(c), sizeof(callstackIndex));
+
+    callstackIndex = table->Import(RenderDoc::Inst().GetCallstackTable(), callstackIndex);
+
+    ser.GetWriter()->Write(c);
+    ser.GetWriter()->Write(callstackIndex);
+    ser.GetWriter()->Write((const void *)(m_Data + sizeof(uint32_t) * 2),
+                           (size_t)m_Length - sizeof(uint32_t) * 2);
+    return;
+  }
+
+  ser.GetWriter()->Write((const void *)m_Data, (size_t)m_Length);
+}
+
+/////////////////////////////////////////////////////////////
+// Callstack table
+
+static uint64_t HashCallstack(const uint64_t *addrs, size_t numLevels)
+{
+  // FNV-1a over the frame addresses
+  uint64_t hash = 14695981039346656037ULL;
+  for(size_t i = 0; i < numLevels; i++)
+  {
+    hash ^= addrs[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+uint32_t CallstackTable::Intern(const uint64_t *addrs, size_t numLevels)
+{
+  uint64_t hash = HashCallstack(addrs, numLevels);
+
+  SCOPED_LOCK(m_Lock);
+
+  std::vector<uint32_t> &candidates = m_Lookup[hash];
+
+  for(uint32_t idx : candidates)
+  {
+    const rdcarray<uint64_t> &stack = m_Callstacks[idx];
+    if(stack.size() == numLevels && !memcmp(stack.data(), addrs, numLevels * sizeof(uint64_t)))
+      return idx;
+  }
+
+  uint32_t idx = (uint32_t)m_Callstacks.size();
+  m_Callstacks.push_back(rdcarray<uint64_t>());
+  m_Callstacks.back().assign(addrs, numLevels);
+  candidates.push_back(idx);
+
+  return idx;
+}
+
+uint32_t CallstackTable::Import(const CallstackTable &src, uint32_t index)
+{
+  {
+    SCOPED_LOCK(m_Lock);
+    if(index < m_Imported.size() && m_Imported[index] != ~0U)
+      return m_Imported[index];
+  }
+
+  rdcarray<uint64_t> callstack;
+  if(!src.Get(index, callstack))
+    RDCWARN("Importing invalid callstack %u", index);
+
+  uint32_t ret = Intern(callstack.data(), callstack.size());
+
+  SCOPED_LOCK(m_Lock);
+  if(index >= m_Imported.size())
+    m_Imported.resize(index + 1, ~0U);
+  m_Imported[index] = ret;
+
+  return ret;
+}
+
+bool CallstackTable::Get(uint32_t index, rdcarray<uint64_t> &callstack) const
+{
+  SCOPED_LOCK(m_Lock);
+
+  if(index >= m_Callstacks.size())
+  {
+    callstack.clear();
+    return false;
+  }
+
+  callstack = m_Callstacks[index];
+  return true;
+}
+
+void CallstackTable::Write(StreamWriter &writer)
+{
+  SCOPED_LOCK(m_Lock);
+
+  uint32_t count = (uint32_t)m_Callstacks.size();
+  writer.Write(count);
+
+  for(const rdcarray<uint64_t> &stack : m_Callstacks)
+  {
+    uint32_t numFrames = (uint32_t)stack.size();
+    writer.Write(numFrames);
+    writer.Write(stack.data(), stack.byteSize());
+  }
+}
+
+bool CallstackTable::Read(StreamReader &reader)
+{
+  SCOPED_LOCK(m_Lock);
+
+  m_Lookup.clear();
+  m_Callstacks.clear();
+  m_Imported.clear();
+
+  uint32_t count = 0;
+  reader.Read(count);
+
+  m_Callstacks.resize(count);
+
+  for(uint32_t i = 0; i < count && !reader.IsErrored(); i++)
+  {
+    uint32_t numFrames = 0;
+    reader.Read(numFrames);
+
+    m_Callstacks[i].resize(numFrames);
+    reader.Read(m_Callstacks[i].data(), m_Callstacks[i].byteSize());
+
+    m_Lookup[HashCallstack(m_Callstacks[i].data(), numFrames)].push_back(i);
+  }
+
+  if(reader.IsErrored())
+  {
+    m_Lookup.clear();
+    m_Callstacks.clear();
+    return false;
+  }
+
+  return true;
+}
+
 template <>
 rdcstr DoStringise(const SDBasic &el)
 {
@@ -25,6 +25,7 @@
 #pragma once
 
 #include <list>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -53,6 +54,40 @@ void Deserialise(const T &el)
 
 typedef std::string (*ChunkLookup)(uint32_t chunkType);
 
+// A deduplicated table of callstacks. While capturing, collected chunk callstacks are interned
+// into a process-wide table and the chunk only stores the index - since the same few call sites
+// generate the vast majority of chunks this saves a lot of memory and file size. As chunks are
+// written to a capture the indices they use are remapped into a table belonging to that file, so
+// each capture only contains its own callstacks. That table is written into its own section and
+// on reading the indices are expanded back out into SDChunkMetaData::callstack.
+class CallstackTable
+{
+public:
+  // returns the index of the given callstack, adding it if it's not already present. Thread-safe.
+  uint32_t Intern(const uint64_t *addrs, size_t numLevels);
+
+  // returns the index in this table of the callstack at index in src, adding it if necessary.
+  // Repeated imports of the same index are looked up directly.
+  uint32_t Import(const CallstackTable &src, uint32_t index);
+
+  // fills out the callstack for the given index. Returns false if the index isn't in the table
+  bool Get(uint32_t index, rdcarray<uint64_t> &callstack) const;
+
+  size_t Count() const { return m_Callstacks.size(); }
+  void Write(StreamWriter &writer);
+  bool Read(StreamReader &reader);
+
+private:
+  mutable Threading::CriticalSection m_Lock;
+
+  // hash of the frame addresses, to list of indices with that hash
+  std::map<uint64_t, std::vector<uint32_t>> m_Lookup;
+  std::vector<rdcarray<uint64_t>> m_Callstacks;
+
+  // source index to index in this table for Import, ~0U if not yet imported
+  std::vector<uint32_t> m_Imported;
+};
+
 enum class SerialiserFlags
 {
   NoFlags = 0x0,
@@ -101,6 +136,7 @@ public:
     ChunkDuration = 0x00040000,
     ChunkTimestamp = 0x00080000,
     Chunk64BitSize = 0x00100000,
+    ChunkCallstackIndex = 0x00200000,
   };
 
   //////////////////////////////////////////
@@ -124,6 +160,11 @@ public:
   void *GetUserData() { return m_pUserData; }
   void SetUserData(void *userData) { m_pUserData = userData; }
   void SetStringDatabase(std::set<std::string> *db) { m_ExtStringDB = db; }
+  // when reading, the table used to expand callstack indices. When writing, the table that
+  // written indices refer to - chunks recorded against the process-wide table are remapped into it
+  // as they're written. See CallstackTable
+  void SetCallstackTable(CallstackTable *table) { m_CallstackTable = table; }
+  CallstackTable *GetCallstackTable() const { return m_CallstackTable; }
   // jumps to the byte after the current chunk, can be called any time after BeginChunk
   void SkipCurrentChunk();
 
@@ -1566,6 +1607,8 @@ private:
   }
 
   ChunkLookup m_ChunkLookup = NULL;
+
+  CallstackTable *m_CallstackTable = NULL;
 };
 
 #ifndef SERIALISER_IMPL
@@ -1747,10 +1790,9 @@ public:
     return ret;
   }
 
-  void Write(Serialiser<SerialiserMode::Writing> &ser)
-  {
-    ser.GetWriter()->Write((const void *)m_Data, (size_t)m_Length);
-  }
+  // writes the chunk out verbatim, except for remapping its callstack index if the serialiser has
+  // its own callstack table
+  void Write(Serialiser<SerialiserMode::Writing> &ser);
 
 private:
   Chunk() = default;
@@ -562,6 +562,87 @@ TEST_CASE("Read/write chunk metadata", "[serialiser]")
   delete buf;
 };
 
+TEST_CASE("Read/write callstack table", "[serialiser]")
+{
+  CallstackTable table;
+
+  uint64_t stackA[] = {101, 102, 103, 104};
+  uint64_t stackB[] = {101, 102, 103};
+  uint64_t stackC[] = {201};
+
+  uint32_t a = table.Intern(stackA, ARRAY_COUNT(stackA));
+  uint32_t b = table.Intern(stackB, ARRAY_COUNT(stackB));
+
+  CHECK(a != b);
+  CHECK(table.Intern(stackA, ARRAY_COUNT(stackA)) == a);
+  CHECK(table.Intern(stackB, ARRAY_COUNT(stackB)) == b);
+
+  uint32_t c = table.Intern(stackC, ARRAY_COUNT(stackC));
+
+  CHECK(table.Count() == 3);
+
+  StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
+
+  table.Write(*buf);
+
+  REQUIRE_FALSE(buf->IsErrored());
+
+  {
+    CallstackTable readTable;
+
+    StreamReader reader(buf->GetData(), buf->GetOffset());
+
+    REQUIRE(readTable.Read(reader));
+    CHECK(reader.AtEnd());
+
+    CHECK(readTable.Count() == 3);
+
+    rdcarray<uint64_t> stack;
+
+    REQUIRE(readTable.Get(a, stack));
+    REQUIRE(stack.size() == 4);
+    CHECK(stack[0] == 101);
+    CHECK(stack[3] == 104);
+
+    REQUIRE(readTable.Get(b, stack));
+    REQUIRE(stack.size() == 3);
+    CHECK(stack[2] == 103);
+
+    REQUIRE(readTable.Get(c, stack));
+    REQUIRE(stack.size() == 1);
+    CHECK(stack[0] == 201);
+
+    CHECK_FALSE(readTable.Get(3, stack));
+    CHECK(stack.empty());
+
+    // interning into a read table finds the existing entries
+    CHECK(readTable.Intern(stackB, ARRAY_COUNT(stackB)) == b);
+  }
+
+  {
+    // a capture's table only gets the callstacks it imports, in the order it imports them
+    CallstackTable captureTable;
+
+    CHECK(captureTable.Import(table, c) == 0);
+    CHECK(captureTable.Import(table, a) == 1);
+    CHECK(captureTable.Import(table, c) == 0);
+
+    CHECK(captureTable.Count() == 2);
+
+    rdcarray<uint64_t> stack;
+
+    REQUIRE(captureTable.Get(0, stack));
+    REQUIRE(stack.size() == 1);
+    CHECK(stack[0] == 201);
+
+    REQUIRE(captureTable.Get(1, stack));
+    REQUIRE(stack.size() == 4);
+    CHECK(stack[0] == 101);
+  }
+
+  delete buf;
+};
+
 TEST_CASE("Verify multiple chunks can be merged", "[serialiser][chunks]")
 {
   StreamWriter *buf = new StreamWriter(StreamWriter::DefaultScratchSize);
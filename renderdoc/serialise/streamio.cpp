@@ -24,6 +24,7 @@
 
 #include "streamio.h"
 #include <errno.h>
+#include "common/threading.h"
 #include "common/timing.h"
 
 Compressor::~Compressor()
@@ -39,6 +40,7 @@ Decompressor::~Decompressor()
 }
 
 static const uint64_t initialBufferSize = 64 * 1024;
+static const uint64_t readAheadBlockSize = 1024 * 1024;
 const byte StreamWriter::empty[128] = {};
 
 StreamReader::StreamReader(const byte *buffer, uint64_t bufferSize)
@@ -358,6 +360,170 @@ StreamWriter::StreamWriter(uint64_t initialBufSize)
   m_Ownership = Ownership::Nothing;
 }
 
+ReadAheadDecompressor::ReadAheadDecompressor(StreamReader *read, Ownership own)
+    : Decompressor(read, own)
+{
+  m_Size = read->GetSize() - read->GetOffset();
+
+  for(Block &b : m_Blocks)
+    b.data = AllocAlignedBuffer(readAheadBlockSize);
+
+  m_FilledSem = Threading::Semaphore::Create();
+  m_FreeSem = Threading::Semaphore::Create();
+
+  m_Thread = Threading::CreateThread([this]() { ReadThread(); });
+}
+
+ReadAheadDecompressor::~ReadAheadDecompressor()
+{
+  m_Shutdown = true;
+  m_FreeSem->Wake();
+
+  Threading::JoinThread(m_Thread);
+  Threading::CloseThread(m_Thread);
+
+  m_FilledSem->Destroy();
+  m_FreeSem->Destroy();
+
+  for(Block &b : m_Blocks)
+    FreeAlignedBuffer(b.data);
+}
+
+void ReadAheadDecompressor::ReadThread()
+{
+  const uint64_t numBlocks = ARRAY_COUNT(m_Blocks);
+
+  uint64_t remaining = m_Size;
+
+  while(remaining > 0 && !m_Shutdown)
+  {
+    uint64_t idx;
+
+    {
+      SCOPED_LOCK(m_Lock);
+      idx = m_Filled;
+
+      // wait until the reader has freed up a block
+      if(m_Filled - m_Consumed >= numBlocks)
+        idx = ~0ULL;
+    }
+
+    if(idx == ~0ULL)
+    {
+      m_FreeSem->WaitForWake(10);
+      continue;
+    }
+
+    Block &b = m_Blocks[idx % numBlocks];
+
+    b.size = RDCMIN(remaining, readAheadBlockSize);
+
+    bool success = m_Read->Read(b.data, b.size);
+
+    {
+      SCOPED_LOCK(m_Lock);
+      if(success)
+        m_Filled++;
+      else
+        m_Error = true;
+    }
+
+    m_FilledSem->Wake();
+
+    if(!success)
+      return;
+
+    remaining -= b.size;
+  }
+
+  {
+    SCOPED_LOCK(m_Lock);
+    m_Finished = true;
+  }
+
+  m_FilledSem->Wake();
+}
+
+bool ReadAheadDecompressor::Recompress(Compressor *comp)
+{
+  bool success = true;
+
+  byte *buf = AllocAlignedBuffer(readAheadBlockSize);
+
+  uint64_t remaining = m_Size;
+
+  while(success && remaining > 0)
+  {
+    uint64_t size = RDCMIN(remaining, readAheadBlockSize);
+
+    success &= Read(buf, size);
+    if(success)
+      success &= comp->Write(buf, size);
+
+    remaining -= size;
+  }
+  success &= comp->Finish();
+
+  FreeAlignedBuffer(buf);
+
+  return success;
+}
+
+bool ReadAheadDecompressor::Read(void *data, uint64_t numBytes)
+{
+  const uint64_t numBlocks = ARRAY_COUNT(m_Blocks);
+
+  byte *dst = (byte *)data;
+
+  while(numBytes > 0)
+  {
+    bool available = false;
+
+    {
+      SCOPED_LOCK(m_Lock);
+
+      if(m_Filled > m_Consumed)
+        available = true;
+      else if(m_Error || m_Finished)
+        return false;
+    }
+
+    if(!available)
+    {
+      m_FilledSem->WaitForWake(10);
+      continue;
+    }
+
+    // only this thread consumes blocks, so the oldest filled one stays put until we release it
+    const Block &b = m_Blocks[m_Consumed % numBlocks];
+
+    uint64_t size = RDCMIN(numBytes, b.size - m_BlockOffset);
+
+    if(dst)
+    {
+      memcpy(dst, b.data + m_BlockOffset, (size_t)size);
+      dst += size;
+    }
+
+    numBytes -= size;
+    m_BlockOffset += size;
+
+    if(m_BlockOffset == b.size)
+    {
+      m_BlockOffset = 0;
+
+      {
+        SCOPED_LOCK(m_Lock);
+        m_Consumed++;
+      }
+
+      m_FreeSem->Wake();
+    }
+  }
+
+  return true;
+}
+
 StreamWriter::StreamWriter(StreamInvalidType)
 {
   m_BufferBase = m_BufferHead = m_BufferEnd = NULL;
@@ -248,6 +248,49 @@ private:
   std::vector<StreamCloseCallback> m_Callbacks;
 };
 
+// reads another stream on a worker thread, staying a few blocks ahead of what has been consumed.
+// This lets decompression and file I/O overlap with whatever is processing the data.
+class ReadAheadDecompressor : public Decompressor
+{
+public:
+  ReadAheadDecompressor(StreamReader *read, Ownership own);
+  ~ReadAheadDecompressor();
+
+  bool Recompress(Compressor *comp);
+  bool Read(void *data, uint64_t numBytes);
+
+private:
+  void ReadThread();
+
+  struct Block
+  {
+    byte *data = NULL;
+    uint64_t size = 0;
+  };
+
+  Block m_Blocks[8];
+
+  // total number of bytes that will be read from the source stream
+  uint64_t m_Size = 0;
+
+  // number of blocks the worker has filled, and the number the reader has finished with. Both only
+  // increase, and are protected by m_Lock
+  uint64_t m_Filled = 0;
+  uint64_t m_Consumed = 0;
+  bool m_Finished = false;
+  bool m_Error = false;
+
+  // offset into the oldest filled block that hasn't been read yet
+  uint64_t m_BlockOffset = 0;
+
+  volatile bool m_Shutdown = false;
+
+  Threading::CriticalSection m_Lock;
+  Threading::Semaphore *m_FilledSem = NULL;
+  Threading::Semaphore *m_FreeSem = NULL;
+  Threading::ThreadHandle m_Thread = 0;
+};
+
 class StreamWriter
 {
 public:
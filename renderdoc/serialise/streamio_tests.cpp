@@ -94,6 +94,50 @@ TEST_CASE("Test basic stream I/O operations", "[streamio]")
   CHECK(reader.IsErrored());
 };
 
+TEST_CASE("Test reading ahead on a worker thread", "[streamio]")
+{
+  // several read-ahead blocks, not a multiple of the block size
+  const size_t size = 12 * 1024 * 1024 + 123;
+  byte *data = new byte[size];
+
+  for(size_t i = 0; i < size; i++)
+    data[i] = byte((i * 7 + i / 1024) & 0xff);
+
+  {
+    StreamReader reader(new ReadAheadDecompressor(new StreamReader(data, size), Ownership::Stream),
+                        size, Ownership::Stream);
+
+    byte *readData = new byte[size];
+
+    // mix small reads, skips and reads that span several blocks
+    reader.Read(readData, 10);
+    reader.SkipBytes(1000);
+    reader.Read(readData + 1010, 3 * 1024 * 1024);
+    reader.Read(readData + 1010 + 3 * 1024 * 1024, size - 1010 - 3 * 1024 * 1024);
+
+    CHECK_FALSE(memcmp(readData, data, 10));
+    CHECK_FALSE(memcmp(readData + 1010, data + 1010, size - 1010));
+
+    CHECK_FALSE(reader.IsErrored());
+    CHECK(reader.AtEnd());
+
+    delete[] readData;
+  }
+
+  // destroying the reader before everything has been read should stop the worker cleanly
+  {
+    StreamReader reader(new ReadAheadDecompressor(new StreamReader(data, size), Ownership::Stream),
+                        size, Ownership::Stream);
+
+    uint32_t test = 0;
+    reader.Read(test);
+
+    CHECK(test == *(uint32_t *)data);
+  }
+
+  delete[] data;
+};
+
 TEST_CASE("Test stream I/O operations over the network", "[streamio][network]")
 {
   uint16_t port = 8235;
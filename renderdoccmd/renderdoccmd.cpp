@@ -1281,6 +1281,8 @@ int renderdoccmd(const GlobalEnvironment &env, std::vector<std::string> &argv)
               "Capturing Option: Include all live resources, not just those used by a frame.");
       cmd.add("opt-capture-all-cmd-lists", 0,
               "Capturing Option: In D3D11, record all command lists from application start.");
+      cmd.add("opt-combine-multi-frame-captures", 0,
+              "Capturing Option: Record consecutive captured frames into a single capture.");
     }
 
     cmd.parse_check(argv, true);
@@ -1310,6 +1312,8 @@ int renderdoccmd(const GlobalEnvironment &env, std::vector<std::string> &argv)
         opts.refAllResources = true;
       if(cmd.exist("opt-capture-all-cmd-lists"))
         opts.captureAllCmdLists = true;
+      if(cmd.exist("opt-combine-multi-frame-captures"))
+        opts.combineMultiFrameCaptures = true;
 
       opts.delayForDebugger = (uint32_t)cmd.get<int>("opt-delay-for-debugger");
     }